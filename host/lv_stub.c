@@ -0,0 +1,80 @@
+/* No-op stand-ins for the LVGL calls the run and report tabs make
+ * Lets the UI code that runs every tick (view cache, run speeds, report
+ * rows) link on the host so its own cost can be measured. Nothing is drawn,
+ * so LVGL's invalidation and redraw cost is not included.
+ */
+#include "api.h"
+#include "styles.h"
+
+/* Objects handed out round robin, only hidden and free_num are kept */
+#define LV_STUB_OBJS 256
+static lv_obj_t lv_stub_objs[LV_STUB_OBJS];
+static int lv_stub_next = 0;
+
+/* Last task created, so a caller can run it by hand */
+void (*lv_stub_task)(void *) = NULL;
+void * lv_stub_task_param = NULL;
+
+/* Styles and icons, never looked at */
+lv_style_t style_grn_ina, style_grn_act;
+lv_style_t style_red_ina, style_red_act;
+lv_style_t style_blu_ina, style_blu_act;
+lv_style_t style_dis;
+lv_style_t style_page;
+const lv_img_dsc_t mdi_power;
+const lv_img_dsc_t mdi_arrow_down_bold;
+const lv_img_dsc_t mdi_arrow_up_bold;
+const lv_img_dsc_t mdi_play_circle;
+const lv_img_dsc_t mdi_speedometer;
+
+
+static lv_obj_t * lv_stub_obj()
+{
+    lv_obj_t * obj = &lv_stub_objs[lv_stub_next++ % LV_STUB_OBJS];
+    obj->hidden = 0;
+    obj->free_num = 0;
+    return obj;
+}
+
+lv_obj_t * lv_btn_create(lv_obj_t * par, const lv_obj_t * copy) { return lv_stub_obj(); }
+lv_obj_t * lv_btnm_create(lv_obj_t * par, const lv_obj_t * copy) { return lv_stub_obj(); }
+lv_obj_t * lv_cont_create(lv_obj_t * par, const lv_obj_t * copy) { return lv_stub_obj(); }
+lv_obj_t * lv_img_create(lv_obj_t * par, const lv_obj_t * copy) { return lv_stub_obj(); }
+lv_obj_t * lv_label_create(lv_obj_t * par, const lv_obj_t * copy) { return lv_stub_obj(); }
+lv_obj_t * lv_page_create(lv_obj_t * par, const lv_obj_t * copy) { return lv_stub_obj(); }
+lv_obj_t * lv_page_get_scrl(const lv_obj_t * page) { return (lv_obj_t *)page; }
+
+void lv_btn_set_action(lv_obj_t * btn, lv_btn_action_t type, lv_action_t action) {}
+void lv_btn_set_style(lv_obj_t * btn, lv_btn_style_t type, lv_style_t * style) {}
+void lv_btnm_set_action(lv_obj_t * btnm, lv_btnm_action_t action) {}
+void lv_btnm_set_map(lv_obj_t * btnm, const char ** map) {}
+void lv_btnm_set_style(lv_obj_t * btnm, lv_btnm_style_t type, lv_style_t * style) {}
+void lv_btnm_set_toggle(lv_obj_t * btnm, bool en, uint16_t id) {}
+void lv_cont_set_layout(lv_obj_t * cont, lv_layout_t layout) {}
+void lv_img_set_src(lv_obj_t * img, const void * src_img) {}
+void lv_label_set_long_mode(lv_obj_t * label, lv_label_long_mode_t long_mode) {}
+void lv_label_set_text(lv_obj_t * label, const char * text) {}
+void lv_obj_align(lv_obj_t * obj, const lv_obj_t * base, lv_align_t align, lv_coord_t x_mod, lv_coord_t y_mod) {}
+void lv_obj_set_size(lv_obj_t * obj, lv_coord_t w, lv_coord_t h) {}
+void lv_obj_set_style(lv_obj_t * obj, lv_style_t * style) {}
+void lv_obj_set_width(lv_obj_t * obj, lv_coord_t w) {}
+void lv_page_clean(lv_obj_t * obj) {}
+
+char * lv_label_get_text(const lv_obj_t * label)
+{
+    static char empty[] = "";
+    return empty;
+}
+
+void lv_obj_set_hidden(lv_obj_t * obj, bool en) { obj->hidden = en; }
+bool lv_obj_get_hidden(const lv_obj_t * obj) { return obj->hidden; }
+void lv_obj_set_free_num(lv_obj_t * obj, LV_OBJ_FREE_NUM_TYPE free_num) { obj->free_num = free_num; }
+LV_OBJ_FREE_NUM_TYPE lv_obj_get_free_num(const lv_obj_t * obj) { return obj->free_num; }
+
+lv_task_t * lv_task_create(void (*task)(void *), uint32_t period, lv_task_prio_t prio, void * param)
+{
+    static lv_task_t lv_stub_task_obj;
+    lv_stub_task = task;
+    lv_stub_task_param = param;
+    return &lv_stub_task_obj;
+}
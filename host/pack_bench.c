@@ -0,0 +1,255 @@
+/* Host benchmark for telemetry compression
+ *
+ * pack_bench [seconds]
+ *      Generate synthetic V5 flywheel telemetry for 4 motors at 50 Hz, then measure
+ *      bytes per sample and encode/decode cost for raw frames and packed blocks
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "frame.h"
+#include "pack.h"
+#include "telem.h"
+
+#define MOTORS 4
+#define TICK_MS 20
+
+/* Deterministic noise */
+static uint32_t rng = 12345;
+static double noise(double amp)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return ((double)(rng % 20001) / 10000.0 - 1.0) * amp;
+}
+
+/* Synthetic session: spin up, hold with a shot every 2 s, spin down, repeat
+ * Noise and quantization follow what the V5 motor reports
+ */
+static void generate(telem_rec_t * out, int ticks)
+{
+    double speed[MOTORS] = {0}, temp[MOTORS] = {25, 26, 25, 27};
+    for(int t = 0; t < ticks; t++)
+    {
+        double sec = t * TICK_MS / 1000.0;
+        double cycle = fmod(sec,30.0);
+        bool powered = cycle < 25.0;
+        bool shot = powered && cycle > 3.0 && fmod(cycle,2.0) < TICK_MS / 1000.0;
+        for(int m = 0; m < MOTORS; m++)
+        {
+            telem_rec_t * r = &out[t * MOTORS + m];
+            double target = powered ? 600 : 0;
+            /* First order response plus shot impact */
+            speed[m] += (target - speed[m]) * 0.08;
+            if(shot) speed[m] *= 0.85;
+            double err = target - speed[m];
+            double curr = powered ? fmin(2.5,0.35 + fabs(err) * 0.02) : 0.0;
+            double volt = powered ? fmin(12.0,speed[m] / 600.0 * 11.0 + curr * 0.6) : 0.0;
+            temp[m] += curr * curr * 0.0005 - (temp[m] - 25) * 0.0002;
+
+            r->idx = m;
+            r->flags = powered ? TELEM_FLAG_POWERED : 0;
+            r->ch[TELEM_CH_TARGET] = (int32_t)target;
+            r->ch[TELEM_CH_SPEED] = (int32_t)lround((speed[m] + noise(1.5)) * 10.0);
+            r->ch[TELEM_CH_CURR] = powered ? (int32_t)lround(curr * 1000.0 + noise(15)) : 0;
+            r->ch[TELEM_CH_VOLT] = powered ? (int32_t)lround(volt * 1000.0 + noise(40)) : 0;
+            r->ch[TELEM_CH_POWER] = (int32_t)lround(fabs((double)r->ch[TELEM_CH_CURR] * r->ch[TELEM_CH_VOLT]) / 10000.0);
+            /* Motor reports temperature in 5 degree steps */
+            r->ch[TELEM_CH_TEMP] = (int32_t)(floor(temp[m] / 5.0) * 50.0);
+        }
+    }
+}
+
+/* Records match, field by field since the struct has padding */
+static bool rec_same(const telem_rec_t * a, const telem_rec_t * b, int n)
+{
+    for(int r = 0; r < n; r++)
+    {
+        if(a[r].idx != b[r].idx || a[r].flags != b[r].flags || memcmp(a[r].ch,b[r].ch,sizeof(a[r].ch)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Motor C drops out over a keyframe and comes back, as after a lost cable or a
+ * hot-plug. A receiver that joins at that keyframe, with stale state for C, must
+ * still decode C exactly once it returns. Returns the number of bad ticks.
+ */
+static long check_gap(const telem_rec_t * recs, int ticks)
+{
+    int join = TELEM_KEY_TICKS;
+    int gap_start = join - 10, gap_end = join + 20;
+    if(ticks < gap_end + 10)
+    {
+        return 0;
+    }
+    uint8_t buf[PACK_TICK_MAX];
+    pack_ctx_t enc, dec;
+    pack_reset(&enc);
+    pack_reset(&dec);
+    for(int m = 0; m < PACK_MAX_MOTORS; m++)
+    {
+        dec.motor[m].ch[0] = 12345;
+    }
+    long bad = 0;
+    for(int t = 0; t < gap_end + 10; t++)
+    {
+        /* This tick's records without C while it is gone */
+        telem_rec_t in[MOTORS], out[PACK_MAX_MOTORS];
+        uint8_t n = 0;
+        for(int m = 0; m < MOTORS; m++)
+        {
+            if(m != 2 || t < gap_start || t >= gap_end)
+            {
+                in[n++] = recs[t * MOTORS + m];
+            }
+        }
+        size_t len = pack_tick(&enc,buf,t * TICK_MS,in,n,!(t % TELEM_KEY_TICKS));
+        if(t < join)
+        {
+            continue;
+        }
+        uint8_t count;
+        uint32_t time;
+        if(pack_untick(&dec,buf,len,&time,out,&count) != (int)len || count != n ||
+           !rec_same(out,in,n))
+        {
+            bad++;
+        }
+    }
+    return bad;
+}
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(int argc, char ** argv)
+{
+    int seconds = argc > 1 ? atoi(argv[1]) : 3600;
+    int ticks = seconds * 1000 / TICK_MS;
+    long samples = (long)ticks * MOTORS;
+    telem_rec_t * recs = malloc(sizeof(telem_rec_t) * samples);
+    uint8_t * packed = malloc((size_t)ticks * PACK_TICK_MAX);
+    generate(recs,ticks);
+
+    /* Raw: one framed TELEM_FRAME_SAMPLE per tick, as with TELEM_PACK 0 */
+    double t0 = now_ns();
+    size_t raw_framed = 0;
+    uint8_t payload[FRAME_MAX_PAYLOAD], enc[FRAME_MAX_ENCODED];
+    for(int t = 0; t < ticks; t++)
+    {
+        uint8_t * p = payload + TELEM_HDR_SIZE;
+        memset(payload,0,TELEM_HDR_SIZE);
+        for(int m = 0; m < MOTORS; m++)
+        {
+            const telem_rec_t * r = &recs[t * MOTORS + m];
+            *p++ = r->idx;
+            *p++ = r->flags;
+            for(int i = 0; i < TELEM_CH_COUNT; i++) p = frame_put_u32(p,(uint32_t)r->ch[i]);
+        }
+        raw_framed += frame_encode(payload,p - payload,enc);
+    }
+    double raw_ns = now_ns() - t0;
+
+    /* Packed: tick stream only, keyframe every TELEM_KEY_TICKS */
+    pack_ctx_t ctx;
+    pack_reset(&ctx);
+    size_t packed_len = 0;
+    t0 = now_ns();
+    for(int t = 0; t < ticks; t++)
+    {
+        packed_len += pack_tick(&ctx,&packed[packed_len],t * TICK_MS,&recs[t * MOTORS],MOTORS,!(t % TELEM_KEY_TICKS));
+    }
+    double enc_ns = now_ns() - t0;
+
+    /* Decode and verify */
+    pack_reset(&ctx);
+    size_t pos = 0;
+    long bad = 0;
+    t0 = now_ns();
+    for(int t = 0; t < ticks; t++)
+    {
+        telem_rec_t out[PACK_MAX_MOTORS];
+        uint8_t count;
+        uint32_t time;
+        int used = pack_untick(&ctx,&packed[pos],packed_len - pos,&time,out,&count);
+        if(used < 0 || count != MOTORS || time != (uint32_t)(t * TICK_MS))
+        {
+            bad++;
+            break;
+        }
+        pos += used;
+        bad += !rec_same(out,&recs[t * MOTORS],MOTORS);
+    }
+    double dec_ns = now_ns() - t0;
+    long gap_bad = check_gap(recs,ticks);
+
+    /* Packed as sent: blocks of TELEM_PACK_TICKS (serial) or as many ticks as fit (SD-style) */
+    size_t framed[2] = {0, 0};
+    for(int mode = 0; mode < 2; mode++)
+    {
+        pack_reset(&ctx);
+        size_t len = 0;
+        int blk = 0;
+        for(int t = 0; t < ticks; t++)
+        {
+            bool key = !(t % TELEM_KEY_TICKS);
+            if(key && len)
+            {
+                framed[mode] += frame_encode(payload,len,enc);
+                len = 0;
+            }
+            if(!len)
+            {
+                len = TELEM_HDR_SIZE;
+                blk = 0;
+            }
+            len += pack_tick(&ctx,&payload[len],t * TICK_MS,&recs[t * MOTORS],MOTORS,key);
+            blk++;
+            if((mode == 0 && blk >= TELEM_PACK_TICKS) || len + 6 + MOTORS * PACK_REC_MAX > FRAME_MAX_PAYLOAD)
+            {
+                framed[mode] += frame_encode(payload,len,enc);
+                len = 0;
+            }
+        }
+        if(len) framed[mode] += frame_encode(payload,len,enc);
+    }
+
+    /* Text, as telem_rx prints it */
+    size_t text = 0;
+    for(long s = 0; s < samples; s += 97)
+    {
+        char line[128];
+        const telem_rec_t * r = &recs[s];
+        text += snprintf(line,sizeof(line),"T,%u,%c,%d,%g,%g,%g,%g,%g,%g\n",(unsigned)(s / MOTORS * TICK_MS),'A' + r->idx,r->flags,
+                         r->ch[0] * telem_ch_scale[0],r->ch[1] * telem_ch_scale[1],r->ch[2] * telem_ch_scale[2],
+                         r->ch[3] * telem_ch_scale[3],r->ch[4] * telem_ch_scale[4],r->ch[5] * telem_ch_scale[5]) * 97;
+    }
+
+    double raw_rec = TELEM_REC_SIZE;
+    printf("pack_bench: %d s, %d motors at %d ms, %ld samples, keyframe every %d ticks\n",seconds,MOTORS,TICK_MS,samples,TELEM_KEY_TICKS);
+    printf("%-34s %10s %8s\n","format","bytes/smp","ratio");
+    printf("%-34s %10.2f %8.2f\n","CSV text (telem_rx output)",(double)text / samples,raw_rec / ((double)text / samples));
+    printf("%-34s %10.2f %8.2f\n","raw record",raw_rec,1.0);
+    printf("%-34s %10.2f %8.2f\n","raw frame per tick",(double)raw_framed / samples,raw_rec / ((double)raw_framed / samples));
+    printf("%-34s %10.2f %8.2f\n","packed ticks (no framing)",(double)packed_len / samples,raw_rec / ((double)packed_len / samples));
+    printf("%-34s %10.2f %8.2f\n","packed serial blocks (framed)",(double)framed[0] / samples,(double)raw_framed / framed[0]);
+    printf("%-34s %10.2f %8.2f\n","packed SD blocks (framed)",(double)framed[1] / samples,(double)raw_framed / framed[1]);
+    printf("encode raw frame %.1f ns/smp, pack %.1f ns/smp, unpack %.1f ns/smp\n",raw_ns / samples,enc_ns / samples,dec_ns / samples);
+    printf("round trip %s, motor returning after a gap %s\n",bad ? "FAILED" : "ok",gap_bad ? "FAILED" : "ok");
+
+    free(recs);
+    free(packed);
+    return (bad || gap_bad) ? 1 : 0;
+}
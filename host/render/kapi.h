@@ -0,0 +1,12 @@
+/* Host stand-in for the kernel header lv_conf.h names for LVGL's allocator,
+ * kmalloc and kfree are render_bench's counting allocator
+ */
+#ifndef _RENDER_KAPI_H_
+#define _RENDER_KAPI_H_
+
+#include <stddef.h>
+
+void * kmalloc(size_t size);
+void kfree(void * ptr);
+
+#endif /* _RENDER_KAPI_H_ */
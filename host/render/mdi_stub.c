@@ -0,0 +1,53 @@
+/* Stand-ins for the v5mdi.a icons, which are built for the brain
+ * Same size and format as the real ones (1 bit alpha, 24 or 48 px square) so
+ * they cost the same to draw, the shape is a filled circle.
+ */
+#include "api.h"
+
+static uint8_t mdi_stub_24[24 * 24 / 8];
+static uint8_t mdi_stub_48[48 * 48 / 8];
+
+#define MDI_STUB(name,px) \
+    const lv_img_dsc_t name = {.header = {.cf = LV_IMG_CF_ALPHA_1BIT, .w = px, .h = px}, \
+                               .data_size = px * px / 8, .data = mdi_stub_##px}
+
+MDI_STUB(mdi_account_multiple_plus,24);
+MDI_STUB(mdi_arrow_down_bold,24);
+MDI_STUB(mdi_arrow_up_bold,24);
+MDI_STUB(mdi_cog,24);
+MDI_STUB(mdi_play_circle,24);
+MDI_STUB(mdi_power,24);
+MDI_STUB(mdi_power_plug,24);
+MDI_STUB(mdi_reload,24);
+MDI_STUB(mdi_restore,24);
+MDI_STUB(mdi_speedometer,24);
+MDI_STUB(mdi_speedometer_medium,24);
+MDI_STUB(mdi_speedometer_slow,24);
+MDI_STUB(mdi_clipboard_pulse_outline_48px,48);
+MDI_STUB(mdi_cog_48px,48);
+MDI_STUB(mdi_power_48px,48);
+MDI_STUB(mdi_sine_wave_48px,48);
+
+
+/* Fill a circle into a 1 bit map, rows are whole bytes, MSB first */
+static void mdi_stub_circle(uint8_t * map, int px)
+{
+    int r = px / 2 - 1;
+    for(int y = 0; y < px; y++)
+    {
+        for(int x = 0; x < px; x++)
+        {
+            int dx = x - px / 2, dy = y - px / 2;
+            if(dx * dx + dy * dy <= r * r)
+            {
+                map[y * (px / 8) + x / 8] |= 0x80 >> (x % 8);
+            }
+        }
+    }
+}
+
+void mdi_stub_init()
+{
+    mdi_stub_circle(mdi_stub_24,24);
+    mdi_stub_circle(mdi_stub_48,48);
+}
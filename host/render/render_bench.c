@@ -0,0 +1,404 @@
+/* Headless render benchmark for the tabs
+ *
+ * render_bench [-p dir]
+ *      Runs the sidebar and the config, run, log and test tabs on LVGL with an
+ *      in-memory framebuffer, a mock tick and a scripted touch input, through
+ *      the update patterns the brain sees: boot, the first and later visit to
+ *      each tab, run tab speeds at the control rate, the strip chart, report
+ *      lines, config changes and the profiler overlay. For each case prints the
+ *      frames drawn, the time of the task handler pass that drew each frame
+ *      (median and max, host wall clock), the pixels redrawn per frame, and the
+ *      LVGL heap held at the end and its peak during the case.
+ *      -p writes the framebuffer after each case to dir/<case>.ppm.
+ *
+ * Needs the LVGL 5.3 sources as PROS builds them (src/display in the PROS
+ * kernel), see LVGL_DIR in the Makefile, and uses the app's own lv_conf.h.
+ * LVGL allocates through kmalloc (render/kapi.h), which counts the bytes held.
+ * The icons are stand-ins of the real sizes (mdi_stub.c). Times are the host's,
+ * compare them between layouts rather than with the brain.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "main.h"
+
+/* Use pal log, for the level names */
+#include "pal/log.h"
+
+/* Graphics task step and control tick (ms) */
+#define RENDER_STEP_MS 2
+#define RENDER_TICK_MS 20
+/* Frames kept per case for the median */
+#define RENDER_FRAMES_MAX 4096
+
+/* Time step, as main.c sets it */
+double dt = RENDER_TICK_MS / 1000.0;
+
+/* Framebuffer the display driver writes */
+static lv_color_t render_fb[LV_VER_RES][LV_HOR_RES];
+
+/* Mock clock */
+static uint32_t render_ms = 0;
+
+/* Scripted touch */
+static lv_point_t render_point;
+static bool render_pressed = false;
+
+/* Refresh monitor */
+static uint32_t render_frames = 0;
+static uint32_t render_px = 0;
+
+/* LVGL heap, through kmalloc */
+static size_t render_heap = 0;
+static size_t render_heap_peak = 0;
+
+/* Frames of the case being measured */
+static double render_frame_ns[RENDER_FRAMES_MAX];
+static int render_nframes = 0;
+static const char * render_ppm_dir = NULL;
+
+void mdi_stub_init();
+
+
+/* Allocator lv_conf.h names, each block carries its size */
+typedef union
+{
+    size_t size;
+    max_align_t align;
+} render_blk_t;
+
+void * kmalloc(size_t size)
+{
+    render_blk_t * blk = malloc(sizeof(render_blk_t) + size);
+    if(!blk)
+    {
+        return NULL;
+    }
+    blk->size = size;
+    render_heap += size;
+    if(render_heap > render_heap_peak) render_heap_peak = render_heap;
+    return blk + 1;
+}
+
+void kfree(void * ptr)
+{
+    if(!ptr)
+    {
+        return;
+    }
+    render_blk_t * blk = (render_blk_t *)ptr - 1;
+    render_heap -= blk->size;
+    free(blk);
+}
+
+/* PROS and the rest of the app, out of the measurement */
+uint32_t millis(void) { return render_ms; }
+uint64_t micros(void) { return (uint64_t)render_ms * 1000; }
+FILE * fd = NULL;
+volatile log_level_t log_level_runtime = LOG_LEVEL_DEBUG;
+int log_check(const char * fname, const int line, log_level_t level, log_level_t flevel) { return 0; }
+bool msg_ctrl_post(msg_ctrl_type_t type, uint8_t motor, int16_t arg) { return true; }
+void taskmon_format(char * out, size_t size) { snprintf(out,size,"Task monitor not on the host"); }
+motor_t motors[NUM_MOTORS];
+
+
+/* Display driver, copies the VDB into the framebuffer */
+static void render_flush(int32_t x1, int32_t y1, int32_t x2, int32_t y2, const lv_color_t * color_p)
+{
+    for(int32_t y = y1; y <= y2; y++)
+    {
+        memcpy(&render_fb[y][x1],color_p,(x2 - x1 + 1) * sizeof(lv_color_t));
+        color_p += x2 - x1 + 1;
+    }
+    lv_flush_ready();
+}
+
+/* Touch driver, reads the scripted point */
+static bool render_read(lv_indev_data_t * data)
+{
+    data->point = render_point;
+    data->state = render_pressed ? LV_INDEV_STATE_PR : LV_INDEV_STATE_REL;
+    return false;
+}
+
+static void render_monitor(uint32_t time_ms, uint32_t px)
+{
+    render_frames++;
+    render_px += px;
+}
+
+static double render_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Run the graphics task for ms, with a control tick every RENDER_TICK_MS */
+static void render_wait(uint32_t ms, void (*ctrl)(uint32_t n))
+{
+    static uint32_t tick = 0;
+    for(uint32_t t = 0; t < ms; t += RENDER_STEP_MS)
+    {
+        lv_tick_inc(RENDER_STEP_MS);
+        render_ms += RENDER_STEP_MS;
+        if(ctrl && !(render_ms % RENDER_TICK_MS))
+        {
+            ctrl(tick++);
+        }
+
+        uint32_t frames = render_frames;
+        double t0 = render_now_ns();
+        lv_task_handler();
+        double ns = render_now_ns() - t0;
+        if(render_frames != frames && render_nframes < RENDER_FRAMES_MAX)
+        {
+            render_frame_ns[render_nframes++] = ns;
+        }
+    }
+}
+
+/* Tap a point, long enough for the input device to read the press and the release */
+static void render_touch(lv_coord_t x, lv_coord_t y, void (*ctrl)(uint32_t n))
+{
+    render_point.x = x;
+    render_point.y = y;
+    render_pressed = true;
+    render_wait(2 * LV_INDEV_READ_PERIOD,ctrl);
+    render_pressed = false;
+    render_wait(2 * LV_INDEV_READ_PERIOD,ctrl);
+}
+
+/* Sidebar button of a tab */
+static void render_tab(int idx, void (*ctrl)(uint32_t n))
+{
+    render_touch(LV_HOR_RES - SIDEBAR_WIDTH / 2,SIDEBAR_WIDTH / 2 + idx * SIDEBAR_WIDTH,ctrl);
+}
+
+static void render_ppm(const char * name)
+{
+    char path[256];
+    snprintf(path,sizeof(path),"%s/%s.ppm",render_ppm_dir,name);
+    FILE * out = fopen(path,"wb");
+    if(!out)
+    {
+        perror(path);
+        return;
+    }
+    fprintf(out,"P6\n%d %d\n255\n",LV_HOR_RES,LV_VER_RES);
+    for(int y = 0; y < LV_VER_RES; y++)
+    {
+        for(int x = 0; x < LV_HOR_RES; x++)
+        {
+            fputc(render_fb[y][x].red,out);
+            fputc(render_fb[y][x].green,out);
+            fputc(render_fb[y][x].blue,out);
+        }
+    }
+    fclose(out);
+}
+
+static int render_cmp(const void * a, const void * b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Start measuring a case */
+static void render_begin()
+{
+    render_nframes = 0;
+    render_px = 0;
+    render_heap_peak = render_heap;
+}
+
+/* Print the case measured since render_begin() */
+static void render_end(const char * name)
+{
+    double med = 0, max = 0;
+    if(render_nframes)
+    {
+        qsort(render_frame_ns,render_nframes,sizeof(double),render_cmp);
+        med = render_frame_ns[render_nframes / 2];
+        max = render_frame_ns[render_nframes - 1];
+    }
+    uint32_t objs = 0, bytes = 0;
+    uiprof_tree(lv_scr_act(),&objs,&bytes);
+    printf("%-16s %6d %9.3f %9.3f %9d %8.1f %8.1f %6d\n",name,render_nframes,med / 1e6,max / 1e6,
+           render_nframes ? (int)(render_px / render_nframes) : 0,
+           render_heap / 1024.0,render_heap_peak / 1024.0,(int)objs);
+    if(render_ppm_dir)
+    {
+        render_ppm(name);
+    }
+}
+
+/* Control ticks of the cases, each as the control and graphics tasks would see it */
+static void ctrl_speeds(uint32_t n)
+{
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        int speed = 560 + (int)((n * 7 + i * 13) % 80);
+        motors[i].data.speed = speed;
+        run_update_speeds(i,motors[i].target,speed);
+    }
+}
+
+static void ctrl_speeds_same(uint32_t n)
+{
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        run_update_speeds(i,motors[i].target,590);
+    }
+}
+
+static void ctrl_plot(uint32_t n)
+{
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        motors[i].data.speed = 300 + 290 * ((n + i * 25) % 100) / 100.0;
+        motors[i].data.curr = 0.5 + ((n + i) % 50) * 0.04;
+        motors[i].data.power = motors[i].data.curr * 11.0;
+    }
+    plot_tick();
+}
+
+static void ctrl_report(uint32_t n)
+{
+    if(n % 5)
+    {
+        return;
+    }
+    char line[64];
+    snprintf(line,sizeof(line),"MTR %c: Shot Complete, Took %1.2f sec",'A' + (int)(n / 5) % NUM_MOTORS,(n % 100) * 0.01);
+    report_print(line);
+}
+
+static void ctrl_config(uint32_t n)
+{
+    if(n % 25)
+    {
+        return;
+    }
+    /* What the graphics task does on MSG_UI_CONFIG after the control task changed the motor */
+    int i = (n / 25) % NUM_MOTORS;
+    motors[i].reversed = !motors[i].reversed;
+    motors[i].gearset = (motors[i].gearset + 1) % 3;
+    config_update(i);
+}
+
+/* Tabs, as on the sidebar */
+enum { TAB_CONFIG, TAB_RUN, TAB_LOG, TAB_TEST };
+
+int main(int argc, char ** argv)
+{
+    int opt;
+    while((opt = getopt(argc,argv,"p:")) != -1)
+    {
+        if('p' == opt)
+        {
+            render_ppm_dir = optarg;
+        }
+        else
+        {
+            fprintf(stderr,"usage: %s [-p dir]\n",argv[0]);
+            return 2;
+        }
+    }
+
+    /* Four motors on ports 1-4, B follows A */
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        motors[i].idx = i;
+        motors[i].port = i + 1;
+        motors[i].leader = -1;
+        motors[i].gearset = E_MOTOR_GEARSET_06;
+        motors[i].target = 600;
+        motors[i].powered = (i < 2);
+        motors[i].data.valid = true;
+    }
+    motors[1].leader = 0;
+
+    /* LVGL with the framebuffer and touch drivers, as the PROS display task sets it up */
+    mdi_stub_init();
+    lv_init();
+    lv_disp_drv_t disp;
+    lv_disp_drv_init(&disp);
+    disp.disp_flush = render_flush;
+    lv_disp_drv_register(&disp);
+    lv_indev_drv_t indev;
+    lv_indev_drv_init(&indev);
+    indev.type = LV_INDEV_TYPE_POINTER;
+    indev.read = render_read;
+    lv_indev_drv_register(&indev);
+
+    printf("%-16s %6s %9s %9s %9s %8s %8s %6s\n","case","frames","ms/frame","max","px/frame","heap kB","peak kB","objs");
+
+    /* Boot, the overlay task is started but reports to us */
+    render_begin();
+    style_init();
+    uiprof_init();
+    lv_refr_set_monitor_cb(render_monitor);
+    double t0 = render_now_ns();
+    sidebar_init();
+    render_frame_ns[render_nframes++] = render_now_ns() - t0;
+    render_wait(500,NULL);
+    render_end("boot");
+
+    /* First visits draw the tab, later ones only redraw it */
+    render_begin();
+    render_tab(TAB_RUN,NULL);
+    render_end("run_first");
+    render_begin();
+    render_tab(TAB_LOG,NULL);
+    render_end("log_first");
+    render_begin();
+    render_tab(TAB_TEST,NULL);
+    render_end("test_first");
+    render_begin();
+    render_tab(TAB_CONFIG,NULL);
+    render_end("config_again");
+    render_begin();
+    render_tab(TAB_RUN,NULL);
+    render_end("run_again");
+
+    /* Updates on the visible tab */
+    render_begin();
+    render_wait(3000,ctrl_speeds);
+    render_end("run_speeds");
+    render_begin();
+    render_wait(3000,ctrl_speeds_same);
+    render_end("run_speeds_same");
+
+    render_tab(TAB_LOG,NULL);
+    render_begin();
+    render_wait(5000,ctrl_plot);
+    render_end("log_chart");
+
+    render_tab(TAB_TEST,NULL);
+    render_begin();
+    render_wait(3000,ctrl_report);
+    render_end("test_report");
+
+    render_tab(TAB_CONFIG,NULL);
+    render_begin();
+    render_wait(3000,ctrl_config);
+    render_end("config_changes");
+
+    /* Overlay over the run tab while it updates, then hidden again */
+    render_tab(TAB_RUN,NULL);
+    uiprof_toggle();
+    render_begin();
+    render_wait(3000,ctrl_speeds);
+    render_end("overlay_speeds");
+    uiprof_toggle();
+    uiprof_toggle();
+    uiprof_toggle();
+    render_begin();
+    render_wait(500,NULL);
+    render_end("overlay_hidden");
+    return 0;
+}
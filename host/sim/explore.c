@@ -0,0 +1,437 @@
+/* Flywheel design explorer
+ * Sweeps flywheel mass and radius, cartridge, external ratio, motor count
+ * and controller over the sim's motor and flywheel plant. Each design is run
+ * as a number of Monte-Carlo trials (ball mass, contact time and friction
+ * varied) of a spinup from rest followed by a string of shots, and designs
+ * are ranked by shot recovery time, energy per shot and thermal load.
+ *
+ * The ball leaves at half the wheel's surface speed, so every design is run
+ * at the wheel speed giving the same exit speed; designs whose motors can't
+ * reach it are dropped. Trials are spread over a pool of threads, one plant
+ * per thread, and each trial's random numbers come from its design and trial
+ * number, so results do not depend on the thread count.
+ *
+ * Usage: explore [-j threads] [-n trials] [-v exit m/s] [-s recovery|energy|thermal|spinup] [-k top]
+ */
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "api.h"
+#include "sim.h"
+#include "sim_plant.h"
+
+/* Nominal scenario, varied per trial */
+#define EXPLORE_EXIT_SPEED 9.0      /* m/s */
+#define EXPLORE_BALL_MASS 0.06      /* kg, +-10% */
+#define EXPLORE_CONTACT_MS 20       /* ms, +-25% */
+#define EXPLORE_FRICTION_VAR 0.3    /* +-30% on the flywheel friction */
+#define EXPLORE_SHOTS 5
+#define EXPLORE_SHOT_TIME 1.0       /* s between shots */
+#define EXPLORE_SPINUP_MAX 10.0     /* s, slower designs are dropped */
+#define EXPLORE_READY 0.95          /* Fraction of target speed for spun up and recovered */
+/* Steady winding temperature rise (K) above which a design is dropped, the motors derate from 55 C */
+#define EXPLORE_TEMP_LIMIT 30.0
+/* Lowest wheel speed (% of target) during a shot, a wheel that sags further slows the ball itself */
+#define EXPLORE_SAG_LIMIT 80.0
+/* Control period (ms) */
+#define EXPLORE_PERIOD 10
+/* Take back half gain (V per tick per unit of speed error) */
+#define EXPLORE_TBH_GAIN 0.5
+
+/* Swept values */
+static const double explore_mass[] = {0.10, 0.20, 0.30, 0.45, 0.60};
+static const double explore_radius[] = {0.035, 0.050, 0.065, 0.080};
+static const int explore_cartridge[] = {E_MOTOR_GEARSET_36, E_MOTOR_GEARSET_18, E_MOTOR_GEARSET_06};
+static const double explore_ratio[] = {1.0, 3.0, 5.0, 7.0};
+static const int explore_motors[] = {1, 2, 4};
+#define COUNT(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+/* Controllers */
+typedef enum
+{
+    CTRL_VELOCITY,  /* The motor's own velocity loop, as the app runs it */
+    CTRL_BANG,      /* Full voltage below target, coast above */
+    CTRL_TBH,       /* Take back half on voltage */
+    CTRL_COUNT
+} ctrl_t;
+static const char * const ctrl_name[CTRL_COUNT] = {"velocity","bang","tbh"};
+
+/* Rated output speed, by motor_gearset_e_t */
+static const int cartridge_rpm[3] = {100, 200, 600};
+static const char * const cartridge_name[3] = {"red","green","blue"};
+
+typedef struct
+{
+    double mass;
+    double radius;
+    int cartridge;
+    double ratio;
+    int motors;
+    ctrl_t ctrl;
+} design_t;
+
+typedef struct
+{
+    /* Design could not reach speed, or was dropped for heat or sag */
+    bool infeasible;
+    bool hot;
+    bool sags;
+    int trials;
+    /* Shots that had not recovered by the next shot */
+    int late;
+    double spinup;      /* s */
+    double recovery;    /* s, mean per shot */
+    double energy;      /* J, mean per shot */
+    double temp_rise;   /* K, steady rise at this shot rate */
+    double min_pct;     /* Lowest speed, % of target */
+} score_t;
+
+static design_t * designs;
+static score_t * scores;
+static int design_count;
+static int trials = 32;
+static double exit_speed = EXPLORE_EXIT_SPEED;
+static atomic_int next_design;
+
+
+/* splitmix64, seeded per trial */
+static uint64_t rng_next(uint64_t * state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/* Uniform in [1-var, 1+var] */
+static double rng_vary(uint64_t * state, double var)
+{
+    double u = (rng_next(state) >> 11) * (1.0 / 9007199254740992.0);
+    return 1.0 + var * (2.0 * u - 1.0);
+}
+
+/* Controller state of one trial */
+typedef struct
+{
+    ctrl_t type;
+    int motors;
+    /* Target at the motor output (rpm) */
+    double target;
+    double volts;
+    double volts_tbh;
+    double err_last;
+} ctrl_state_t;
+
+/* One control period on every motor, returns the output speed (rpm) */
+static double ctrl_step(ctrl_state_t * c)
+{
+    double speed = motor_get_actual_velocity(1);
+    double err = c->target - speed;
+    for(int p = 1; p <= c->motors; p++)
+    {
+        switch(c->type)
+        {
+        case CTRL_VELOCITY:
+            motor_move_velocity(p,(int32_t)lround(c->target));
+            break;
+        case CTRL_BANG:
+            motor_move_voltage(p,(err > 0.0) ? 12000 : 0);
+            break;
+        case CTRL_TBH:
+            if(1 == p)
+            {
+                c->volts += EXPLORE_TBH_GAIN * err / c->target;
+                c->volts = fmax(0.0,fmin(SIM_VMAX,c->volts));
+                /* Error changed sign, take back half of the overshoot */
+                if((err > 0.0) != (c->err_last > 0.0))
+                {
+                    c->volts = 0.5 * (c->volts + c->volts_tbh);
+                    c->volts_tbh = c->volts;
+                }
+                c->err_last = err;
+            }
+            motor_move_voltage(p,(int32_t)lround(c->volts * 1000.0));
+            break;
+        default:
+            break;
+        }
+    }
+    sim_step(EXPLORE_PERIOD);
+    return speed;
+}
+
+/* Electrical power and winding loss of all motors (W) */
+static void ctrl_power(int motors, double * power, double * loss)
+{
+    *power = 0.0;
+    *loss = 0.0;
+    for(int p = 1; p <= motors; p++)
+    {
+        double i = motor_get_current_draw(p) / 1000.0;
+        *power += motor_get_power(p);
+        *loss += i * i * SIM_R;
+    }
+}
+
+/* One spinup and string of shots, false if the design can't get to speed */
+static bool explore_trial(const design_t * d, uint64_t seed, score_t * s)
+{
+    uint64_t rng = seed;
+    double ball = EXPLORE_BALL_MASS * rng_vary(&rng,0.1);
+    double contact = EXPLORE_CONTACT_MS * rng_vary(&rng,0.25);
+    double friction = rng_vary(&rng,EXPLORE_FRICTION_VAR);
+
+    /* Solid disc, friction scaled from the default wheel by inertia */
+    double inertia = 0.5 * d->mass * d->radius * d->radius;
+    double scale = inertia / SIM_FW_INERTIA;
+    sim_reset();
+    int fw = sim_flywheel(inertia,SIM_FW_VISCOUS * scale * friction,SIM_FW_COULOMB * friction);
+    for(int p = 1; p <= d->motors; p++)
+    {
+        sim_motor(p,d->cartridge,fw,d->ratio);
+        motor_set_gearing(p,d->cartridge);
+        motor_set_brake_mode(p,E_MOTOR_BRAKE_COAST);
+    }
+
+    /* Wheel speed for the exit speed, and what that asks of the motors */
+    double wheel = 2.0 * exit_speed / d->radius;
+    ctrl_state_t c = {0};
+    c.type = d->ctrl;
+    c.motors = d->motors;
+    c.target = wheel * 60.0 / (2.0 * M_PI) / d->ratio;
+    if(c.target > cartridge_rpm[d->cartridge])
+    {
+        return false;
+    }
+    c.volts_tbh = SIM_VMAX * c.target / cartridge_rpm[d->cartridge];
+    c.volts = c.volts_tbh;
+    double ready = EXPLORE_READY * c.target;
+
+    /* Spinup */
+    double t = 0.0;
+    while(ctrl_step(&c) < ready)
+    {
+        t += EXPLORE_PERIOD / 1000.0;
+        if(t > EXPLORE_SPINUP_MAX)
+        {
+            return false;
+        }
+    }
+    s->spinup += t;
+    for(int n = 0; n < 1000 / EXPLORE_PERIOD; n++)
+    {
+        ctrl_step(&c);
+    }
+
+    /* Shots, the ball takes its exit momentum from the wheel over the contact time */
+    double torque = ball * exit_speed * d->radius / (contact / 1000.0);
+    double energy = 0.0, loss = 0.0, min = c.target;
+    int ticks = (int)(EXPLORE_SHOT_TIME * 1000 / EXPLORE_PERIOD);
+    for(int shot = 0; shot < EXPLORE_SHOTS; shot++)
+    {
+        sim_impact(fw,torque,(uint32_t)lround(contact));
+        bool dipped = false;
+        double recovered = -1.0;
+        for(int n = 0; n < ticks; n++)
+        {
+            double speed = ctrl_step(&c);
+            double p, l;
+            ctrl_power(d->motors,&p,&l);
+            loss += l * EXPLORE_PERIOD / 1000.0;
+            if(recovered < 0.0)
+            {
+                energy += p * EXPLORE_PERIOD / 1000.0;
+            }
+            min = fmin(min,speed);
+            if(speed < ready)
+            {
+                dipped = true;
+            }
+            else if(dipped && recovered < 0.0)
+            {
+                recovered = (n + 1) * EXPLORE_PERIOD / 1000.0;
+            }
+        }
+        if(!dipped)
+        {
+            recovered = 0.0;
+        }
+        else if(recovered < 0.0)
+        {
+            s->late++;
+            recovered = EXPLORE_SHOT_TIME;
+        }
+        s->recovery += recovered;
+    }
+    s->energy += energy / EXPLORE_SHOTS;
+    /* Mean loss per motor at this shot rate, to a steady rise through the thermal resistance */
+    s->temp_rise += loss / (EXPLORE_SHOTS * EXPLORE_SHOT_TIME) / d->motors * SIM_RTH;
+    s->min_pct += min / c.target * 100.0;
+    s->trials++;
+    return true;
+}
+
+static void * explore_worker(void * arg)
+{
+    int i;
+    while((i = atomic_fetch_add(&next_design,1)) < design_count)
+    {
+        score_t * s = &scores[i];
+        for(int t = 0; t < trials; t++)
+        {
+            if(!explore_trial(&designs[i],((uint64_t)i << 32) | t,s))
+            {
+                s->infeasible = true;
+                break;
+            }
+        }
+        if(s->infeasible)
+        {
+            continue;
+        }
+        s->spinup /= s->trials;
+        s->recovery /= s->trials * EXPLORE_SHOTS;
+        s->energy /= s->trials;
+        s->temp_rise /= s->trials;
+        s->min_pct /= s->trials;
+        s->hot = s->temp_rise > EXPLORE_TEMP_LIMIT;
+        s->sags = s->min_pct < EXPLORE_SAG_LIMIT;
+    }
+    return NULL;
+}
+
+/* Ranking */
+static int sort_key = 0;
+static double score_key(const score_t * s)
+{
+    switch(sort_key)
+    {
+    case 1: return s->energy;
+    case 2: return s->temp_rise;
+    case 3: return s->spinup;
+    default: return s->recovery;
+    }
+}
+
+static int score_cmp(const void * a, const void * b)
+{
+    const score_t * sa = &scores[*(const int *)a];
+    const score_t * sb = &scores[*(const int *)b];
+    bool ra = !sa->infeasible && !sa->hot && !sa->sags;
+    bool rb = !sb->infeasible && !sb->hot && !sb->sags;
+    if(ra != rb)
+    {
+        return ra ? -1 : 1;
+    }
+    double ka = score_key(sa), kb = score_key(sb);
+    if(ka != kb)
+    {
+        return (ka < kb) ? -1 : 1;
+    }
+    /* Ties (recovery is often whole ticks) go to the cheaper shot */
+    if(sa->energy != sb->energy)
+    {
+        return (sa->energy < sb->energy) ? -1 : 1;
+    }
+    return *(const int *)a - *(const int *)b;
+}
+
+int main(int argc, char ** argv)
+{
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int top = 20;
+    int opt;
+    while((opt = getopt(argc,argv,"j:n:v:s:k:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'j':
+            threads = atoi(optarg);
+            break;
+        case 'n':
+            trials = atoi(optarg);
+            break;
+        case 'v':
+            exit_speed = atof(optarg);
+            break;
+        case 's':
+            sort_key = !strcmp(optarg,"energy") ? 1 : !strcmp(optarg,"thermal") ? 2 : !strcmp(optarg,"spinup") ? 3 : 0;
+            break;
+        case 'k':
+            top = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr,"Usage: %s [-j threads] [-n trials] [-v exit m/s] [-s recovery|energy|thermal|spinup] [-k top]\n",argv[0]);
+            return 2;
+        }
+    }
+    if(threads < 1) threads = 1;
+    if(trials < 1) trials = 1;
+
+    /* Every combination */
+    design_count = COUNT(explore_mass) * COUNT(explore_radius) * COUNT(explore_cartridge) *
+                   COUNT(explore_ratio) * COUNT(explore_motors) * CTRL_COUNT;
+    designs = calloc(design_count,sizeof(design_t));
+    scores = calloc(design_count,sizeof(score_t));
+    int n = 0;
+    for(int a = 0; a < COUNT(explore_mass); a++)
+    for(int b = 0; b < COUNT(explore_radius); b++)
+    for(int c = 0; c < COUNT(explore_cartridge); c++)
+    for(int d = 0; d < COUNT(explore_ratio); d++)
+    for(int e = 0; e < COUNT(explore_motors); e++)
+    for(int f = 0; f < CTRL_COUNT; f++)
+    {
+        designs[n++] = (design_t){explore_mass[a],explore_radius[b],explore_cartridge[c],
+                                  explore_ratio[d],explore_motors[e],(ctrl_t)f};
+    }
+
+    struct timespec wall_start, wall_end;
+    clock_gettime(CLOCK_MONOTONIC,&wall_start);
+    pthread_t * pool = calloc(threads,sizeof(pthread_t));
+    for(int i = 0; i < threads; i++)
+    {
+        pthread_create(&pool[i],NULL,explore_worker,NULL);
+    }
+    for(int i = 0; i < threads; i++)
+    {
+        pthread_join(pool[i],NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC,&wall_end);
+    double wall = (wall_end.tv_sec - wall_start.tv_sec) + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+
+    int * order = calloc(design_count,sizeof(int));
+    int feasible = 0, dropped = 0, scenarios = 0;
+    for(int i = 0; i < design_count; i++)
+    {
+        order[i] = i;
+        feasible += !scores[i].infeasible;
+        dropped += !scores[i].infeasible && (scores[i].hot || scores[i].sags);
+        scenarios += scores[i].trials;
+    }
+    qsort(order,design_count,sizeof(int),score_cmp);
+
+    printf("Exit speed %.1f m/s, %d shots %.1f s apart, %d trials per design\n",exit_speed,EXPLORE_SHOTS,EXPLORE_SHOT_TIME,trials);
+    printf("%4s %6s %6s %-5s %5s %3s %-8s | %7s %8s %8s %7s %6s %4s\n",
+           "rank","kg","mm","cart","ratio","mtr","control","spinup","recovery","J/shot","rise K","min %","late");
+    for(int r = 0; r < top && r < feasible - dropped; r++)
+    {
+        const design_t * d = &designs[order[r]];
+        const score_t * s = &scores[order[r]];
+        printf("%4d %6.2f %6.0f %-5s %5.0f %3d %-8s | %6.2fs %7.2fs %8.2f %7.1f %6.1f %4d\n",
+               r+1,d->mass,d->radius * 1000.0,cartridge_name[d->cartridge],d->ratio,d->motors,ctrl_name[d->ctrl],
+               s->spinup,s->recovery,s->energy,s->temp_rise,s->min_pct,s->late);
+    }
+    printf("%d designs, %d reach speed, %d dropped (over %.0f K rise or under %.0f%% in a shot); %d scenarios on %d threads in %.2f s\n",
+           design_count,feasible,dropped,EXPLORE_TEMP_LIMIT,EXPLORE_SAG_LIMIT,scenarios,threads,wall);
+
+    free(order);
+    free(pool);
+    free(designs);
+    free(scores);
+    return 0;
+}
@@ -0,0 +1,330 @@
+/* Replay recorded telemetry through the motor and group code
+ * Reads the CSV telem_rx prints (from the serial port, an SD recording, or
+ * sim_run -w), feeds each tick's samples to motor_sample() through the sim's
+ * PROS calls in place of the plant, runs the groups and prints the events the
+ * detectors raise. Replay has no clock or threads, so the same session and
+ * build give the same events bit for bit.
+ *
+ * The stream does not say which motors follow which, so groups are given by
+ * a "#G,AB,C" line in the session or by -g (default, every motor alone).
+ * A motor with no sample in a tick reads as unplugged for that tick.
+ *
+ * Usage: replay [-d] [-g groups] [-u] session.csv [golden]
+ *  -d  print debug logging from the app
+ *  -g  groups, e.g. AB,C (B follows A), overrides the session
+ *  -u  write the events to golden instead of comparing
+ * With a golden file, exits non-zero and prints the differences if the events differ.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "sim.h"
+#include "sim_plant.h"
+
+/* Use pal log, for the level names */
+#include "pal/log.h"
+
+/* Differences printed before giving up */
+#define REPLAY_DIFF_MAX 10
+
+/* Replay has no plant, just the feedback of the current tick */
+SIM_LOCAL sim_motor_t sim_motors[SIM_PORTS];
+const double sim_cartridge_ratio[3] = {36.0, 18.0, 6.0};
+static uint64_t replay_us = 0;
+
+/* Time step, as main.c sets it */
+double dt;
+
+/* Leader of each motor from the groups, -1 for a leader */
+static int8_t replay_leader[NUM_MOTORS];
+static bool replay_groups_fixed = false;
+
+/* Samples of the tick being read */
+static struct
+{
+    uint32_t time;
+    bool have;
+    bool seen[NUM_MOTORS];
+    bool powered[NUM_MOTORS];
+    double ch[NUM_MOTORS][TELEM_CH_COUNT];
+} tick;
+
+
+void sim_step(uint32_t ms)
+{
+    replay_us += (uint64_t)ms * 1000;
+}
+
+uint64_t sim_time_us()
+{
+    return replay_us;
+}
+
+/* Parse "AB,C", the first letter of each group leads it */
+static bool replay_groups(const char * spec)
+{
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        replay_leader[i] = -1;
+    }
+    int lead = -1;
+    for(const char * p = spec; *p && *p != '\n'; p++)
+    {
+        if(',' == *p)
+        {
+            lead = -1;
+            continue;
+        }
+        int idx = *p - 'A';
+        if(idx < 0 || idx >= NUM_MOTORS)
+        {
+            fprintf(stderr,"replay: bad group spec '%s'\n",spec);
+            return false;
+        }
+        if(lead < 0)
+        {
+            lead = idx;
+        }
+        else if(idx < lead)
+        {
+            /* Followers are to the right of their leader, as on the config tab */
+            fprintf(stderr,"replay: %c can't follow %c\n",*p,lead+'A');
+            return false;
+        }
+        else
+        {
+            replay_leader[idx] = lead;
+        }
+    }
+    return true;
+}
+
+/* One pass of the control loop in main.c on the samples of a tick */
+static void replay_tick()
+{
+    replay_us = (uint64_t)tick.time * 1000;
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        sim_motor_t * m = &sim_motors[i];
+        if(tick.seen[i] && motors[i].port < 0)
+        {
+            /* First sample of a motor, on port idx+1 so ports and letters line up */
+            motor_attach(i,i+1);
+            motors[i].leader = replay_leader[i];
+            m->present = true;
+        }
+        m->plugged = tick.seen[i];
+        if(!tick.seen[i])
+        {
+            continue;
+        }
+        m->fb_rpm = tick.ch[i][TELEM_CH_SPEED];
+        m->fb_curr = tick.ch[i][TELEM_CH_CURR];
+        m->fb_volt = tick.ch[i][TELEM_CH_VOLT];
+        m->fb_power = tick.ch[i][TELEM_CH_POWER];
+        m->fb_temp = tick.ch[i][TELEM_CH_TEMP];
+
+        /* Every member was sampled with its leader's power and target */
+        int lead = (replay_leader[i] >= 0) ? replay_leader[i] : i;
+        motors[lead].powered = tick.powered[i];
+        motors[lead].target = (int32_t)tick.ch[i][TELEM_CH_TARGET];
+    }
+
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        motor_sample(i);
+    }
+    group_update();
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        group_run(i);
+    }
+
+    memset(&tick,0,sizeof(tick));
+}
+
+/* Read a session, returns the ticks replayed or -1 */
+static long replay_file(FILE * in)
+{
+    char line[256];
+    long ticks = 0;
+    long lineno = 0;
+    while(fgets(line,sizeof(line),in))
+    {
+        lineno++;
+        if(!strncmp(line,"#G,",3))
+        {
+            if(!replay_groups_fixed && !replay_groups(&line[3]))
+            {
+                return -1;
+            }
+            continue;
+        }
+        if('T' != line[0])
+        {
+            /* Headers and the events recorded with the session */
+            continue;
+        }
+
+        unsigned time;
+        char letter;
+        int powered;
+        double ch[TELEM_CH_COUNT];
+        if(sscanf(line,"T,%u,%c,%d,%lf,%lf,%lf,%lf,%lf,%lf",&time,&letter,&powered,
+                  &ch[0],&ch[1],&ch[2],&ch[3],&ch[4],&ch[5]) != 3 + TELEM_CH_COUNT ||
+           letter < 'A' || letter >= 'A' + NUM_MOTORS)
+        {
+            fprintf(stderr,"replay: line %ld: bad sample\n",lineno);
+            return -1;
+        }
+        if(tick.have && time != tick.time)
+        {
+            replay_tick();
+            ticks++;
+        }
+        int idx = letter - 'A';
+        tick.have = true;
+        tick.time = time;
+        tick.seen[idx] = true;
+        tick.powered[idx] = powered;
+        memcpy(tick.ch[idx],ch,sizeof(ch));
+    }
+    if(tick.have)
+    {
+        replay_tick();
+        ticks++;
+    }
+    return ticks;
+}
+
+/* Compare the events with the golden file, returns the number of differing lines */
+static int replay_diff(FILE * events, FILE * golden)
+{
+    char got[256], want[256];
+    int diffs = 0;
+    long lineno = 0;
+    rewind(events);
+    while(1)
+    {
+        bool have_got = fgets(got,sizeof(got),events) != NULL;
+        bool have_want = fgets(want,sizeof(want),golden) != NULL;
+        if(!have_got && !have_want)
+        {
+            break;
+        }
+        lineno++;
+        if(have_got && have_want && !strcmp(got,want))
+        {
+            continue;
+        }
+        if(++diffs <= REPLAY_DIFF_MAX)
+        {
+            printf("line %ld:\n",lineno);
+            if(have_want) printf("- %s",want);
+            if(have_got) printf("+ %s",got);
+        }
+    }
+    return diffs;
+}
+
+int main(int argc, char ** argv)
+{
+    bool update = false;
+    int opt;
+    sim_log_level = LOG_LEVEL_ALWAYS + 1;
+    while((opt = getopt(argc,argv,"dg:u")) != -1)
+    {
+        switch(opt)
+        {
+        case 'd':
+            sim_log_level = LOG_LEVEL_DEBUG;
+            break;
+        case 'g':
+            if(!replay_groups(optarg))
+            {
+                return 2;
+            }
+            replay_groups_fixed = true;
+            break;
+        case 'u':
+            update = true;
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+    if(optind >= argc || argc - optind > 2 || (update && argc - optind != 2))
+    {
+        fprintf(stderr,"Usage: %s [-d] [-g groups] [-u] session.csv [golden]\n",argv[0]);
+        return 2;
+    }
+    const char * session = argv[optind];
+    const char * golden = (argc - optind == 2) ? argv[optind+1] : NULL;
+
+    FILE * in = fopen(session,"r");
+    if(!in)
+    {
+        perror(session);
+        return 2;
+    }
+    if(!replay_groups_fixed)
+    {
+        replay_groups("");
+    }
+
+    /* Events go straight out, or to a temporary file to compare */
+    sim_events = golden ? (update ? fopen(golden,"w") : tmpfile()) : stdout;
+    if(!sim_events)
+    {
+        perror(golden);
+        return 2;
+    }
+
+    /* Boot state of the slots, as motor_init() leaves them with no motors */
+    dt = 0.02;
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        motors[i].idx = i;
+        motors[i].port = -1;
+        motors[i].leader = -1;
+        motors[i].gearset = E_MOTOR_GEARSET_06;
+    }
+
+    struct timespec wall_start, wall_end;
+    clock_gettime(CLOCK_MONOTONIC,&wall_start);
+    long ticks = replay_file(in);
+    clock_gettime(CLOCK_MONOTONIC,&wall_end);
+    fclose(in);
+    if(ticks < 0)
+    {
+        return 2;
+    }
+    double wall = (wall_end.tv_sec - wall_start.tv_sec) + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+    double rec = ticks * dt;
+
+    int diffs = 0;
+    if(golden && !update)
+    {
+        FILE * want = fopen(golden,"r");
+        if(!want)
+        {
+            perror(golden);
+            return 2;
+        }
+        diffs = replay_diff(sim_events,want);
+        fclose(want);
+    }
+    if(sim_events != stdout)
+    {
+        fclose(sim_events);
+    }
+
+    fprintf(stderr,"replay: %s, %ld ticks (%.1f s) in %.3f s (%.0fx real time)%s\n",session,ticks,rec,wall,
+            (wall > 0.0) ? rec / wall : 0.0,
+            update ? ", golden written" : (!golden ? "" : (diffs ? ", DIFFERS from golden" : ", matches golden")));
+    return diffs ? 1 : 0;
+}
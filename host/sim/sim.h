@@ -0,0 +1,104 @@
+/* Host simulation of the V5 brain for the shooter tester
+ * Implements the PROS calls the motor, group and port code use (motor_*,
+ * registry_*, millis/micros, delay, and enough of the RTOS for them to link)
+ * on top of a V5 motor model driving flywheel plants, so the control code
+ * runs unchanged on a laptop, faster than real time.
+ *
+ * Time is simulated: delay() and task_delay_until() step the physics, nothing
+ * waits on the wall clock. Tasks are not run, so background work (port
+ * rescans, the deferred log) does not happen; log output is printed at once.
+ *
+ * Motor model, per cartridge (36:1 red, 18:1 green, 6:1 blue):
+ *  - DC motor at the motor shaft, 12 V, 3800 rpm free (3600 rated), SIM_R winding resistance
+ *  - current limited to SIM_CURRENT_LIMIT by the motor's own driver
+ *  - internal PI velocity loop, updated every SIM_PACKET_MS like the motor firmware
+ *  - feedback (velocity, current, voltage, power, temperature) sampled every SIM_PACKET_MS
+ *  - first order thermal model from the winding losses
+ * Flywheel plant: inertia, viscous and coulomb friction, driven by any number
+ * of motors through an external ratio, with ball impacts injected as a drag
+ * torque for a duration.
+ */
+#ifndef _SIM_H_
+#define _SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/* Physics step (us) */
+#define SIM_STEP_US 1000
+/* Motor firmware packet period, control and feedback (ms) */
+#define SIM_PACKET_MS 10
+
+/* Motor, at the motor shaft */
+#define SIM_VMAX 12.0               /* V */
+#define SIM_KE (12.0 / 398.0)       /* V/(rad/s), 3800 rpm free at 12 V, also Nm/A */
+#define SIM_R 3.3                   /* Ohm */
+#define SIM_CURRENT_LIMIT 2.5       /* A */
+#define SIM_GEAR_EFF 0.75           /* Cartridge efficiency */
+/* Internal velocity loop (V per rad/s of error at the motor shaft) */
+#define SIM_KP 0.02
+#define SIM_KI 0.5
+/* Thermal, winding to ambient */
+#define SIM_AMBIENT 25.0            /* deg C */
+#define SIM_RTH 4.0                 /* K/W */
+#define SIM_CTH 40.0                /* J/K */
+
+/* Battery, open circuit and internal resistance, it sags with the motors' current */
+#define SIM_BATT_V 12.8             /* V */
+#define SIM_BATT_R 0.1              /* Ohm */
+
+/* Defaults for sim_flywheel() */
+#define SIM_FW_INERTIA 0.0005       /* kg m^2 */
+#define SIM_FW_VISCOUS 0.00002      /* Nm/(rad/s) */
+#define SIM_FW_COULOMB 0.004        /* Nm */
+
+#define SIM_MAX_FLYWHEELS 4
+
+/* Forget all motors and flywheels and restart time at zero */
+void sim_reset();
+
+/* Add a flywheel, returns its id */
+int sim_flywheel(double inertia, double viscous, double coulomb);
+
+/* Plug a motor with a cartridge (E_MOTOR_GEARSET_*) into a port (1-21), driving a flywheel
+ * ratio is flywheel speed over motor output speed
+ */
+void sim_motor(uint8_t port, int cartridge, int flywheel, double ratio);
+
+/* Unplug or replug a motor, an unplugged motor reads PROS_ERR like the real one */
+void sim_plug(uint8_t port, bool plugged);
+
+/* A ball in the flywheel, drag torque (Nm) for a time (ms) */
+void sim_impact(int flywheel, double torque, uint32_t ms);
+
+/* A feeder on a three wire port (1-8), each rising edge of its output puts a ball
+ * in the flywheel like sim_impact, port 0 removes it
+ */
+void sim_feeder(uint8_t port, int flywheel, double torque, uint32_t ms);
+
+/* Step the physics by a time (ms) */
+void sim_step(uint32_t ms);
+
+/* Flywheel speed (rpm) */
+double sim_flywheel_rpm(int flywheel);
+
+/* Simulated time (us) */
+uint64_t sim_time_us();
+
+/* Print log lines at or above this level (LOG_LEVEL_*), reports when verbose */
+extern int sim_log_level;
+extern bool sim_verbose;
+
+/* Results seen, by results_type_t, with the last values */
+#define SIM_RESULT_TYPES 8
+extern int sim_result_count[SIM_RESULT_TYPES];
+extern float sim_result_last[SIM_RESULT_TYPES][3];
+
+/* If set, samples and events are written to these as telem_rx prints them (CSV),
+ * so a simulated run can be replayed like a recorded one (see replay.c)
+ */
+extern FILE * sim_telem;
+extern FILE * sim_events;
+
+#endif /* _SIM_H_ */
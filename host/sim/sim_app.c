@@ -0,0 +1,120 @@
+/* Stand-ins for the app modules not built for the host
+ * The motor, group and port code is linked unchanged, these take the calls
+ * it makes into the UI, telemetry, logger and result store.
+ */
+#include <math.h>
+#include <stdarg.h>
+
+#include "main.h"
+#include "sim.h"
+
+/* Use pal log */
+#include "pal/log.h"
+
+int sim_log_level = LOG_LEVEL_WARN;
+bool sim_verbose = false;
+int sim_result_count[SIM_RESULT_TYPES];
+float sim_result_last[SIM_RESULT_TYPES][3];
+FILE * sim_telem = NULL;
+FILE * sim_events = NULL;
+
+/* Logger, everything is printed at once with the sim time */
+FILE * fd = NULL;
+FILE * dd = NULL;
+volatile log_level_t log_level_runtime = LOG_LEVEL_DEBUG;
+
+int log_check(const char * fname, const int line, log_level_t level, log_level_t flevel)
+{
+    if(level < flevel || (int)level < sim_log_level)
+    {
+        return 0;
+    }
+    printf("[%9.3f] %s:%d: ",sim_time_us() / 1e6,fname,line);
+    return 1;
+}
+
+/* Deferred calls pass the format arguments, already promoted, so they print directly */
+void dlog_write(const char * file, int line, int level, int flevel, const char * fmt, int nargs, uint32_t types, ...)
+{
+    if(!log_check(file,line,level,flevel))
+    {
+        return;
+    }
+    va_list ap;
+    va_start(ap,types);
+    vprintf(fmt,ap);
+    va_end(ap);
+    printf("\n");
+}
+
+void report_event(uint8_t motor, report_type_t type, const char * str)
+{
+    if(sim_verbose)
+    {
+        printf("[%9.3f] REPORT %s\n",sim_time_us() / 1e6,str);
+    }
+}
+
+void results_add(uint8_t motor, results_type_t type, float a, float b, float c)
+{
+    if(type >= SIM_RESULT_TYPES)
+    {
+        return;
+    }
+    sim_result_count[type]++;
+    sim_result_last[type][0] = a;
+    sim_result_last[type][1] = b;
+    sim_result_last[type][2] = c;
+}
+
+/* Telemetry, quantized to the channel scales as telem.c sends it */
+void telem_sample(uint8_t idx, bool powered, int32_t target)
+{
+    if(!sim_telem)
+    {
+        return;
+    }
+    motor_t * mine = &motors[idx];
+    int32_t ch[TELEM_CH_COUNT];
+    ch[TELEM_CH_TARGET] = target;
+    ch[TELEM_CH_SPEED] = (int32_t)lround(mine->data.speed * 10.0);
+    ch[TELEM_CH_CURR] = (int32_t)lround(mine->data.curr * 1000.0);
+    ch[TELEM_CH_VOLT] = (int32_t)lround(mine->data.volt * 1000.0);
+    ch[TELEM_CH_POWER] = (int32_t)lround(mine->data.power * 100.0);
+    ch[TELEM_CH_TEMP] = (int32_t)lround(mine->data.temp * 10.0);
+    fprintf(sim_telem,"T,%u,%c,%d",(unsigned)(sim_time_us() / 1000),idx+'A',powered);
+    for(int i = 0; i < TELEM_CH_COUNT; i++)
+    {
+        fprintf(sim_telem,",%g",ch[i] * telem_ch_scale[i]);
+    }
+    fprintf(sim_telem,"\n");
+}
+
+void telem_event(uint8_t idx, telem_event_t ev, float a, float b, float c)
+{
+    /* Full float precision, so a replay can be compared bit for bit */
+    if(sim_events)
+    {
+        fprintf(sim_events,"E,%u,%c,%s,%.9g,%.9g,%.9g\n",(unsigned)(sim_time_us() / 1000),idx+'A',telem_ev_name[ev],a,b,c);
+    }
+}
+
+void dash_speed(uint8_t idx, int16_t target, int16_t speed)
+{
+}
+
+void dash_shot(uint8_t idx, float time, float min_pct)
+{
+}
+
+/* Nothing reads the queue, attaches from the rescan task never happen (it does not run) */
+bool msg_ctrl_post(msg_ctrl_type_t type, uint8_t motor, int16_t arg)
+{
+    return false;
+}
+
+/* No UI to update */
+bool msg_ui_post(msg_ui_type_t type, uint8_t motor, int16_t target, int16_t speed)
+{
+    return false;
+}
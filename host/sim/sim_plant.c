@@ -0,0 +1,271 @@
+/* V5 motor model and flywheel plant */
+#include <math.h>
+#include <string.h>
+
+#include "api.h"
+#include "sim.h"
+#include "sim_plant.h"
+
+/* Cartridge ratios, by motor_gearset_e_t */
+const double sim_cartridge_ratio[3] = {36.0, 18.0, 6.0};
+
+SIM_LOCAL sim_motor_t sim_motors[SIM_PORTS];
+
+typedef struct
+{
+    bool present;
+    double inertia;
+    double viscous;
+    double coulomb;
+    /* rad/s */
+    double speed;
+    /* Impact drag (Nm) until impact_end_us */
+    double impact;
+    uint64_t impact_end_us;
+} sim_flywheel_t;
+
+static SIM_LOCAL sim_flywheel_t sim_flywheels[SIM_MAX_FLYWHEELS];
+static SIM_LOCAL uint64_t sim_us = 0;
+
+/* Feeder, port 0 if none */
+static SIM_LOCAL struct
+{
+    uint8_t port;
+    int flywheel;
+    double torque;
+    uint32_t ms;
+    bool last;
+} sim_feed;
+
+
+void sim_reset()
+{
+    memset(sim_motors,0,sizeof(sim_motors));
+    memset(sim_flywheels,0,sizeof(sim_flywheels));
+    memset(&sim_feed,0,sizeof(sim_feed));
+    sim_us = 0;
+}
+
+int sim_flywheel(double inertia, double viscous, double coulomb)
+{
+    for(int i = 0; i < SIM_MAX_FLYWHEELS; i++)
+    {
+        if(!sim_flywheels[i].present)
+        {
+            sim_flywheels[i].present = true;
+            sim_flywheels[i].inertia = inertia;
+            sim_flywheels[i].viscous = viscous;
+            sim_flywheels[i].coulomb = coulomb;
+            return i;
+        }
+    }
+    return -1;
+}
+
+void sim_motor(uint8_t port, int cartridge, int flywheel, double ratio)
+{
+    if(port < 1 || port > SIM_PORTS)
+    {
+        return;
+    }
+    sim_motor_t * m = &sim_motors[port-1];
+    memset(m,0,sizeof(*m));
+    m->present = true;
+    m->plugged = true;
+    m->cartridge = cartridge;
+    /* PROS starts every motor on the green cartridge setting */
+    m->gearing = E_MOTOR_GEARSET_18;
+    m->flywheel = flywheel;
+    m->ratio = ratio;
+    m->temp = SIM_AMBIENT;
+    m->fb_temp = SIM_AMBIENT;
+}
+
+void sim_plug(uint8_t port, bool plugged)
+{
+    if(port >= 1 && port <= SIM_PORTS && sim_motors[port-1].present)
+    {
+        sim_motors[port-1].plugged = plugged;
+        /* The motor restarts from its defaults when plugged back in */
+        sim_motors[port-1].mode = SIM_MODE_BRAKE;
+        sim_motors[port-1].integ = 0.0;
+    }
+}
+
+void sim_impact(int flywheel, double torque, uint32_t ms)
+{
+    if(flywheel < 0 || flywheel >= SIM_MAX_FLYWHEELS)
+    {
+        return;
+    }
+    sim_flywheels[flywheel].impact = torque;
+    sim_flywheels[flywheel].impact_end_us = sim_us + (uint64_t)ms * 1000;
+}
+
+void sim_feeder(uint8_t port, int flywheel, double torque, uint32_t ms)
+{
+    sim_feed.port = (port <= SIM_ADI_PORTS) ? port : 0;
+    sim_feed.flywheel = flywheel;
+    sim_feed.torque = torque;
+    sim_feed.ms = ms;
+    sim_feed.last = sim_feed.port ? sim_adi_out[sim_feed.port-1] : false;
+}
+
+double sim_flywheel_rpm(int flywheel)
+{
+    return sim_flywheels[flywheel].speed * 60.0 / (2.0 * M_PI);
+}
+
+uint64_t sim_time_us()
+{
+    return sim_us;
+}
+
+/* Motor shaft speed (rad/s) */
+static double sim_motor_speed(const sim_motor_t * m)
+{
+    return sim_flywheels[m->flywheel].speed / m->ratio * sim_cartridge_ratio[m->cartridge];
+}
+
+/* Motor firmware, once per packet: velocity loop, then sample the feedback */
+static void sim_packet(sim_motor_t * m)
+{
+    double w = sim_motor_speed(m);
+    double dt = SIM_PACKET_MS / 1000.0;
+
+    /* Targets are scaled by the cartridge setting, not the cartridge fitted */
+    double set_ratio = sim_cartridge_ratio[m->gearing];
+    if(SIM_MODE_VELOCITY == m->mode)
+    {
+        double target = m->target * set_ratio * 2.0 * M_PI / 60.0;
+        double err = target - w;
+        double v = SIM_KE * target + SIM_KP * err + m->integ;
+        /* Integrate only while not saturated */
+        if(fabs(v) < SIM_VMAX)
+        {
+            m->integ += SIM_KI * err * dt;
+        }
+        m->volts = fmax(-SIM_VMAX,fmin(SIM_VMAX,v));
+    }
+    else if(SIM_MODE_VOLTAGE == m->mode)
+    {
+        m->volts = fmax(-SIM_VMAX,fmin(SIM_VMAX,m->target));
+        m->integ = 0.0;
+    }
+    else
+    {
+        m->volts = 0.0;
+        m->integ = 0.0;
+    }
+
+    m->fb_rpm = w * 60.0 / (2.0 * M_PI) / set_ratio;
+    m->fb_curr = m->current;
+    m->fb_volt = m->volts_eff;
+    m->fb_power = fabs(m->volts_eff * m->current);
+    m->fb_temp = m->temp;
+}
+
+void sim_step(uint32_t ms)
+{
+    uint64_t end = sim_us + (uint64_t)ms * 1000;
+    double dt = SIM_STEP_US / 1e6;
+
+    /* Outputs only change between steps, so the feeder is checked once */
+    if(sim_feed.port)
+    {
+        bool out = sim_adi_out[sim_feed.port-1];
+        if(out && !sim_feed.last)
+        {
+            sim_impact(sim_feed.flywheel,sim_feed.torque,sim_feed.ms);
+        }
+        sim_feed.last = out;
+    }
+
+    while(sim_us < end)
+    {
+        double torque[SIM_MAX_FLYWHEELS] = {0};
+
+        /* Packets on the firmware's cadence */
+        if(0 == sim_us % (SIM_PACKET_MS * 1000))
+        {
+            for(int p = 0; p < SIM_PORTS; p++)
+            {
+                if(sim_motors[p].present && sim_motors[p].plugged)
+                {
+                    sim_packet(&sim_motors[p]);
+                }
+            }
+        }
+
+        /* Electrical and thermal, per motor */
+        for(int p = 0; p < SIM_PORTS; p++)
+        {
+            sim_motor_t * m = &sim_motors[p];
+            if(!m->present)
+            {
+                continue;
+            }
+            double w = sim_motor_speed(m);
+            double i = 0.0;
+            double v = 0.0;
+            /* Unplugged or coasting leaves the winding open */
+            bool open = !m->plugged || (SIM_MODE_BRAKE == m->mode && E_MOTOR_BRAKE_COAST == m->brake_mode);
+            if(!open)
+            {
+                v = m->volts;
+                i = (v - SIM_KE * w) / SIM_R;
+                /* The driver limits current by lowering the voltage it applies */
+                if(i > SIM_CURRENT_LIMIT)
+                {
+                    i = SIM_CURRENT_LIMIT;
+                    v = SIM_KE * w + SIM_R * i;
+                }
+                else if(i < -SIM_CURRENT_LIMIT)
+                {
+                    i = -SIM_CURRENT_LIMIT;
+                    v = SIM_KE * w + SIM_R * i;
+                }
+            }
+            m->current = i;
+            m->volts_eff = v;
+            m->temp += dt * (i * i * SIM_R - (m->temp - SIM_AMBIENT) / SIM_RTH) / SIM_CTH;
+
+            /* Torque at the output, then at the flywheel */
+            double out = SIM_GEAR_EFF * sim_cartridge_ratio[m->cartridge] * SIM_KE * i;
+            torque[m->flywheel] += out / m->ratio;
+        }
+
+        /* Flywheels */
+        for(int f = 0; f < SIM_MAX_FLYWHEELS; f++)
+        {
+            sim_flywheel_t * fw = &sim_flywheels[f];
+            if(!fw->present)
+            {
+                continue;
+            }
+            double drag = fw->viscous * fw->speed;
+            double friction = fw->coulomb;
+            if(sim_us < fw->impact_end_us)
+            {
+                friction += fw->impact;
+            }
+            double t = torque[f] - drag;
+            /* Friction opposes motion, and holds a stopped wheel until the drive overcomes it */
+            if(fabs(fw->speed) < 1e-3 && fabs(t) <= friction)
+            {
+                fw->speed = 0.0;
+                continue;
+            }
+            double dir = (fabs(fw->speed) >= 1e-3) ? copysign(1.0,fw->speed) : copysign(1.0,t);
+            double next = fw->speed + (t - dir * friction) / fw->inertia * dt;
+            /* Friction alone stops the wheel, it does not reverse it */
+            if(fabs(fw->speed) >= 1e-3 && copysign(1.0,next) != dir && fabs(torque[f]) <= friction)
+            {
+                next = 0.0;
+            }
+            fw->speed = next;
+        }
+
+        sim_us += SIM_STEP_US;
+    }
+}
@@ -0,0 +1,64 @@
+/* Motor state shared by the plant and the PROS calls, internal to the sim */
+#ifndef _SIM_PLANT_H_
+#define _SIM_PLANT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIM_PORTS 21
+
+/* Plant state is per thread, so independent runs can share a process (see explore.c) */
+#define SIM_LOCAL __thread
+
+/* What the motor firmware was last told to do */
+typedef enum
+{
+    SIM_MODE_BRAKE,
+    SIM_MODE_VELOCITY,
+    SIM_MODE_VOLTAGE
+} sim_mode_t;
+
+typedef struct
+{
+    /* A motor is fitted to the port, and its cable is in */
+    bool present;
+    bool plugged;
+    /* Cartridge fitted and the cartridge setting, both motor_gearset_e_t */
+    int cartridge;
+    int gearing;
+    /* motor_brake_mode_e_t */
+    int brake_mode;
+    sim_mode_t mode;
+    /* Velocity target (rpm at the output, by the cartridge setting), or voltage (V) */
+    double target;
+    /* Velocity loop integrator (V) */
+    double integ;
+    /* Voltage commanded, and applied after the current limit (V) */
+    double volts;
+    double volts_eff;
+    /* A */
+    double current;
+    /* Winding temperature (deg C) */
+    double temp;
+    /* Flywheel driven, ratio of flywheel speed to output speed */
+    int flywheel;
+    double ratio;
+    /* Feedback as of the last packet */
+    double fb_rpm;
+    double fb_curr;
+    double fb_volt;
+    double fb_power;
+    double fb_temp;
+} sim_motor_t;
+
+/* By port - 1 */
+extern SIM_LOCAL sim_motor_t sim_motors[SIM_PORTS];
+
+/* Cartridge ratios, by motor_gearset_e_t */
+extern const double sim_cartridge_ratio[3];
+
+/* Three wire digital outputs as last written, by port - 1 */
+#define SIM_ADI_PORTS 8
+extern SIM_LOCAL bool sim_adi_out[SIM_ADI_PORTS];
+
+#endif /* _SIM_PLANT_H_ */
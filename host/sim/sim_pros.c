@@ -0,0 +1,243 @@
+/* PROS calls backed by the simulated brain */
+#include <errno.h>
+#include <math.h>
+
+#include "api.h"
+#include "pros/apix.h"
+#include "sim.h"
+#include "sim_plant.h"
+
+/* Rated output speed, by motor_gearset_e_t */
+static const int32_t sim_max_rpm[3] = {100, 200, 600};
+
+
+/* Motor on a port, NULL (and errno set) if there is none answering, like the real calls */
+static sim_motor_t * sim_port(uint8_t port)
+{
+    if(port < 1 || port > SIM_PORTS)
+    {
+        errno = ENXIO;
+        return NULL;
+    }
+    sim_motor_t * m = &sim_motors[port-1];
+    if(!m->present || !m->plugged)
+    {
+        errno = ENODEV;
+        return NULL;
+    }
+    return m;
+}
+
+int32_t motor_brake(uint8_t port)
+{
+    sim_motor_t * m = sim_port(port);
+    if(!m)
+    {
+        return PROS_ERR;
+    }
+    m->mode = SIM_MODE_BRAKE;
+    return 1;
+}
+
+int32_t motor_move_velocity(uint8_t port, const int32_t velocity)
+{
+    sim_motor_t * m = sim_port(port);
+    if(!m)
+    {
+        return PROS_ERR;
+    }
+    int32_t max = sim_max_rpm[m->gearing];
+    m->target = (velocity > max) ? max : ((velocity < -max) ? -max : velocity);
+    m->mode = SIM_MODE_VELOCITY;
+    return 1;
+}
+
+int32_t motor_move_voltage(uint8_t port, const int32_t voltage)
+{
+    sim_motor_t * m = sim_port(port);
+    if(!m)
+    {
+        return PROS_ERR;
+    }
+    m->target = voltage / 1000.0;
+    m->mode = SIM_MODE_VOLTAGE;
+    return 1;
+}
+
+double motor_get_actual_velocity(uint8_t port)
+{
+    sim_motor_t * m = sim_port(port);
+    return m ? m->fb_rpm : PROS_ERR_F;
+}
+
+int32_t motor_get_current_draw(uint8_t port)
+{
+    sim_motor_t * m = sim_port(port);
+    return m ? (int32_t)lround(m->fb_curr * 1000.0) : PROS_ERR;
+}
+
+double motor_get_power(uint8_t port)
+{
+    sim_motor_t * m = sim_port(port);
+    return m ? m->fb_power : PROS_ERR_F;
+}
+
+double motor_get_temperature(uint8_t port)
+{
+    sim_motor_t * m = sim_port(port);
+    /* The motor reports in 5 degree steps */
+    return m ? floor(m->fb_temp / 5.0) * 5.0 : PROS_ERR_F;
+}
+
+int32_t motor_get_voltage(uint8_t port)
+{
+    sim_motor_t * m = sim_port(port);
+    return m ? (int32_t)lround(m->fb_volt * 1000.0) : PROS_ERR;
+}
+
+int32_t motor_set_brake_mode(uint8_t port, const motor_brake_mode_e_t mode)
+{
+    sim_motor_t * m = sim_port(port);
+    if(!m)
+    {
+        return PROS_ERR;
+    }
+    m->brake_mode = mode;
+    return 1;
+}
+
+int32_t motor_set_gearing(uint8_t port, const motor_gearset_e_t gearset)
+{
+    sim_motor_t * m = sim_port(port);
+    if(!m)
+    {
+        return PROS_ERR;
+    }
+    if(gearset < E_MOTOR_GEARSET_36 || gearset > E_MOTOR_GEARSET_06)
+    {
+        errno = EINVAL;
+        return PROS_ERR;
+    }
+    m->gearing = gearset;
+    return 1;
+}
+
+v5_device_e_t registry_get_plugged_type(uint8_t port)
+{
+    if(port >= SIM_PORTS)
+    {
+        errno = ENXIO;
+        return E_DEVICE_UNDEFINED;
+    }
+    sim_motor_t * m = &sim_motors[port];
+    return (m->present && m->plugged) ? E_DEVICE_MOTOR : E_DEVICE_NONE;
+}
+
+/* Battery voltage (mV) under the motors' current */
+int32_t battery_get_voltage(void)
+{
+    double amps = 0.0;
+    for(int p = 0; p < SIM_PORTS; p++)
+    {
+        if(sim_motors[p].present)
+        {
+            amps += fabs(sim_motors[p].current);
+        }
+    }
+    return (int32_t)lround((SIM_BATT_V - amps * SIM_BATT_R) * 1000.0);
+}
+
+/* Three wire ports, only digital outputs are modelled */
+SIM_LOCAL bool sim_adi_out[SIM_ADI_PORTS];
+
+/* Port number 1-8 from a number or a letter, 0 if invalid */
+static uint8_t sim_adi_port(uint8_t port)
+{
+    if(port >= 'a' && port <= 'h')
+    {
+        return port - 'a' + 1;
+    }
+    if(port >= 'A' && port <= 'H')
+    {
+        return port - 'A' + 1;
+    }
+    if(port >= 1 && port <= SIM_ADI_PORTS)
+    {
+        return port;
+    }
+    errno = ENXIO;
+    return 0;
+}
+
+int32_t adi_port_set_config(uint8_t port, adi_port_config_e_t type)
+{
+    return sim_adi_port(port) ? 1 : PROS_ERR;
+}
+
+int32_t adi_digital_write(uint8_t port, bool value)
+{
+    uint8_t p = sim_adi_port(port);
+    if(!p)
+    {
+        return PROS_ERR;
+    }
+    sim_adi_out[p-1] = value;
+    return 1;
+}
+
+/* Time, stepped by delay() */
+uint32_t millis(void)
+{
+    return (uint32_t)(sim_time_us() / 1000);
+}
+
+uint64_t micros(void)
+{
+    return sim_time_us();
+}
+
+void delay(const uint32_t milliseconds)
+{
+    sim_step(milliseconds);
+}
+
+void task_delay_until(uint32_t* const prev_time, const uint32_t delta)
+{
+    uint32_t wake = *prev_time + delta;
+    uint32_t now = millis();
+    if((int32_t)(wake - now) > 0)
+    {
+        sim_step(wake - now);
+    }
+    *prev_time = wake;
+}
+
+/* One thread of control, tasks are accepted but never run */
+task_t task_create(task_fn_t function, void* const parameters, uint32_t prio, const uint16_t stack_depth,
+                   const char* const name)
+{
+    static int sim_task;
+    return &sim_task;
+}
+
+mutex_t mutex_create(void)
+{
+    static int sim_mutex;
+    return &sim_mutex;
+}
+
+bool mutex_take(mutex_t mutex, uint32_t timeout)
+{
+    return true;
+}
+
+bool mutex_give(mutex_t mutex)
+{
+    return true;
+}
+
+/* No SD card, so nothing is read from or written to /usd */
+int32_t usd_is_installed(void)
+{
+    return 0;
+}
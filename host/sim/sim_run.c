@@ -0,0 +1,260 @@
+/* Run the motor and group code against the simulated brain
+ * Two blue motors drive one flywheel through 5:1, B following A. The wheel
+ * is spun up from rest, a number of balls are shot through it, and it is
+ * spun down, with the control loop main.c runs. Exits non-zero if the
+ * detectors did not report a spinup and every shot.
+ * Or a test script (script.h) runs the wheel from rest instead, its feed
+ * steps shooting balls, and it exits non-zero unless the script completed
+ * and any endurance run in it passed.
+ *
+ * Usage: sim_run [-v] [-d] [-u] [-n shots] [-t torque Nm] [-w session.csv] [-s script.txt]
+ *  -v  print the report lines
+ *  -d  print debug logging from the app
+ *  -u  also unplug motor B, briefly and then for a second, while spun up
+ *  -w  record samples and events as telem_rx would, for replay
+ *  -s  run a test script on motor A
+ */
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "sim.h"
+
+/* Use pal log, for the level names */
+#include "pal/log.h"
+
+/* Flywheel ratio over the motor output */
+#define SIM_RUN_RATIO 5.0
+/* Ball drag, duration (ms) */
+#define SIM_RUN_IMPACT_MS 20
+/* Time between shots (s), near free speed the motors recover slowly */
+#define SIM_RUN_SHOT_TIME 3.0
+/* Longest a script may run (s), it may repeat for ever */
+#define SIM_RUN_SCRIPT_LIMIT 7200.0
+
+/* Time step, as main.c sets it */
+double dt;
+
+static const char * result_names[SIM_RESULT_TYPES] = {"spinup 66%","spinup 95%","spinup 99%","shot","run power"};
+
+
+/* One pass of the control loop in main.c, without the UI */
+static void sim_tick()
+{
+    script_tick();
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        motor_sample(i);
+    }
+    group_update();
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        group_run(i);
+    }
+    delay(dt*1000);
+}
+
+/* Run the loop for a time (s) */
+static void sim_run(double time)
+{
+    for(int n = (int)(time / dt + 0.5); n > 0; n--)
+    {
+        sim_tick();
+    }
+}
+
+static void sim_status(const char * what)
+{
+    printf("[%9.3f] %-10s flywheel %6.0f rpm, motor A %4.0f rpm %5.2f A %5.2f W %3.0f C\n",
+           sim_time_us() / 1e6,what,sim_flywheel_rpm(0),motors[0].data.speed,motors[0].data.curr,
+           motors[0].data.power,motors[0].data.temp);
+}
+
+/* The fixed sequence, spin up, shots, spin down */
+static void sim_shots(int fw, int shots, double torque, bool unplug)
+{
+    /* Spin up */
+    motors[0].powered = true;
+    for(int n = 0; n < 500 && !sim_result_count[RESULTS_SPINUP_99]; n++)
+    {
+        sim_tick();
+    }
+    sim_status("spun up");
+    sim_run(1.0);
+
+    /* Shots, each given time to recover */
+    for(int i = 0; i < shots; i++)
+    {
+        sim_impact(fw,torque,SIM_RUN_IMPACT_MS);
+        sim_run(SIM_RUN_SHOT_TIME);
+        sim_status("shot");
+    }
+
+    /* A flaky cable is bridged, a longer loss restarts the group's tests */
+    if(unplug)
+    {
+        sim_plug(2,false);
+        sim_run(0.2);
+        sim_plug(2,true);
+        sim_run(1.0);
+        sim_plug(2,false);
+        sim_run(1.0);
+        sim_status("unplugged");
+        sim_plug(2,true);
+        sim_run(SIM_RUN_SHOT_TIME);
+        sim_status("replugged");
+    }
+
+    /* Long enough for a runtime power result, then spin down */
+    sim_run(5.0);
+    motors[0].powered = false;
+    sim_run(5.0);
+    sim_status("stopped");
+}
+
+/* The loaded script from rest, stopped if it runs too long */
+static void sim_script()
+{
+    script_toggle(0);
+    for(int n = (int)(SIM_RUN_SCRIPT_LIMIT / dt); n > 0 && script_running(); n--)
+    {
+        sim_tick();
+    }
+    if(script_running())
+    {
+        script_toggle(0);
+    }
+    sim_run(5.0);
+    sim_status("stopped");
+}
+
+int main(int argc, char ** argv)
+{
+    int shots = 5;
+    double torque = 1.5;
+    bool unplug = false;
+    FILE * script = NULL;
+    int opt;
+    while((opt = getopt(argc,argv,"vdun:t:w:s:")) != -1)
+    {
+        switch(opt)
+        {
+        case 'v':
+            sim_verbose = true;
+            break;
+        case 'd':
+            sim_log_level = LOG_LEVEL_DEBUG;
+            break;
+        case 'n':
+            shots = atoi(optarg);
+            break;
+        case 't':
+            torque = atof(optarg);
+            break;
+        case 'u':
+            unplug = true;
+            break;
+        case 'w':
+            sim_telem = fopen(optarg,"w");
+            if(!sim_telem)
+            {
+                perror(optarg);
+                return 2;
+            }
+            sim_events = sim_telem;
+            break;
+        case 's':
+            script = fopen(optarg,"r");
+            if(!script)
+            {
+                perror(optarg);
+                return 2;
+            }
+            break;
+        default:
+            fprintf(stderr,"Usage: %s [-v] [-d] [-u] [-n shots] [-t torque Nm] [-w session.csv] [-s script.txt]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    struct timespec wall_start, wall_end;
+    clock_gettime(CLOCK_MONOTONIC,&wall_start);
+
+    /* Build the robot, then boot the app on it */
+    dt = 0.02;
+    sim_reset();
+    int fw = sim_flywheel(SIM_FW_INERTIA,SIM_FW_VISCOUS,SIM_FW_COULOMB);
+    sim_motor(1,E_MOTOR_GEARSET_06,fw,SIM_RUN_RATIO);
+    sim_motor(2,E_MOTOR_GEARSET_06,fw,SIM_RUN_RATIO);
+    sim_feeder(SCRIPT_FEED_PORT - 'A' + 1,fw,torque,SIM_RUN_IMPACT_MS);
+    motor_init();
+    motor_toggle_lead(1);
+    script_init();
+    if(script && !script_parse(script))
+    {
+        return 2;
+    }
+    if(sim_telem)
+    {
+        /* Same header as telem_rx, and the groups, which the stream does not carry */
+        fprintf(sim_telem,"#T,time_ms,motor,powered");
+        for(int i = 0; i < TELEM_CH_COUNT; i++)
+        {
+            fprintf(sim_telem,",%s",telem_ch_name[i]);
+        }
+        fprintf(sim_telem,"\n#E,time_ms,motor,event,a,b,c\n#G,AB\n");
+    }
+
+    /* At rest, the spinup detector arms */
+    sim_run(0.5);
+    sim_status("rest");
+
+    if(script)
+    {
+        fclose(script);
+        sim_script();
+    }
+    else
+    {
+        sim_shots(fw,shots,torque,unplug);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC,&wall_end);
+    double wall = (wall_end.tv_sec - wall_start.tv_sec) + (wall_end.tv_nsec - wall_start.tv_nsec) / 1e9;
+    double sim = sim_time_us() / 1e6;
+
+    printf("\nResults:\n");
+    for(int t = 0; t < RESULTS_TYPE_COUNT; t++)
+    {
+        printf("  %-10s %3d  last %8.3f %8.3f %8.1f\n",result_names[t],sim_result_count[t],
+               sim_result_last[t][0],sim_result_last[t][1],sim_result_last[t][2]);
+    }
+    if(sim_telem)
+    {
+        fclose(sim_telem);
+    }
+    printf("Simulated %.1f s in %.3f s (%.0fx real time)\n",sim,wall,(wall > 0.0) ? sim / wall : 0.0);
+
+    if(script)
+    {
+        if(!script_completed())
+        {
+            printf("FAIL: script did not complete\n");
+            return 1;
+        }
+        if(ENDURE_FAIL == endure_state())
+        {
+            printf("FAIL: endurance run\n");
+            return 1;
+        }
+    }
+    else if(!sim_result_count[RESULTS_SPINUP_99] || sim_result_count[RESULTS_SHOT] != shots)
+    {
+        printf("FAIL: expected a spinup and %d shots\n",shots);
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,515 @@
+/* Host receiver for the binary telemetry stream
+ *
+ * telem_rx [-q] [-w capture.bin] <device>
+ *      Read frames from the V5 serial port and print them as CSV
+ * telem_rx -l[ticks]
+ *      Loopback self-test: send synthetic frames through a local pseudo-terminal
+ *      and check every frame arrives in order with a good CRC, with events and
+ *      schema frames sent while a packed block is open and one frame repeated
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "frame.h"
+#include "pack.h"
+#include "telem.h"
+
+/* Receiver state */
+static struct
+{
+    bool quiet;
+    FILE * capture;
+    /* Scales from the last schema (defaults match this build) */
+    float scale[TELEM_CH_COUNT];
+    bool have_schema;
+    bool have_seq;
+    uint16_t seq_next;
+    /* Frames seen before seq_next, bit n is seq_next - 1 - n */
+    uint32_t seq_seen;
+    /* Packed sample decoder */
+    pack_ctx_t pack;
+    /* Loopback checks decoded values against the generator */
+    bool check;
+    unsigned long mismatch;
+    /* Counters */
+    unsigned long frames;
+    unsigned long samples;
+    unsigned long events;
+    unsigned long bad;
+    unsigned long lost;
+    unsigned long dup;
+    unsigned long late;
+} rx;
+
+static float get_f32(const uint8_t * p)
+{
+    union { float f; uint32_t u; } conv;
+    conv.u = frame_get_u32(p);
+    return conv.f;
+}
+
+/* Value the loopback writer sends for tick t, motor m, channel i
+ * Chosen to contain zero bytes so COBS is exercised, with noise so deltas vary
+ */
+static int32_t lb_value(int t, int m, int i)
+{
+    static const int32_t base[TELEM_CH_COUNT] = {600, 0, 256, 12000, 0, 300};
+    int32_t noise = ((t * 7919 + m * 104729 + i * 1299709) % 61) - 30;
+    switch(i)
+    {
+    case TELEM_CH_TARGET:
+    case TELEM_CH_TEMP:
+        return base[i] + t / 500;
+    case TELEM_CH_SPEED:
+        return (t < 100 ? t * 60 : 6000) + noise;
+    default:
+        return base[i] * (m + 1) + noise;
+    }
+}
+
+/* Print or check one sample */
+static void rx_sample(uint32_t time, const telem_rec_t * rec)
+{
+    rx.samples++;
+    if(rx.check)
+    {
+        for(int i = 0; i < TELEM_CH_COUNT; i++)
+        {
+            if(rec->ch[i] != lb_value(time / 20,rec->idx,i)) rx.mismatch++;
+        }
+    }
+    if(rx.quiet) return;
+    printf("T,%u,%c,%d",time,rec->idx+'A',rec->flags & TELEM_FLAG_POWERED);
+    for(int i = 0; i < TELEM_CH_COUNT; i++)
+    {
+        printf(",%g",rec->ch[i] * rx.scale[i]);
+    }
+    printf("\n");
+}
+
+/* Handle one decoded payload */
+static void rx_payload(const uint8_t * p, int len)
+{
+    if(len < TELEM_HDR_SIZE)
+    {
+        rx.bad++;
+        return;
+    }
+    uint8_t type = p[0];
+    uint16_t seq = frame_get_u16(&p[1]);
+    uint32_t time = frame_get_u32(&p[3]);
+    const uint8_t * body = p + TELEM_HDR_SIZE;
+    int blen = len - TELEM_HDR_SIZE;
+
+    /* Sequence check, count frames we never saw
+     * Packed deltas cannot be trusted after a gap, so wait for the next keyframe
+     */
+    int16_t ahead = rx.have_seq ? (int16_t)(seq - rx.seq_next) : 0;
+    pack_ctx_t late_pack;
+    pack_ctx_t * pack = &rx.pack;
+    if(ahead < 0)
+    {
+        /* Behind the stream: a repeat, or a frame that took longer than the ones after it */
+        int back = -ahead - 1;
+        if(back < 32 && (rx.seq_seen & (1u << back)))
+        {
+            rx.dup++;
+            return;
+        }
+        rx.late++;
+        if(back < 32)
+        {
+            rx.seq_seen |= 1u << back;
+            if(rx.lost) rx.lost--;
+        }
+        /* Only a block starting on a keyframe can be decoded, and not with the live decoder */
+        pack_reset(&late_pack);
+        pack = &late_pack;
+    }
+    else
+    {
+        if(ahead > 0)
+        {
+            rx.lost += ahead;
+            pack_reset(&rx.pack);
+        }
+        rx.seq_seen = (ahead >= 31) ? 1 : (rx.seq_seen << (ahead + 1)) | 1;
+        rx.have_seq = true;
+        rx.seq_next = seq + 1;
+    }
+    rx.frames++;
+
+    switch(type)
+    {
+    case TELEM_FRAME_SCHEMA:
+        if(blen < 4 || body[0] != TELEM_VERSION || body[3] != TELEM_CH_COUNT)
+        {
+            fprintf(stderr,"telem_rx: unsupported schema (version %d)\n",blen ? body[0] : -1);
+            rx.bad++;
+            return;
+        }
+        {
+            const uint8_t * q = body + 4;
+            for(int i = 0; i < TELEM_CH_COUNT && q + 4 < p + len; i++)
+            {
+                rx.scale[i] = get_f32(q);
+                q += 4;
+                q += strnlen((const char *)q,p + len - q) + 1;
+            }
+        }
+        if(!rx.have_schema && !rx.quiet)
+        {
+            printf("#T,time_ms,motor,powered");
+            for(int i = 0; i < TELEM_CH_COUNT; i++)
+            {
+                printf(",%s",telem_ch_name[i]);
+            }
+            printf("\n#E,time_ms,motor,event,a,b,c\n");
+        }
+        rx.have_schema = true;
+        break;
+    case TELEM_FRAME_SAMPLE:
+        for(; blen >= TELEM_REC_SIZE; blen -= TELEM_REC_SIZE, body += TELEM_REC_SIZE)
+        {
+            telem_rec_t rec;
+            rec.idx = body[0];
+            rec.flags = body[1];
+            for(int i = 0; i < TELEM_CH_COUNT; i++)
+            {
+                rec.ch[i] = (int32_t)frame_get_u32(&body[2+4*i]);
+            }
+            rx_sample(time,&rec);
+        }
+        break;
+    case TELEM_FRAME_PACKED:
+        while(blen > 0)
+        {
+            telem_rec_t recs[PACK_MAX_MOTORS];
+            uint8_t count;
+            int used = pack_untick(pack,body,blen,&time,recs,&count);
+            if(used < 0)
+            {
+                /* Joined mid-stream or corrupt, the rest of the block is unusable */
+                rx.bad++;
+                break;
+            }
+            for(int r = 0; r < count; r++)
+            {
+                rx_sample(time,&recs[r]);
+            }
+            body += used;
+            blen -= used;
+        }
+        break;
+    case TELEM_FRAME_EVENT:
+        if(blen < 14)
+        {
+            rx.bad++;
+            return;
+        }
+        rx.events++;
+        if(rx.quiet) break;
+        printf("E,%u,%c,%s,%g,%g,%g\n",time,body[0]+'A',
+               body[1] < TELEM_EV_COUNT ? telem_ev_name[body[1]] : "?",
+               get_f32(&body[2]),get_f32(&body[6]),get_f32(&body[10]));
+        break;
+    default:
+        rx.bad++;
+    }
+}
+
+/* Read and decode until the stream ends */
+static void rx_run(int fd)
+{
+    uint8_t in[4096];
+    uint8_t frame[FRAME_MAX_ENCODED];
+    uint8_t payload[FRAME_MAX_PAYLOAD + 2];
+    size_t flen = 0;
+    bool overflow = false;
+
+    for(int i = 0; i < TELEM_CH_COUNT; i++)
+    {
+        rx.scale[i] = telem_ch_scale[i];
+    }
+    pack_reset(&rx.pack);
+
+    while(1)
+    {
+        ssize_t n = read(fd,in,sizeof(in));
+        if(n < 0 && errno == EINTR) continue;
+        /* EIO is how a pty reports the other side closing */
+        if(n <= 0) break;
+        if(rx.capture) fwrite(in,1,n,rx.capture);
+
+        for(ssize_t i = 0; i < n; i++)
+        {
+            if(in[i] != FRAME_DELIM)
+            {
+                if(flen < sizeof(frame)) frame[flen++] = in[i];
+                else overflow = true;
+                continue;
+            }
+            /* Delimiter, decode whatever we collected (empty runs are just padding) */
+            if(flen)
+            {
+                int len = overflow ? -1 : frame_decode(frame,flen,payload,sizeof(payload));
+                if(len < 0) rx.bad++;
+                else rx_payload(payload,len);
+            }
+            flen = 0;
+            overflow = false;
+        }
+        if(!rx.quiet) fflush(stdout);
+    }
+}
+
+/* Put a tty into raw binary mode */
+static int tty_raw(int fd)
+{
+    struct termios t;
+    if(tcgetattr(fd,&t)) return -1;
+    cfmakeraw(&t);
+    cfsetspeed(&t,B115200);
+    return tcsetattr(fd,TCSANOW,&t);
+}
+
+/* Loopback writer, mirrors the frame layout built by telem.c */
+static size_t lb_hdr(uint8_t * p, uint8_t type, uint32_t time)
+{
+    p[0] = type;
+    frame_put_u16(&p[1],0);
+    frame_put_u32(&p[3],time);
+    return TELEM_HDR_SIZE;
+}
+
+/* Numbered as it is sent, as telem_send does, copies repeats the same frame */
+static void lb_write(int fd, uint8_t * payload, size_t len, int copies)
+{
+    static uint16_t seq = 0;
+    uint8_t out[FRAME_MAX_ENCODED];
+    frame_put_u16(&payload[1],seq++);
+    size_t n = frame_encode(payload,len,out);
+    for(size_t o = 0; o < n * copies;)
+    {
+        ssize_t w = write(fd,out + o % n,n - o % n);
+        if(w < 0 && errno == EINTR) continue;
+        if(w < 0) exit(1);
+        o += w;
+    }
+}
+
+static void lb_schema(int fd, uint32_t time)
+{
+    uint8_t buf[FRAME_MAX_PAYLOAD];
+    size_t len = lb_hdr(buf,TELEM_FRAME_SCHEMA,time);
+    buf[len++] = TELEM_VERSION;
+    frame_put_u16(&buf[len],20);
+    len += 2;
+    buf[len++] = TELEM_CH_COUNT;
+    for(int i = 0; i < TELEM_CH_COUNT; i++)
+    {
+        union { float f; uint32_t u; } conv = { .f = telem_ch_scale[i] };
+        frame_put_u32(&buf[len],conv.u);
+        len += 4;
+        len += strlen(strcpy((char *)&buf[len],telem_ch_name[i])) + 1;
+    }
+    lb_write(fd,buf,len,1);
+}
+
+/* Events the writer sends, and repeats (one per run) */
+#define LB_EVENTS(ticks) ((ticks) / 50)
+#define LB_DUPS(ticks) ((ticks) >= 50 ? 1 : 0)
+
+/* First half of the ticks go out as raw sample frames, the rest as packed blocks
+ * Events and schema frames go out between the ticks of an open block, as
+ * telem.c sends them, so the block is numbered after them
+ */
+static void lb_writer(int fd, int ticks)
+{
+    uint8_t buf[FRAME_MAX_PAYLOAD];
+    pack_ctx_t pack;
+    pack_reset(&pack);
+
+    lb_schema(fd,0);
+
+    /* Ticks of 4 motors, with an event every 50 ticks and the schema every 50 */
+    size_t len = 0;
+    for(int t = 0; t < ticks; t++)
+    {
+        uint32_t time = t * 20;
+        telem_rec_t recs[4];
+        for(int m = 0; m < 4; m++)
+        {
+            recs[m].idx = m;
+            recs[m].flags = TELEM_FLAG_POWERED;
+            for(int i = 0; i < TELEM_CH_COUNT; i++)
+            {
+                recs[m].ch[i] = lb_value(t,m,i);
+            }
+        }
+
+        if(t < ticks / 2)
+        {
+            len = lb_hdr(buf,TELEM_FRAME_SAMPLE,time);
+            for(int m = 0; m < 4; m++)
+            {
+                buf[len++] = recs[m].idx;
+                buf[len++] = recs[m].flags;
+                for(int i = 0; i < TELEM_CH_COUNT; i++)
+                {
+                    frame_put_u32(&buf[len],(uint32_t)recs[m].ch[i]);
+                    len += 4;
+                }
+            }
+            lb_write(fd,buf,len,1);
+            len = 0;
+        }
+        else
+        {
+            /* Blocks of up to 5 ticks, keyframe every 50 */
+            bool key = !(t % 50);
+            if(key && len)
+            {
+                lb_write(fd,buf,len,1);
+                len = 0;
+            }
+            if(!len)
+            {
+                len = lb_hdr(buf,TELEM_FRAME_PACKED,time);
+            }
+            len += pack_tick(&pack,&buf[len],time,recs,4,key);
+            if(len + PACK_TICK_MAX > FRAME_MAX_PAYLOAD || t % 5 == 4)
+            {
+                lb_write(fd,buf,len,1);
+                len = 0;
+            }
+        }
+
+        /* Mid-block (ticks 2 and 3 of a block of 5) */
+        if(t % 50 == 47)
+        {
+            lb_schema(fd,time);
+        }
+        if(t % 50 == 48)
+        {
+            uint8_t ev[TELEM_HDR_SIZE + 14];
+            size_t elen = lb_hdr(ev,TELEM_FRAME_EVENT,time);
+            ev[elen++] = t % 4;
+            ev[elen++] = TELEM_EV_SHOT_DONE;
+            union { float f; uint32_t u; } conv;
+            conv.f = 0.25f; frame_put_u32(&ev[elen],conv.u); elen += 4;
+            conv.f = 1.5f; frame_put_u32(&ev[elen],conv.u); elen += 4;
+            conv.f = 540.0f; frame_put_u32(&ev[elen],conv.u); elen += 4;
+            lb_write(fd,ev,elen,t == 48 ? 2 : 1);
+        }
+
+        /* Stray text between frames, as the log would print */
+        if(t % 100 == 0)
+        {
+            static const char text[] = "00012.340 [INFO] in src/motor.c line 10: stray\n";
+            if(write(fd,text,sizeof(text) - 1) < 0) exit(1);
+        }
+    }
+    if(len)
+    {
+        lb_write(fd,buf,len,1);
+    }
+}
+
+static int loopback(int ticks)
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if(master < 0 || grantpt(master) || unlockpt(master))
+    {
+        perror("telem_rx: pty");
+        return 1;
+    }
+    int slave = open(ptsname(master),O_RDWR | O_NOCTTY);
+    if(slave < 0 || tty_raw(slave) || tty_raw(master))
+    {
+        perror("telem_rx: pty slave");
+        return 1;
+    }
+
+    pid_t pid = fork();
+    if(pid == 0)
+    {
+        close(master);
+        lb_writer(slave,ticks);
+        /* Let the reader drain before the pty closes */
+        tcdrain(slave);
+        close(slave);
+        _exit(0);
+    }
+    close(slave);
+    rx_run(master);
+    waitpid(pid,NULL,0);
+
+    bool pass = rx.samples == 4UL * ticks && rx.events == LB_EVENTS(ticks) && rx.dup == LB_DUPS(ticks) &&
+                !rx.late && !rx.lost && !rx.mismatch;
+    fprintf(stderr,"telem_rx: loopback %s, %lu frames, %lu/%lu samples, %lu events, %lu lost, %lu repeated, %lu late, "
+            "%lu rejected, %lu mismatched\n",pass ? "PASS" : "FAIL",rx.frames,rx.samples,4UL * ticks,rx.events,rx.lost,
+            rx.dup,rx.late,rx.bad,rx.mismatch);
+    return pass ? 0 : 1;
+}
+
+int main(int argc, char ** argv)
+{
+    int opt;
+    int ticks = -1;
+    while((opt = getopt(argc,argv,"qw:l::")) != -1)
+    {
+        switch(opt)
+        {
+        case 'q':
+            rx.quiet = true;
+            break;
+        case 'w':
+            rx.capture = fopen(optarg,"wb");
+            if(!rx.capture)
+            {
+                perror(optarg);
+                return 1;
+            }
+            break;
+        case 'l':
+            ticks = optarg ? atoi(optarg) : 5000;
+            break;
+        default:
+            fprintf(stderr,"usage: %s [-q] [-w capture.bin] <device>\n       %s -l[ticks]\n",argv[0],argv[0]);
+            return 2;
+        }
+    }
+
+    if(ticks >= 0)
+    {
+        rx.quiet = true;
+        rx.check = true;
+        return loopback(ticks);
+    }
+    if(optind >= argc)
+    {
+        fprintf(stderr,"usage: %s [-q] [-w capture.bin] <device>\n",argv[0]);
+        return 2;
+    }
+
+    /* A port or a recording copied off the SD card */
+    int fd = open(argv[optind],O_RDONLY | O_NOCTTY);
+    if(fd < 0 || (isatty(fd) && tty_raw(fd)))
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    rx_run(fd);
+    if(rx.capture) fclose(rx.capture);
+    fprintf(stderr,"telem_rx: %lu frames, %lu samples, %lu events, %lu lost, %lu repeated, %lu late, %lu rejected\n",
+            rx.frames,rx.samples,rx.events,rx.lost,rx.dup,rx.late,rx.bad);
+    return 0;
+}
@@ -0,0 +1,320 @@
+/* Host benchmark for the per-tick hot path
+ *
+ * tick_bench [-s samples] [filter]
+ *      Time the work the control and graphics tasks do every tick, on synthetic
+ *      flywheel feedback: motor sampling, the group command path, accel filter
+ *      and detectors, report formatting and the report and run tab updates.
+ *      Each case is run in batches of at least 2 ms, the median batch is reported
+ *      with the 10th and 90th percentiles, so noise from the host shows as spread
+ *      instead of moving the result. Allocations are counted by wrapping malloc
+ *      and friends at link time (calls from this program's code, not libc's own),
+ *      and log statements reaching log_check() or the deferred log are counted.
+ *      Only cases whose name contains filter are run.
+ *      make logcost builds it at each build-wide log floor (LOG_LEVEL_BUILD).
+ *
+ * The app sources are linked unchanged, PROS motor calls read the synthetic
+ * feedback and LVGL calls are no-ops (lv_stub.c), so LVGL's own redraw cost is
+ * not included.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "main.h"
+
+/* Use pal log, for the level names and the log case */
+#define LOG_LEVEL_FILE LOG_LEVEL_DEBUG
+#include "pal/log.h"
+
+#define TICK_MS 20
+/* Synthetic session length (ticks), cases cycle through it */
+#define TRACE_TICKS (30 * 1000 / TICK_MS)
+/* Shortest batch (ns) and batches per case */
+#define BATCH_NS 2e6
+#define SAMPLES_DEFAULT 31
+
+/* Time step, as main.c sets it */
+double dt = TICK_MS / 1000.0;
+
+/* Synthetic feedback of every port, one tick of the trace per entry */
+typedef struct
+{
+    bool powered;
+    double speed;
+    double curr;
+    double volt;
+    double power;
+    double temp;
+} fb_t;
+static fb_t trace[TRACE_TICKS][NUM_MOTORS];
+/* Feedback the motor calls return */
+static const fb_t * fb = trace[0];
+
+/* Allocation counts, from the --wrap'd allocator */
+static long allocs = 0;
+void * __real_malloc(size_t size);
+void * __real_calloc(size_t n, size_t size);
+void * __real_realloc(void * p, size_t size);
+void * __wrap_malloc(size_t size) { allocs++; return __real_malloc(size); }
+void * __wrap_calloc(size_t n, size_t size) { allocs++; return __real_calloc(n,size); }
+void * __wrap_realloc(void * p, size_t size) { allocs++; return __real_realloc(p,size); }
+
+/* Deterministic noise */
+static uint32_t rng = 12345;
+static double noise(double amp)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return ((double)(rng % 20001) / 10000.0 - 1.0) * amp;
+}
+
+/* Spin up, hold with a shot every 2 s, spin down: every detector branch is taken in one pass */
+static void generate()
+{
+    double speed[NUM_MOTORS] = {0}, temp[NUM_MOTORS] = {25, 26, 25, 27};
+    for(int t = 0; t < TRACE_TICKS; t++)
+    {
+        double cycle = t * TICK_MS / 1000.0;
+        bool powered = cycle > 1.0 && cycle < 20.0;
+        bool shot = powered && cycle > 6.0 && fmod(cycle,2.0) < TICK_MS / 1000.0;
+        for(int m = 0; m < NUM_MOTORS; m++)
+        {
+            fb_t * f = &trace[t][m];
+            double target = powered ? 600 : 0;
+            speed[m] += (target - speed[m]) * 0.08;
+            if(shot) speed[m] *= 0.85;
+            double err = target - speed[m];
+            f->powered = powered;
+            f->speed = speed[m] + noise(1.5);
+            f->curr = powered ? fmin(2.5,0.35 + fabs(err) * 0.02) : 0.0;
+            f->volt = powered ? fmin(12.0,speed[m] / 600.0 * 11.0 + f->curr * 0.6) : 0.0;
+            f->power = f->curr * f->volt;
+            temp[m] += f->curr * f->curr * 0.0005 - (temp[m] - 25) * 0.0002;
+            f->temp = floor(temp[m] / 5.0) * 5.0;
+        }
+    }
+}
+
+/* PROS motor calls on the synthetic feedback, ports 1-4 are motors A-D */
+int32_t motor_set_brake_mode(uint8_t port, const motor_brake_mode_e_t mode) { return 1; }
+int32_t motor_brake(uint8_t port) { return 1; }
+int32_t motor_set_gearing(uint8_t port, const motor_gearset_e_t gearset) { return 1; }
+int32_t motor_move_velocity(uint8_t port, const int32_t velocity) { return 1; }
+double motor_get_actual_velocity(uint8_t port) { return fb[port-1].speed; }
+int32_t motor_get_current_draw(uint8_t port) { return (int32_t)(fb[port-1].curr * 1000.0); }
+int32_t motor_get_voltage(uint8_t port) { return (int32_t)(fb[port-1].volt * 1000.0); }
+double motor_get_temperature(uint8_t port) { return fb[port-1].temp; }
+double motor_get_power(uint8_t port) { return fb[port-1].power; }
+uint32_t millis(void) { return 0; }
+
+/* The rest of the app, out of the measurement */
+static long dlog_calls = 0;
+static long log_calls = 0;
+FILE * fd = NULL;
+volatile log_level_t log_level_runtime = LOG_LEVEL_DEBUG;
+int log_check(const char * fname, const int line, log_level_t level, log_level_t flevel) { log_calls++; return 0; }
+void dlog_write(const char * file, int line, int level, int flevel, const char * fmt, int nargs, uint32_t types, ...) { dlog_calls++; }
+void telem_sample(uint8_t idx, bool powered, int32_t target) {}
+void telem_event(uint8_t idx, telem_event_t ev, float a, float b, float c) {}
+void results_add(uint8_t motor, results_type_t type, float a, float b, float c) {}
+void dash_speed(uint8_t idx, int16_t target, int16_t speed) {}
+void dash_shot(uint8_t idx, float time, float min_pct) {}
+void endure_shot(uint8_t lead, float time) {}
+bool msg_ctrl_post(msg_ctrl_type_t type, uint8_t motor, int16_t arg) { return true; }
+int8_t ports_next_free(uint8_t idx) { return -1; }
+void ports_init(int8_t * ports) { for(int i = 0; i < NUM_MOTORS; i++) ports[i] = i + 1; }
+
+/* The report tab's refresh task, from lv_stub.c */
+extern void (*lv_stub_task)(void *);
+extern void * lv_stub_task_param;
+static void (*report_refresh)(void *);
+
+
+/* Point the motor calls at tick n of the trace, with the leaders' power */
+static void feed(long n)
+{
+    fb = trace[n % TRACE_TICKS];
+    motors[0].powered = fb[0].powered;
+    motors[2].powered = fb[2].powered;
+}
+
+/* Cases, each is one operation */
+static void case_tick(long n)
+{
+    feed(n);
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        motor_sample(i);
+    }
+    group_update();
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        group_run(i);
+    }
+}
+
+static void case_sample(long n)
+{
+    feed(n);
+    motor_sample(0);
+}
+
+static void case_group(long n)
+{
+    feed(n);
+    for(int i = 0; i < 2; i++)
+    {
+        motors[i].data.speed = fb[i].speed;
+        motors[i].data.curr = fb[i].curr;
+        motors[i].data.power = fb[i].power;
+    }
+    group_run(0);
+}
+
+static void case_report_ev(long n)
+{
+    REPORT_EV(0,REPORT_EV_SHOT,"GRP %s: Shot Complete, Took %1.2f sec (%1.3f J)","AB",(n % 100) * 0.01,(n % 1000) * 0.013);
+}
+
+static void case_report_print(long n)
+{
+    report_print("MTR A: Arming Spinup Detector");
+}
+
+static void case_report_rows(long n)
+{
+    report_print("MTR A: Arming Spinup Detector");
+    report_refresh(lv_stub_task_param);
+}
+
+/* A debug statement in a hot path, as in the detectors */
+static void case_log_debug(long n)
+{
+    LOG_DEBUG("MOTOR %c: Sample %d rpm, %f A",'A' + (int)(n & 3),(int)(n % 600),(n % 2500) * 0.001);
+}
+
+static void case_run_speeds(long n)
+{
+    run_update_speeds(0,600,(int)(n % 64) + 560);
+}
+
+static void case_run_speeds_same(long n)
+{
+    run_update_speeds(0,600,590);
+}
+
+typedef struct
+{
+    const char * name;
+    void (*fn)(long);
+    /* Per motor results are the operation divided by this */
+    int motors;
+} bench_case_t;
+
+static const bench_case_t cases[] =
+{
+    {"tick",              case_tick,            NUM_MOTORS},
+    {"motor_sample",      case_sample,          1},
+    {"group_run",         case_group,           2},
+    {"report_ev",         case_report_ev,       0},
+    {"report_print",      case_report_print,    0},
+    {"report_print_rows", case_report_rows,     0},
+    {"log_debug",         case_log_debug,       0},
+    {"run_speeds",        case_run_speeds,      0},
+    {"run_speeds_same",   case_run_speeds_same, 0},
+};
+
+static double now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static int cmp_double(const void * a, const void * b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void run_case(const bench_case_t * c, int samples)
+{
+    /* Warm up, then size batches to BATCH_NS */
+    long n = 0;
+    long batch = 1;
+    for(;;)
+    {
+        double t0 = now_ns();
+        for(long i = 0; i < batch; i++) c->fn(n++);
+        if(now_ns() - t0 >= BATCH_NS) break;
+        batch *= 2;
+    }
+
+    double * ns = malloc(sizeof(double) * samples);
+    long allocs_start = allocs;
+    long logs_start = log_calls + dlog_calls;
+    for(int s = 0; s < samples; s++)
+    {
+        double t0 = now_ns();
+        for(long i = 0; i < batch; i++) c->fn(n++);
+        ns[s] = (now_ns() - t0) / batch;
+    }
+    double per_alloc = (double)(allocs - allocs_start) / ((double)batch * samples);
+    double per_log = (double)(log_calls + dlog_calls - logs_start) / ((double)batch * samples);
+    qsort(ns,samples,sizeof(double),cmp_double);
+    double med = ns[samples / 2];
+    printf("%-18s %9.1f %9.1f %9.1f %8.2f %8.3f",c->name,med,ns[samples / 10],ns[samples - 1 - samples / 10],per_alloc,per_log);
+    if(c->motors)
+    {
+        printf(" %9.1f",med / c->motors);
+    }
+    printf("\n");
+    free(ns);
+}
+
+int main(int argc, char ** argv)
+{
+    int samples = SAMPLES_DEFAULT;
+    int opt;
+    while((opt = getopt(argc,argv,"s:")) != -1)
+    {
+        if('s' == opt)
+        {
+            samples = atoi(optarg);
+        }
+        else
+        {
+            fprintf(stderr,"usage: %s [-s samples] [filter]\n",argv[0]);
+            return 2;
+        }
+    }
+    if(samples < 3) samples = 3;
+    const char * filter = optind < argc ? argv[optind] : "";
+
+    /* Two groups, B follows A and D follows C, drawn tabs */
+    generate();
+    motor_init();
+    motor_toggle_lead(1);
+    motor_toggle_lead(3);
+    group_update();
+    lv_obj_t * page = lv_page_create(NULL,NULL);
+    run_draw(page);
+    report_draw(page);
+    report_refresh = lv_stub_task;
+
+    printf("%-18s %9s %9s %9s %8s %8s %9s\n","case","ns/op","p10","p90","allocs","logs","ns/motor");
+    for(unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        if(strstr(cases[i].name,filter))
+        {
+            run_case(&cases[i],samples);
+        }
+    }
+    printf("%d batches per case, %ld deferred log calls, %ld log_check calls\n",samples,dlog_calls,log_calls);
+    return 0;
+}
@@ -0,0 +1,43 @@
+/* Dashboard on the V5 controller screen
+ * Shows the selected leader's target and actual speed, its last shot
+ * recovery, and the speeds of the other leaders, and takes commands from
+ * the buttons:
+ *  LEFT/RIGHT  select leader
+ *  A           toggle power
+ *  UP/DOWN     change target speed
+ *  X           start test
+ *  B           show the best result in place of the last shot
+ *  L1          toggle the binary telemetry stream
+ * The controller takes about one text update per 50 ms, so each slot
+ * rewrites only the changed characters of the most important dirty line.
+ */
+#ifndef _DASH_H_
+#define _DASH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Controller screen size */
+#define DASH_LINES 3
+#define DASH_COLS 15
+/* Update slot (ms), one controller_set_text per slot */
+#define DASH_PERIOD 50
+/* Best result shown: 95% spinups built in the last week within this many rpm of the target */
+#define DASH_BEST_DAYS 7
+#define DASH_BEST_TOL 10
+
+/* Start the dashboard task */
+void dash_init();
+
+/* Latest values from the control task */
+void dash_speed(uint8_t idx, int16_t target, int16_t speed);
+void dash_shot(uint8_t idx, float time, float min_pct);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _DASH_H_ */
@@ -0,0 +1,81 @@
+/* Deferred-formatting logger
+ * LOG_* calls in files that define LOG_DEFERRED before including pal/log.h
+ * record the format string pointer, file/line and raw arguments into a
+ * lock-free ring. The dlog task formats and prints them later, so the
+ * calling task only pays for copying the arguments.
+ *
+ * The format string and file name must be literals (they are kept by pointer).
+ * String arguments are copied into the record, up to DLOG_STR_BYTES in total.
+ * The log header time is when the record is printed, normally within
+ * DLOG_PERIOD of the call.
+ */
+#ifndef _DLOG_H_
+#define _DLOG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Ring size in records, must be a power of 2 */
+#define DLOG_RING_SIZE 64
+/* Most arguments per call */
+#define DLOG_MAX_ARGS 8
+/* Bytes of string argument storage per record */
+#define DLOG_STR_BYTES 48
+/* Period of the formatting task (ms) */
+#define DLOG_PERIOD 10
+
+/* Argument type codes, 3 bits each in the types word */
+#define DLOG_T_INT 0
+#define DLOG_T_LONG 1
+#define DLOG_T_LL 2
+#define DLOG_T_DBL 3
+#define DLOG_T_STR 4
+#define DLOG_T_PTR 5
+
+#define DLOG_T(x) _Generic((x),                     \
+    long: DLOG_T_LONG, unsigned long: DLOG_T_LONG,  \
+    long long: DLOG_T_LL, unsigned long long: DLOG_T_LL, \
+    float: DLOG_T_DBL, double: DLOG_T_DBL,          \
+    char *: DLOG_T_STR, const char *: DLOG_T_STR,   \
+    void *: DLOG_T_PTR, const void *: DLOG_T_PTR,   \
+    default: DLOG_T_INT)
+
+/* Count arguments (0 to 8) */
+#define DLOG_NARGS(...) DLOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, N, ...) N
+
+/* Pack the type codes of all arguments into one constant */
+#define DLOG_CAT(a, b) DLOG_CAT_(a, b)
+#define DLOG_CAT_(a, b) a##b
+#define DLOG_TYPES(...) DLOG_CAT(DLOG_TYPES_, DLOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+#define DLOG_TYPES_0(...) 0
+#define DLOG_TYPES_1(a) DLOG_T(a)
+#define DLOG_TYPES_2(a, ...) (DLOG_T(a) | DLOG_TYPES_1(__VA_ARGS__) << 3)
+#define DLOG_TYPES_3(a, ...) (DLOG_T(a) | DLOG_TYPES_2(__VA_ARGS__) << 3)
+#define DLOG_TYPES_4(a, ...) (DLOG_T(a) | DLOG_TYPES_3(__VA_ARGS__) << 3)
+#define DLOG_TYPES_5(a, ...) (DLOG_T(a) | DLOG_TYPES_4(__VA_ARGS__) << 3)
+#define DLOG_TYPES_6(a, ...) (DLOG_T(a) | DLOG_TYPES_5(__VA_ARGS__) << 3)
+#define DLOG_TYPES_7(a, ...) (DLOG_T(a) | DLOG_TYPES_6(__VA_ARGS__) << 3)
+#define DLOG_TYPES_8(a, ...) (DLOG_T(a) | DLOG_TYPES_7(__VA_ARGS__) << 3)
+
+/* Record a log call, level and flevel as in log_check() */
+#define DLOG(level, fmt, ...) dlog_write(__FILE__, __LINE__, level, LOG_LEVEL_FILE, fmt, \
+    DLOG_NARGS(__VA_ARGS__), DLOG_TYPES(__VA_ARGS__), ##__VA_ARGS__)
+
+/* Start the formatting task */
+void dlog_init();
+
+/* Record one call, normally used through the DLOG/LOG_* macros */
+void dlog_write(const char * file, int line, int level, int flevel, const char * fmt, int nargs, uint32_t types, ...);
+
+/* Records dropped because the ring was full */
+uint32_t dlog_get_dropped();
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _DLOG_H_ */
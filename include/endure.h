@@ -0,0 +1,60 @@
+/* Endurance runs
+ * A test script (script.h) plays a match-style schedule of spinning, idling
+ * and fed balls, and an endurance run measures how the group holds up over
+ * it. Started by the endure step with a target recovery time, it collects
+ * per minute of the run:
+ *  - balls fed and shots detected, a ball fed while the wheel was still
+ *    recovering from the last one is not detected and counts as missed
+ *  - average and worst shot recovery time, and the average against the first
+ *    minute's (degradation)
+ *  - energy used by the group
+ *  - hottest member at the end of the minute (thermal.h)
+ *  - lowest battery voltage, and its drop from the start of the run
+ * Each minute is reported and logged (ENDURE: lines), and when the run ends
+ * it passes if no ball was missed and every minute's average recovery was
+ * within the target.
+ */
+#ifndef _ENDURE_H_
+#define _ENDURE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Summary period (s) */
+#define ENDURE_PERIOD 60.0
+
+typedef enum
+{
+    ENDURE_NONE,
+    ENDURE_RUNNING,
+    ENDURE_PASS,
+    ENDURE_FAIL
+} endure_state_t;
+
+/* Start a run on the group led by lead, ending one that is running */
+void endure_start(uint8_t lead, float target);
+
+/* End the run, if one is running, summarizing the last part minute and giving the verdict */
+void endure_stop();
+
+/* Collecting, or the verdict of the last run */
+endure_state_t endure_state();
+
+/* Control task, once per tick while a script runs */
+void endure_tick();
+
+/* A ball was fed */
+void endure_feed();
+
+/* The shot detector saw a group recover from a shot (s) */
+void endure_shot(uint8_t lead, float time);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _ENDURE_H_ */
@@ -0,0 +1,66 @@
+/* Binary frame codec (COBS framing with CRC16)
+ * This module has no PROS dependencies so it can also be built into host tools
+ */
+#ifndef _FRAME_H_
+#define _FRAME_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Largest payload carried by a single frame (not including CRC) */
+#define FRAME_MAX_PAYLOAD 240
+
+/* Worst case encoded size: leading delimiter, COBS overhead, CRC, trailing delimiter */
+#define FRAME_MAX_ENCODED (FRAME_MAX_PAYLOAD + 2 + (FRAME_MAX_PAYLOAD + 2) / 254 + 1 + 2)
+
+/* Frame delimiter byte, never appears inside an encoded frame */
+#define FRAME_DELIM 0x00
+
+/* CRC16-CCITT (poly 0x1021, init 0xFFFF) over a buffer */
+uint16_t frame_crc16(const uint8_t * buf, size_t len);
+
+/* Encode a payload into a delimited frame
+ * Output is DELIM, COBS(payload + crc16 little endian), DELIM
+ * out must hold at least FRAME_MAX_ENCODED bytes, returns number of bytes written (0 on error)
+ */
+size_t frame_encode(const uint8_t * payload, size_t len, uint8_t * out);
+
+/* Decode the bytes between two delimiters back into a payload
+ * out needs room for the payload plus the 2 CRC bytes (FRAME_MAX_PAYLOAD + 2 is always enough)
+ * Returns payload length (CRC removed), or -1 if the frame is malformed or the CRC fails
+ */
+int frame_decode(const uint8_t * in, size_t len, uint8_t * out, size_t out_max);
+
+/* Little endian field helpers used to build and parse payloads */
+static inline uint8_t * frame_put_u16(uint8_t * p, uint16_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    return p + 2;
+}
+static inline uint8_t * frame_put_u32(uint8_t * p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+    return p + 4;
+}
+static inline uint16_t frame_get_u16(const uint8_t * p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+static inline uint32_t frame_get_u32(const uint8_t * p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _FRAME_H_ */
@@ -0,0 +1,85 @@
+/* Motor groups
+ * A group is a leader and every motor following it, driving one flywheel.
+ * Membership comes from the leader fields set on the config tab, so a group
+ * can have any number of the motor slots. Each control tick every motor is
+ * sampled (motor_sample), then each group runs once (group_run):
+ *  - one command path sends the leader's power and target to every member
+ *  - member samples are combined, speed averaged and current, power and
+ *    energy summed, over the members with valid samples
+ *  - the spinup, shot and runtime power detectors run on the combined values
+ * Events, reports and results of a group carry the leader's index.
+ */
+#ifndef _GROUP_H_
+#define _GROUP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct
+{
+    /* Members, leader first, none if the slot is not a configured leader */
+    uint8_t count;
+    uint8_t members[NUM_MOTORS];
+    /* Members with valid samples (bit per motor), a change restarts the detectors */
+    uint8_t valid;
+    /* Member letters, for reports */
+    char name[NUM_MOTORS+1];
+    /* Combined samples */
+    struct
+    {
+        /* Average RPM */
+        double speed;
+        /* Sum of Amps */
+        double curr;
+        /* Sum of Watts */
+        double power;
+        /* Average accel (rpm/s) */
+        double accel;
+        /* Filtered accel (rpm/s) */
+        double accel_filt;
+        /* Data collected during a spinup */
+        struct
+        {
+            bool armed;
+            double energy;
+            double time;
+            double speed_max;
+            /* Hottest member at the start (C) */
+            double temp;
+        } spinup;
+        /* Data collected during a single shot */
+        struct
+        {
+            bool armed;
+            bool inprog;
+            double energy;
+            double time;
+            double min_speed;
+        } shot;
+        /* Data collected during a run */
+        struct
+        {
+            double energy;
+            double time;
+        } run;
+    } data;
+} group_t;
+
+/* Groups by leader index */
+extern group_t groups[NUM_MOTORS];
+
+/* Rebuild membership from the leader fields, control task, once per tick before group_run */
+void group_update();
+
+/* Command, combine and detect for the group led by idx */
+void group_run(uint8_t idx);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _GROUP_H_ */
@@ -89,15 +89,61 @@ void opcontrol(void);
 /* Motors */
 #include "motor.h"
 
+/* Motor groups */
+#include "group.h"
+
+/* Motor thermal model */
+#include "thermal.h"
+
 /* Run tab */
 #include "run.h"
 
 /* Report tab */
 #include "report.h"
 
+/* Telemetry stream */
+#include "telem.h"
+
+/* Deferred logger */
+#include "dlog.h"
+
+/* Test result store */
+#include "results.h"
+
+/* Strip chart on the log tab */
+#include "plot.h"
+
+/* Control/graphics task messages */
+#include "msg.h"
+
+/* Widget update cache */
+#include "view.h"
+
+/* UI cost profiler */
+#include "uiprof.h"
+
+/* Hot path span profiler */
+#include "prof.h"
+
+/* RTOS task monitor */
+#include "taskmon.h"
+
+/* Scripted test sequences */
+#include "script.h"
+
+/* Endurance runs */
+#include "endure.h"
+
+/* Controller dashboard */
+#include "dash.h"
+
+/* Smart port discovery */
+#include "ports.h"
+
 /* Other draw functions */
 void config_draw(lv_obj_t * page);
-void log_draw(lv_obj_t * page);
+void config_update(uint8_t idx);
+void config_redraw(uint8_t idx);
 void ctrl_draw(lv_obj_t * page);
 
 /* Time step */
@@ -56,6 +56,10 @@ typedef struct
     /* Feedback data */
     struct
     {
+        /* Samples are current, false once the motor has stopped answering for MOTOR_LOST_TIME */
+        bool valid;
+        /* Time the motor has not answered (s) */
+        double missed;
         /* RPM */
         double speed;
         /* Amps */
@@ -66,35 +70,7 @@ typedef struct
         double power;
         /* deg C */
         double temp;
-        /* Accel (rpm/s) */
-        double accel;
-        /* Filtered accel (rpm/s) */
-        double accel_filt;
-        /* Data collected during a spinup */
-        struct
-        {
-            bool armed;
-            double energy;
-            double time;
-            double speed_max;
-        } spinup;        
-        /* Data collected during a a single shot */
-        struct
-        {
-            bool armed;
-            bool inprog;
-            double energy;
-            double time;
-            double min_speed;
-        } shot;
-
-        /* Data collected during a run */
-        struct
-        {
-            double energy;
-            double time;
-        } run;
-        
+        /* Detectors run on the group's combined samples, see group.h */
     } data;
     
 } motor_t;
@@ -102,13 +78,31 @@ typedef struct
 
 /* Global instances of our motors */
 #define NUM_MOTORS 4
+
+/* A motor that stops answering for longer than this (s) is treated as unplugged,
+ * shorter gaps (a flaky cable) are bridged by holding its last sample
+ */
+#define MOTOR_LOST_TIME 0.5
+/* Speed passed to the displays while a motor's samples are invalid */
+#define MOTOR_SPEED_INVALID INT16_MIN
 extern motor_t motors[NUM_MOTORS];
 
 /* Functions to operate on motors */
 void motor_init();
 void motor_inc(uint8_t idx, int8_t direction);
 void motor_reset_max(uint8_t idx);
-void motor_run(uint8_t idx);
+int motor_max_speed(uint8_t idx);
+void motor_sample(uint8_t idx);
+void motor_command(uint8_t idx, bool powered, int target);
+
+/* Configuration changes, only called from the control task (see msg.h) */
+void motor_toggle_power(uint8_t idx);
+void motor_toggle_reverse(uint8_t idx);
+void motor_next_gearset(uint8_t idx);
+void motor_toggle_lead(uint8_t idx);
+void motor_start_test(uint8_t idx);
+void motor_attach(uint8_t idx, int8_t port);
+void motor_next_port(uint8_t idx);
 
 
 #ifdef __cplusplus
@@ -0,0 +1,84 @@
+/* Messages between the control task and the graphics task
+ * Button callbacks run in the LVGL task and must not change motors[]
+ * while the control task is using it, and the control task must not touch
+ * LVGL objects while they are being rendered. Instead each side posts
+ * messages to the other and applies the ones it receives in its own task:
+ *  - control messages (configuration changes) are applied at the start of a control tick
+ *  - UI messages (display updates) are applied by an lv_task in the graphics task
+ * Posting never blocks, a full queue drops the message.
+ */
+#ifndef _MSG_H_
+#define _MSG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Queue depths */
+#define MSG_CTRL_QUEUE_LEN 16
+/* Period of the graphics side (ms), speeds are coalesced to one update per motor per period
+ * so there is no point running faster than the display refreshes
+ */
+#define MSG_UI_PERIOD LV_REFR_PERIOD
+/* UI queue must hold a period of speed updates at the fastest control rate (10 ms) */
+#define MSG_UI_QUEUE_LEN (NUM_MOTORS * (MSG_UI_PERIOD / 10) + 16)
+
+/* Configuration changes, applied by the control task */
+typedef enum
+{
+    MSG_CTRL_POWER,     /* Toggle power */
+    MSG_CTRL_SPEED,     /* Change target speed, arg is the direction */
+    MSG_CTRL_LEAD,      /* Toggle leader/follower */
+    MSG_CTRL_REVERSE,   /* Toggle reversed */
+    MSG_CTRL_GEAR,      /* Next gearset */
+    MSG_CTRL_PORT,      /* Change port */
+    MSG_CTRL_TEST,      /* Start a spinup test */
+    MSG_CTRL_ATTACH,    /* Newly plugged motor for a free slot, arg is the port */
+    MSG_CTRL_SCRIPT,    /* Start or stop the test script */
+    MSG_CTRL_TELEM,     /* Toggle the binary telemetry stream, not for a motor */
+    MSG_CTRL_COUNT
+} msg_ctrl_type_t;
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t motor;
+    int16_t arg;
+} msg_ctrl_t;
+
+/* Display updates, applied by the graphics task */
+typedef enum
+{
+    MSG_UI_SPEED,       /* Speed labels, with the values to show */
+    MSG_UI_RUN,         /* Power button styles of every motor */
+    MSG_UI_CONFIG,      /* Configuration buttons of one motor */
+    MSG_UI_MOTOR,       /* Redraw the pages of one motor, its port changed */
+    MSG_UI_COUNT
+} msg_ui_type_t;
+
+typedef struct
+{
+    uint8_t type;
+    uint8_t motor;
+    int16_t target;
+    int16_t speed;
+} msg_ui_t;
+
+/* Create the queues and start the graphics side */
+void msg_init();
+
+/* Post a message, false if the queue was full */
+bool msg_ctrl_post(msg_ctrl_type_t type, uint8_t motor, int16_t arg);
+bool msg_ui_post(msg_ui_type_t type, uint8_t motor, int16_t target, int16_t speed);
+
+/* Apply all waiting control messages, called by the control task once per tick */
+void msg_ctrl_apply();
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _MSG_H_ */
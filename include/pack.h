@@ -0,0 +1,74 @@
+/* Delta/varint compression of telemetry sample records
+ * This module has no PROS dependencies so it can also be built into host tools
+ *
+ * A packed block is a sequence of ticks. Each tick is:
+ *   tick byte:  bit 7 keyframe, bits 0-6 mask of motors present (one record each, ascending idx)
+ *   time:       keyframe - absolute ms (varint), otherwise zig-zag of the change in tick period
+ *   records:    header byte (bits 0-5 channel mask, bit 6 flags byte follows), [flags], channels
+ * Channels in the mask are zig-zag varints, absolute in a keyframe or for a motor that
+ * was not in the previous tick (lost or just plugged in), otherwise the delta from the
+ * previous sample of that motor. Channels left out of the mask did not change.
+ * Decoding can start at any keyframe tick.
+ */
+#ifndef _PACK_H_
+#define _PACK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "telem.h"
+
+/* Most motors a tick can carry (bits in the tick mask) */
+#define PACK_MAX_MOTORS 7
+
+/* Worst case bytes for one record and one tick */
+#define PACK_REC_MAX (2 + 5 * TELEM_CH_COUNT)
+#define PACK_TICK_MAX (1 + 5 + PACK_MAX_MOTORS * PACK_REC_MAX)
+
+/* Tick byte flags */
+#define PACK_TICK_KEY 0x80
+#define PACK_TICK_MASK 0x7F
+
+/* Record header flags */
+#define PACK_REC_FLAGS 0x40
+#define PACK_REC_MASK 0x3F
+
+/* Codec state, one per stream direction */
+typedef struct
+{
+    /* False until a keyframe has been coded */
+    bool valid;
+    /* Motors in the last tick */
+    uint8_t mask;
+    uint32_t time;
+    int32_t period;
+    struct
+    {
+        uint8_t flags;
+        int32_t ch[TELEM_CH_COUNT];
+    } motor[PACK_MAX_MOTORS];
+} pack_ctx_t;
+
+/* Forget all history, the next tick must be a keyframe */
+void pack_reset(pack_ctx_t * ctx);
+
+/* Encode one tick of count records (ascending idx) into out (PACK_TICK_MAX bytes)
+ * A keyframe is forced if the context has no history. Returns bytes written.
+ */
+size_t pack_tick(pack_ctx_t * ctx, uint8_t * out, uint32_t time, const telem_rec_t * recs, uint8_t count, bool key);
+
+/* Decode one tick from in, filling recs (PACK_MAX_MOTORS entries) and count
+ * Returns bytes consumed, or -1 if the data is malformed or starts before a keyframe
+ */
+int pack_untick(pack_ctx_t * ctx, const uint8_t * in, size_t len, uint32_t * time, telem_rec_t * recs, uint8_t * count);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _PACK_H_ */
@@ -44,14 +44,36 @@ typedef enum
  **/
 
 
+/* Compile-time floor for every file, statements below it (or below LOG_LEVEL_FILE)
+ * are removed at build time. Set from the build, e.g. EXTRA_CFLAGS=-DLOG_LEVEL_BUILD=LOG_LEVEL_INFO
+ */
+#ifndef LOG_LEVEL_BUILD
+#define LOG_LEVEL_BUILD LOG_LEVEL_DEBUG
+#endif
+
+/* True at compile time if a statement at level survives both floors */
+#define LOG_ENABLED(level) ((level) >= LOG_LEVEL_BUILD && (level) >= LOG_LEVEL_FILE)
+
+/* Runtime threshold for statements that survive the compile-time floors
+ * Raising it skips even the log_check() call, e.g. to quiet a test run
+ */
+extern volatile log_level_t log_level_runtime;
+
 /* Functions to print a message at the specified log levels
  * The funtion will print if the given file is set to log at or above this level
+ * If the file defines LOG_DEFERRED, calls are recorded and formatted later by the dlog task
  */
-#define LOG_ALWAYS(...) do{switch(log_check(__FILE__,__LINE__,LOG_LEVEL_ALWAYS,LOG_LEVEL_FILE)){case 2: fprintf(fd,__VA_ARGS__); case 1: printf(__VA_ARGS__);printf("\n");}}while(0)
-#define LOG_ERROR(...) do{switch(log_check(__FILE__,__LINE__,LOG_LEVEL_ERROR,LOG_LEVEL_FILE)){case 2: fprintf(fd,__VA_ARGS__); case 1: printf(__VA_ARGS__);printf("\n");}}while(0)
-#define LOG_WARN(...) do{switch(log_check(__FILE__,__LINE__,LOG_LEVEL_WARN,LOG_LEVEL_FILE)){case 2: fprintf(fd,__VA_ARGS__); case 1: printf(__VA_ARGS__);printf("\n");}}while(0)
-#define LOG_INFO(...) do{switch(log_check(__FILE__,__LINE__,LOG_LEVEL_INFO,LOG_LEVEL_FILE)){case 2: fprintf(fd,__VA_ARGS__); case 1: printf(__VA_ARGS__);printf("\n");}}while(0)
-#define LOG_DEBUG(...) do{switch(log_check(__FILE__,__LINE__,LOG_LEVEL_DEBUG,LOG_LEVEL_FILE)){case 2: fprintf(fd,__VA_ARGS__); case 1: printf(__VA_ARGS__);printf("\n");}}while(0)
+#ifdef LOG_DEFERRED
+#include "dlog.h"
+#define LOG_EMIT(level,...) do{if(LOG_ENABLED(level) && (level) >= log_level_runtime){DLOG(level,__VA_ARGS__);}}while(0)
+#else
+#define LOG_EMIT(level,...) do{if(LOG_ENABLED(level) && (level) >= log_level_runtime){switch(log_check(__FILE__,__LINE__,level,LOG_LEVEL_FILE)){case 2: fprintf(fd,__VA_ARGS__); case 1: printf(__VA_ARGS__);printf("\n");}}}while(0)
+#endif
+#define LOG_ALWAYS(...) LOG_EMIT(LOG_LEVEL_ALWAYS,__VA_ARGS__)
+#define LOG_ERROR(...) LOG_EMIT(LOG_LEVEL_ERROR,__VA_ARGS__)
+#define LOG_WARN(...) LOG_EMIT(LOG_LEVEL_WARN,__VA_ARGS__)
+#define LOG_INFO(...) LOG_EMIT(LOG_LEVEL_INFO,__VA_ARGS__)
+#define LOG_DEBUG(...) LOG_EMIT(LOG_LEVEL_DEBUG,__VA_ARGS__)
 
 /* Initialize the logger module, it then operates from its own task */
 void log_init();
@@ -0,0 +1,51 @@
+/* Live strip chart on the LOG tab
+ * Samples from every control tick are reduced into min/max buckets for
+ * each time span, so the chart always draws the same number of points
+ * no matter the sample rate. Each bucket becomes two points (its min and
+ * max, in the order they happened) so short dips such as a shot are
+ * never averaged away.
+ */
+#ifndef _PLOT_H_
+#define _PLOT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "api.h"
+
+/* Buckets per span, the chart draws two points per bucket */
+#define PLOT_BUCKETS 60
+#define PLOT_POINTS (PLOT_BUCKETS * 2)
+/* Chart refresh period (ms) */
+#define PLOT_PERIOD 100
+
+/* Plotted quantities */
+typedef enum
+{
+    PLOT_CH_SPEED,  /* rpm */
+    PLOT_CH_CURR,   /* mA */
+    PLOT_CH_POWER,  /* 0.1 W */
+    PLOT_CH_COUNT
+} plot_ch_t;
+
+/* Selectable time spans */
+typedef enum
+{
+    PLOT_SPAN_5S,
+    PLOT_SPAN_30S,
+    PLOT_SPAN_2M,
+    PLOT_SPAN_COUNT
+} plot_span_t;
+
+/* Draw the LOG page */
+void plot_draw(lv_obj_t * page);
+
+/* Add the current motor data, called once per control tick after the motors run */
+void plot_tick();
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _PLOT_H_ */
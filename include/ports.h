@@ -0,0 +1,38 @@
+/* Smart port discovery
+ * Motor slots (A-D) are assigned from one pass over the device registry.
+ * The assignment is cached on the SD card, so a motor keeps its letter
+ * across boots while it stays on the same port, and a motor plugged in
+ * later takes a free slot instead of shuffling the others. Edit the file to
+ * pin a port to a letter, lines are "<letter> <port>".
+ * A background task rescans the registry, logs motors unplugged and plugged
+ * back in, and attaches motors plugged into new ports while the program
+ * runs, through the control messages (see msg.h). A slot keeps its port
+ * while its motor is unplugged, until it is moved from the config tab.
+ */
+#ifndef _PORTS_H_
+#define _PORTS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/* Smart ports on the brain */
+#define PORTS_COUNT 21
+/* Assignment cache */
+#define PORTS_FILE "/usd/ports.txt"
+/* Rescan period (ms) */
+#define PORTS_RESCAN_PERIOD 1000
+
+/* Fill ports[NUM_MOTORS] with the port of each motor slot (-1 if none) and start the rescan task */
+void ports_init(int8_t * ports);
+
+/* Give a slot the next motor port without a slot, -1 if there is none */
+int8_t ports_next_free(uint8_t idx);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _PORTS_H_ */
@@ -0,0 +1,90 @@
+/* Hot path span profiler
+ * PROF_BEGIN/PROF_END bracket a region of a task's loop with micros(), each
+ * span feeds a fixed bucket latency histogram (4 buckets per octave, 1 us to
+ * 131 ms). Every PROF_PERIOD the histograms are swapped out and the window's
+ * count, min, p50, p99, max and average per span are logged (PROF: lines on
+ * the serial port) and kept for the UI profiler overlay.
+ *
+ * Each span must only be fed by one task. Build with
+ * EXTRA_CFLAGS+=-DPROF_ENABLE=0 to remove every span from the build.
+ */
+#ifndef _PROF_H_
+#define _PROF_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "api.h"
+
+#ifndef PROF_ENABLE
+#define PROF_ENABLE 1
+#endif
+
+/* Window (ms) */
+#define PROF_PERIOD 10000
+/* Histogram buckets, 4 per octave */
+#define PROF_BUCKETS 64
+
+/* Spans, control task then graphics and log tasks */
+typedef enum
+{
+    PROF_TICK,      /* Whole control tick, excluding the delay */
+    PROF_MSG,       /* msg_ctrl_apply */
+    PROF_SCRIPT,    /* script_tick */
+    PROF_SAMPLE,    /* motor_sample of every motor */
+    PROF_GROUP,     /* group_update and group_run, commands and detectors */
+    PROF_UI_POST,   /* Posting speeds to the graphics task */
+    PROF_TELEM,     /* telem_tick */
+    PROF_PLOT,      /* plot_tick */
+    PROF_UI_APPLY,  /* msg_ui_apply, graphics task */
+    PROF_REFR,      /* LVGL refresh, from its monitor (ms resolution) */
+    PROF_DLOG,      /* Deferred log formatting, log task */
+    PROF_COUNT,
+} prof_span_t;
+
+/* Stats of one span over a window, times in us */
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t p50;
+    uint32_t p99;
+    uint32_t max;
+    uint32_t avg;
+} prof_stats_t;
+
+#if PROF_ENABLE
+#define PROF_BEGIN(span) uint32_t prof_start_##span = (uint32_t)micros()
+#define PROF_END(span) prof_add(span,(uint32_t)micros() - prof_start_##span)
+#else
+#define PROF_BEGIN(span) do {} while(0)
+#define PROF_END(span) do {} while(0)
+#endif
+
+/* Add one sample of a span */
+void prof_add(prof_span_t span, uint32_t us);
+
+/* Stats of the last complete window */
+void prof_get(prof_span_t span, prof_stats_t * stats);
+
+/* Length (ms) of the last complete window */
+uint32_t prof_window_ms();
+
+/* Name of a span */
+const char * prof_name(prof_span_t span);
+
+/* Format the last window as a table, one line per span that ran */
+void prof_format(char * out, size_t size);
+
+/* Log the last window, one line per span */
+void prof_dump();
+
+/* Start the window task */
+void prof_init();
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _PROF_H_ */
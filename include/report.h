@@ -8,17 +8,43 @@ extern "C" {
 
 #include "api.h"
 
+/* Lines of scrollback kept, must be a power of 2 */
+#define REPORT_HISTORY 2048
+/* Longest line kept (including null), longer lines are cut */
+#define REPORT_LINE_CHARS 64
+/* Lines visible on the report page */
+#define REPORT_VIEW_LINES 8
+/* Display refresh period (ms) */
+#define REPORT_PERIOD 100
+
+/* Line types, for filtering */
+typedef enum
+{
+    REPORT_EV_INFO,
+    REPORT_EV_SPINUP,
+    REPORT_EV_SHOT,
+    REPORT_EV_POWER,
+    REPORT_EV_COUNT
+} report_type_t;
+
+/* Motor field for lines that are not about one motor */
+#define REPORT_MOTOR_NONE 0xFF
+
 /* Functions exposed by report */
 void report_draw(lv_obj_t * page);
 
-/* Appearance of a printf-style function */
-#define REPORT(...) do{char temp[64];snprintf(temp,64,__VA_ARGS__);report_print(temp);}while(0)
+/* Appearance of a printf-style function, REPORT_EV also tags the line with a motor and type */
+#define REPORT_EV(motor,type,...) do{char temp[REPORT_LINE_CHARS];snprintf(temp,REPORT_LINE_CHARS,__VA_ARGS__);report_event(motor,type,temp);}while(0)
+#define REPORT(...) REPORT_EV(REPORT_MOTOR_NONE,REPORT_EV_INFO,__VA_ARGS__)
 
-/* Report print buffer - note string is truncated at null or 44 printable chars */
+/* Add a line to the report, O(1) and safe to call before the page is drawn
+ * The string is cut at REPORT_LINE_CHARS-1 chars
+ */
+void report_event(uint8_t motor, report_type_t type, const char * str);
 void report_print(const char * str);
 
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
 
-#endif /* _REPORT_H */
\ No newline at end of file
+#endif /* _REPORT_H */
@@ -0,0 +1,115 @@
+/* Test result store on the SD card
+ * Every detector result (spinup, shot, runtime power) is appended to
+ * /usd/results.bin as a fixed-size record with a CRC. A crash or pulled
+ * card can only lose the record being written, which fails its CRC and is
+ * skipped when the file is loaded. A compact index of every record is
+ * kept in RAM for queries, the records themselves stay on the card.
+ *
+ * The V5 has no real-time clock, so records are keyed by session (one per
+ * boot, counted in the file) and by the build date of the program. "This
+ * week" is therefore "from programs built this week".
+ */
+#ifndef _RESULTS_H_
+#define _RESULTS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Result file */
+#define RESULTS_FILE "/usd/results.bin"
+/* Record format version */
+#define RESULTS_VERSION 1
+/* Most records indexed in RAM, older records are still kept on the card */
+#define RESULTS_INDEX_MAX 4096
+/* Records waiting to be written */
+#define RESULTS_QUEUE_LEN 16
+
+/* Result types */
+typedef enum
+{
+    RESULTS_SPINUP_66,
+    RESULTS_SPINUP_95,
+    RESULTS_SPINUP_99,
+    RESULTS_SHOT,
+    RESULTS_RUN_POWER,
+    RESULTS_TYPE_COUNT
+} results_type_t;
+
+/* Configuration flags */
+#define RESULTS_FLAG_REVERSED 0x01
+
+/* One result, 40 bytes on the card (little endian, packed) */
+typedef struct
+{
+    /* Key */
+    uint32_t session;
+    uint16_t build_day;
+    uint32_t time;
+    uint8_t type;
+    uint8_t motor;
+    /* Configuration */
+    uint8_t port;
+    uint8_t gearset;
+    uint8_t flags;
+    uint8_t members;
+    int16_t target;
+    /* Values, meaning depends on type:
+     * spinup: seconds, joules, starting temperature (C, 0 before it was recorded)
+     * shot: seconds, joules, min rpm
+     * run power: watts avg, joules, seconds
+     */
+    float val[3];
+} results_rec_t;
+#define RESULTS_REC_SIZE 40
+
+/* Query, fields set to -1 match anything */
+typedef struct
+{
+    int type;
+    int motor;
+    int gearset;
+    /* Matches targets within target_tol rpm */
+    int target;
+    int target_tol;
+    /* Oldest build date to include (days since 2000-01-01, see results_build_day) */
+    int build_day_min;
+    /* Single session */
+    int session;
+} results_query_t;
+
+/* Set every field of a query to match anything */
+void results_query_any(results_query_t * q);
+
+/* Open the store, load the index and start the writer task */
+void results_init();
+
+/* Record a result from a detector, returns immediately (written by the writer task) */
+void results_add(uint8_t motor, results_type_t type, float a, float b, float c);
+
+/* Best (lowest val[0]) matching result, false if none
+ * For spinup and shot that is the fastest, for run power the least power
+ */
+bool results_best(const results_query_t * q, results_rec_t * out);
+
+/* Number of matching results */
+int results_count(const results_query_t * q);
+
+/* Current session number */
+uint32_t results_session();
+
+/* Build date of this program, days since 2000-01-01 */
+uint16_t results_build_day();
+
+/* Pack/unpack a record to the card format, unpack checks the CRC */
+void results_pack(const results_rec_t * rec, uint8_t * out);
+bool results_unpack(const uint8_t * in, results_rec_t * rec);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _RESULTS_H_ */
@@ -12,7 +12,8 @@ extern "C" {
 void run_draw(lv_obj_t * page);
 void run_update_run(uint8_t idx);
 void run_update_follow(uint8_t idx);
-void run_update_speeds(uint8_t idx);
+void run_update_speeds(uint8_t idx, int target, int speed);
+void run_redraw(uint8_t idx);
 
 #ifdef __cplusplus
 }
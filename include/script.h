@@ -0,0 +1,104 @@
+/* Scripted test sequences
+ * A test script on the SD card is parsed once at boot into a list of steps,
+ * then run by the control task at the start of every tick, so its waits are
+ * timed by the control loop and its commands reach the motors the same tick.
+ * One step per line, # starts a comment:
+ *   motor A        drive the group led by A (default: the leader it was started on)
+ *   target 600     target speed (rpm), stops the script if above the cartridge's maximum
+ *   on             power on, waiting for the spinup detector to re-arm like a spinup test
+ *                  and for the group to cool into the band
+ *   off            power off
+ *   settle 2 10    wait until the speed is within 2% of target for SCRIPT_SETTLE_TIME,
+ *                  fail after 10 s (default SCRIPT_SETTLE_TIMEOUT)
+ *   hold 5         wait 5 s
+ *   feed 150       pulse the feeder output (ADI port SCRIPT_FEED_PORT) for 150 ms
+ *   repeat 10      run the steps up to the matching end 10 times, 0 for ever
+ *   end
+ *   cool 45 600    power off and wait until every member is below 45 C,
+ *                  fail after 600 s (default SCRIPT_COOL_TIMEOUT)
+ *   band 40        on holds a test until every member is below 40 C
+ *                  (default THERMAL_BAND, 0 to start at any temperature)
+ *   endure 0.6     start an endurance run (endure.h) passing on 0.6 s recovery,
+ *                  0 ends it, as does the end of the script
+ * Temperatures are the thermal model's estimates (thermal.h).
+ * Started and stopped from the controller (Y, MSG_CTRL_SCRIPT) on the selected leader.
+ */
+#ifndef _SCRIPT_H_
+#define _SCRIPT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Script file */
+#define SCRIPT_FILE "/usd/test.txt"
+/* Most steps in a script */
+#define SCRIPT_MAX_STEPS 128
+/* Deepest repeat nesting */
+#define SCRIPT_DEPTH 4
+/* Most steps run in one tick, so a loop with no waits can't stall the control task */
+#define SCRIPT_STEPS_PER_TICK 16
+/* Time (s) the speed must stay in the band for settle */
+#define SCRIPT_SETTLE_TIME 0.5
+/* Default timeouts (s) */
+#define SCRIPT_SETTLE_TIMEOUT 10.0
+#define SCRIPT_COOL_TIMEOUT 1800.0
+/* Longest wait (s) for the spinup detector to re-arm on power on */
+#define SCRIPT_ARM_TIMEOUT 30.0
+/* Feeder output, ADI port letter */
+#define SCRIPT_FEED_PORT 'A'
+
+typedef enum
+{
+    SCRIPT_OP_MOTOR,    /* a: leader index */
+    SCRIPT_OP_TARGET,   /* a: rpm */
+    SCRIPT_OP_ON,
+    SCRIPT_OP_OFF,
+    SCRIPT_OP_SETTLE,   /* a: band (%), b: timeout (s) */
+    SCRIPT_OP_HOLD,     /* a: time (s) */
+    SCRIPT_OP_FEED,     /* a: pulse (ms) */
+    SCRIPT_OP_REPEAT,   /* a: count, 0 for ever */
+    SCRIPT_OP_END,      /* jump: the matching repeat */
+    SCRIPT_OP_COOL,     /* a: temperature (C), b: timeout (s) */
+    SCRIPT_OP_BAND,     /* a: temperature (C), 0 for none */
+    SCRIPT_OP_ENDURE,   /* a: target recovery (s), 0 to end */
+    SCRIPT_OP_COUNT
+} script_op_t;
+
+typedef struct
+{
+    uint8_t op;
+    /* Line in the file, for reports */
+    uint16_t line;
+    uint16_t jump;
+    float a;
+    float b;
+} script_step_t;
+
+/* Load SCRIPT_FILE if there is a card and set up the feeder output */
+void script_init();
+
+/* Parse a script, replacing the loaded one. False (and nothing loaded) on an error */
+bool script_parse(FILE * f);
+
+/* Start the script on a leader, or stop it if it is running. Control task */
+void script_toggle(uint8_t idx);
+
+/* Run the script for this tick, control task, before the motors are sampled */
+void script_tick();
+
+/* A script is running */
+bool script_running();
+
+/* The last run reached the end of the script */
+bool script_completed();
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _SCRIPT_H_ */
@@ -0,0 +1,38 @@
+/* RTOS task monitor
+ * Every TASKMON_PERIOD looks up the known tasks by name and records their
+ * state, priority and stack headroom, estimates CPU load and each task's
+ * share of it, and measures the LVGL heap. Shown as the last page of the UI
+ * profiler overlay and logged (TASKMON: lines).
+ *
+ * PROS has no per task run time, so load comes from an idle probe: a task at
+ * TASK_PRIORITY_MIN that spins reading micros(), any time it was not running
+ * was used by something else. The control, graphics and log task shares come
+ * from the span profiler (prof.h), the rest of the load is shown as other.
+ */
+#ifndef _TASKMON_H_
+#define _TASKMON_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "api.h"
+
+/* Window (ms) */
+#define TASKMON_PERIOD 10000
+/* Probe spins this long (us) between 1 ms sleeps, so the RTOS idle task still runs */
+#define TASKMON_SLICE_US 10000
+/* A gap between two probe reads longer than this (us) is time taken by another task */
+#define TASKMON_GAP_US 10
+
+/* Start the probe and the window task */
+void taskmon_init();
+
+/* Format the last window, load, tasks and heap */
+void taskmon_format(char * out, size_t size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _TASKMON_H_ */
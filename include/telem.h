@@ -0,0 +1,133 @@
+/* Binary telemetry stream
+ * Protocol definitions are shared with host tools, so this header has no PROS dependencies
+ */
+#ifndef _TELEM_H_
+#define _TELEM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Protocol version, sent in the schema frame */
+#define TELEM_VERSION 1
+
+/* Resend the schema this often so a receiver can join mid-stream (ms) */
+#define TELEM_SCHEMA_PERIOD 1000
+
+/* Set to 1 to start in binary mode, otherwise the serial stream is off until telem_set_binary() */
+#define TELEM_BINARY_DEFAULT 0
+
+/* Set to 1 to also record the stream to the SD card (if inserted) */
+#define TELEM_SD_DEFAULT 1
+
+/* Set to 1 to send delta compressed sample blocks (see pack.h) instead of raw samples */
+#define TELEM_PACK 1
+/* Ticks between keyframes, decoding can start at any keyframe */
+#define TELEM_KEY_TICKS 50
+/* Most ticks held in one packed block before it is sent */
+#define TELEM_PACK_TICKS 5
+/* The SD recording is written by its own task from a ring, so the control
+ * task never waits on the card. Ring size (bytes, power of 2), a frame that
+ * doesn't fit is dropped whole and the receiver resyncs at the next one
+ */
+#define TELEM_SD_RING 8192
+/* Period of the SD task (ms) */
+#define TELEM_SD_PERIOD 100
+/* Time between closing and reopening the SD file so data reaches the card (ms) */
+#define TELEM_SD_REOPEN 5000
+
+/* Frame types (first byte of every payload)
+ * Every frame starts with: type u8, seq u16, time_ms u32
+ * seq counts frames in the order they are sent, so a packed block built over
+ * several ticks takes its number after the events and schema sent meanwhile
+ */
+typedef enum
+{
+    /* version u8, period_ms u16, nchan u8, then per channel: scale f32, name (NUL terminated) */
+    TELEM_FRAME_SCHEMA,
+    /* One record per active motor for this tick, see telem_rec_t */
+    TELEM_FRAME_SAMPLE,
+    /* idx u8, event u8, a f32, b f32, c f32 */
+    TELEM_FRAME_EVENT,
+    /* One or more ticks of delta compressed records, see pack.h
+     * Time in the header is the first tick, blocks always start on a keyframe or follow the previous block
+     */
+    TELEM_FRAME_PACKED,
+    TELEM_FRAME_COUNT
+} telem_frame_t;
+
+/* Size of the common frame header */
+#define TELEM_HDR_SIZE 7
+
+/* Sample channels, all carried as scaled integers (see telem_ch_scale) */
+typedef enum
+{
+    TELEM_CH_TARGET,    /* 1 rpm */
+    TELEM_CH_SPEED,     /* 0.1 rpm */
+    TELEM_CH_CURR,      /* 1 mA */
+    TELEM_CH_VOLT,      /* 1 mV */
+    TELEM_CH_POWER,     /* 0.01 W */
+    TELEM_CH_TEMP,      /* 0.1 deg C */
+    /* Must be last */
+    TELEM_CH_COUNT
+} telem_ch_t;
+
+/* Record flags */
+#define TELEM_FLAG_POWERED 0x01
+
+/* One motor sample
+ * On the wire: idx u8, flags u8, then each channel as i32
+ */
+typedef struct
+{
+    uint8_t idx;
+    uint8_t flags;
+    int32_t ch[TELEM_CH_COUNT];
+} telem_rec_t;
+#define TELEM_REC_SIZE (2 + 4 * TELEM_CH_COUNT)
+
+/* Events, values a/b/c depend on the event */
+typedef enum
+{
+    TELEM_EV_SPINUP_ARM,    /* - */
+    TELEM_EV_SPINUP_REARM,  /* - */
+    TELEM_EV_SPINUP_66,     /* time s, energy J */
+    TELEM_EV_SPINUP_95,     /* time s, energy J */
+    TELEM_EV_SPINUP_99,     /* time s, energy J */
+    TELEM_EV_SHOT_ARM,      /* - */
+    TELEM_EV_SHOT_START,    /* - */
+    TELEM_EV_SHOT_DONE,     /* time s, energy J, min speed rpm */
+    TELEM_EV_RUN_POWER,     /* avg power W, energy J, time s */
+    TELEM_EV_LOST,          /* port */
+    TELEM_EV_FOUND,         /* port, time without samples s */
+    /* Must be last */
+    TELEM_EV_COUNT
+} telem_event_t;
+
+/* Channel names and scales (count to engineering units), sent in the schema frame */
+static const char * const telem_ch_name[TELEM_CH_COUNT] = {"target_rpm","speed_rpm","curr_a","volt_v","power_w","temp_c"};
+static const float telem_ch_scale[TELEM_CH_COUNT] = {1.0f, 0.1f, 0.001f, 0.001f, 0.01f, 0.1f};
+
+/* Event names, for host tools */
+static const char * const telem_ev_name[TELEM_EV_COUNT] =
+{
+    "SPINUP_ARM", "SPINUP_REARM", "SPINUP_66", "SPINUP_95", "SPINUP_99",
+    "SHOT_ARM", "SHOT_START", "SHOT_DONE", "RUN_POWER", "LOST", "FOUND"
+};
+
+/* Functions exposed by telem (on the brain) */
+void telem_init();
+void telem_set_binary(bool enable);
+bool telem_get_binary();
+void telem_sample(uint8_t idx, bool powered, int32_t target);
+void telem_event(uint8_t idx, telem_event_t ev, float a, float b, float c);
+void telem_tick();
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _TELEM_H_ */
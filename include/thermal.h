@@ -0,0 +1,80 @@
+/* Motor thermal model
+ * A lumped model per motor, the winding heated by its current and cooling
+ * towards ambient:
+ *   dT/dt = gain * I^2 - (T - ambient) / tau
+ * Heat comes from the winding loss, current squared, since at speed most of
+ * the power the motor reports goes into the flywheel. Ambient is the coolest
+ * the motor has read.
+ *
+ * The motor only reports its temperature in THERMAL_STEP steps, so every
+ * sample the model is stepped as an estimate kept inside the reported step,
+ * and gain and tau are fitted by recursive least squares on the reported
+ * temperature over THERMAL_FIT_TIME intervals, starting from THERMAL_GAIN and
+ * THERMAL_TAU. From the model come the time until the motor derates at its
+ * present load and the time it needs to cool down with the power off.
+ *
+ * The motors derate above THERMAL_DERATE, which slows a spinup, so tests are
+ * only comparable from similar temperatures: scripts hold a test until the
+ * group is in a band (script.h), spinup results record the temperature they
+ * started at, and a motor forecast to derate within THERMAL_WARN_TIME is
+ * reported.
+ */
+#ifndef _THERMAL_H_
+#define _THERMAL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Reported temperature resolution (C) */
+#define THERMAL_STEP 5.0
+/* The motor limits its current above this (C) */
+#define THERMAL_DERATE 55.0
+/* Hottest a group may be to start a scripted test (C), until a script sets its own */
+#define THERMAL_BAND 40.0
+/* Model before the fit (K/(A^2 s) and s) */
+#define THERMAL_GAIN 0.05
+#define THERMAL_TAU 300.0
+/* Fitted limits */
+#define THERMAL_GAIN_MIN 0.001
+#define THERMAL_GAIN_MAX 1.0
+#define THERMAL_TAU_MIN 30.0
+#define THERMAL_TAU_MAX 3000.0
+/* Fit interval (s) and forgetting factor per interval */
+#define THERMAL_FIT_TIME 20.0
+#define THERMAL_FORGET 0.99
+/* Time constant (s) of the load the derate forecast assumes */
+#define THERMAL_LOAD_TAU 10.0
+/* Report a motor forecast to derate sooner than this (s) */
+#define THERMAL_WARN_TIME 60.0
+
+/* Forecast for something that won't happen */
+#define THERMAL_NEVER -1.0
+
+/* Step the model of a motor with its new sample, after motor_sample reads it */
+void thermal_sample(uint8_t idx);
+
+/* Forget a motor, it is a different motor now (moved or attached) */
+void thermal_reset(uint8_t idx);
+
+/* Estimated winding temperature (C) */
+double thermal_temp(uint8_t idx);
+
+/* Time (s) until the motor derates at its present load, 0 if it is, THERMAL_NEVER if it won't */
+double thermal_derate_time(uint8_t idx);
+
+/* Time (s) to cool to a temperature with the power off, 0 if it is, THERMAL_NEVER if it can't */
+double thermal_cool_time(uint8_t idx, double temp);
+
+/* The same over the members of the group led by lead, hottest and slowest */
+double thermal_group_temp(uint8_t lead);
+double thermal_group_cool_time(uint8_t lead, double temp);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _THERMAL_H_ */
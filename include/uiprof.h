@@ -0,0 +1,45 @@
+/* UI cost profiler
+ * Measures LVGL refresh time and redrawn area per frame (from the LVGL
+ * refresh monitor), widget count and heap per tab and the control loop's work time
+ * and period, so the cost of a UI change can be seen next to its effect on
+ * sampling. Shown as an overlay on the top layer (long press any sidebar
+ * button) and logged every UIPROF_LOG_PERIOD. Further long presses show the
+ * span profiler's (prof.h) and task monitor's (taskmon.h) last window, then
+ * hide the overlay.
+ */
+#ifndef _UIPROF_H_
+#define _UIPROF_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "api.h"
+
+/* Overlay update period (ms) */
+#define UIPROF_PERIOD 1000
+/* Log record period (ms) */
+#define UIPROF_LOG_PERIOD 10000
+/* Most tabs tracked */
+#define UIPROF_MAX_TABS 8
+
+/* Install the refresh monitor and start the overlay task */
+void uiprof_init();
+
+/* Tabs to count widgets on */
+void uiprof_set_tabs(lv_obj_t ** pages, const char ** names, int count);
+
+/* Add up the objects in a tree and the LVGL heap they hold (object and type data, not text) */
+void uiprof_tree(lv_obj_t * obj, uint32_t * count, uint32_t * bytes);
+
+/* Step the overlay through UI stats, spans, tasks and hidden */
+void uiprof_toggle();
+
+/* Record one control tick, work_us is the time spent in the tick excluding the delay */
+void uiprof_ctrl(uint32_t work_us);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _UIPROF_H_ */
@@ -0,0 +1,56 @@
+/* View-model cache for LVGL widgets
+ * Each view remembers the text and style last given to its object and
+ * only calls into LVGL when they change, since every lv_label_set_text or
+ * lv_obj_set_style invalidates the object and causes a redraw even if
+ * nothing visible changed. Graphics task only.
+ */
+#ifndef _VIEW_H_
+#define _VIEW_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "api.h"
+
+/* Longest cached text (including null), longer text is always set */
+#define VIEW_TEXT_MAX 16
+/* Period of the statistics log line (ms) */
+#define VIEW_STATS_PERIOD 10000
+
+/* One widget */
+typedef struct
+{
+    lv_obj_t * obj;
+    lv_style_t * style;
+    char text[VIEW_TEXT_MAX];
+} view_t;
+
+/* Update counts, set is calls made to LVGL, same is calls skipped */
+typedef struct
+{
+    uint32_t text_set;
+    uint32_t text_same;
+    uint32_t style_set;
+    uint32_t style_same;
+    /* Display updates replaced by a newer one before they were drawn */
+    uint32_t coalesced;
+} view_stats_t;
+
+extern view_stats_t view_stats;
+
+/* Attach a view to an object, the cache starts empty so the first set always goes through */
+void view_bind(view_t * view, lv_obj_t * obj);
+
+/* Set text or style only if different from what is shown, true if LVGL was called */
+bool view_set_text(view_t * view, const char * text);
+bool view_set_style(view_t * view, lv_style_t * style);
+
+/* Start the periodic statistics log */
+void view_init();
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* _VIEW_H_ */
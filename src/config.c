@@ -18,6 +18,9 @@ enum
     CONFIG_CB_MAX
 };
 
+/* Page is drawn on first visit */
+static bool config_has_init = false;
+
 
 /* Function to update a reverse icon by motor index */
 static void config_update_reverse(uint8_t idx)
@@ -138,6 +141,21 @@ static void config_update_follow(uint8_t idx)
 }
 
 
+/* Update all configuration graphics of a motor, graphics task only */
+void config_update(uint8_t idx)
+{
+    /* Break out if we are called before we init */
+    if(!config_has_init)
+    {
+        return;
+    }
+
+    config_update_follow(idx);
+    config_update_reverse(idx);
+    config_update_gearset(idx);
+}
+
+
 /* Config callback */
 static lv_res_t config_cb(lv_obj_t *obj)
 {
@@ -157,119 +175,25 @@ static lv_res_t config_cb(lv_obj_t *obj)
         return LV_RES_OK;
     }
 
-    /* Selection based on property */
+    /* Selection based on property, the change itself is made by the control task */
     switch(cb)
     {
     case CONFIG_CB_PORT:
-        LOG_WARN("Cannot change port number for motor %c, feature not implemented",('A'+idx));
+        msg_ctrl_post(MSG_CTRL_PORT,idx,0);
         break;
     case CONFIG_CB_LEAD:
-        /* If we are currently a follower, promote ourselves to leader
-         * We kick our followers onto our leader when we follow
-         * So we can't have any followers ourselves at this point
-         */
-        if(motors[idx].leader >= 0)
-        {
-            /* Promote ourself */
-            LOG_DEBUG("Promoting motor %c to leader",('A'+idx));
-            /* Turn ourself off */
-            motors[idx].powered = 0;
-            motors[idx].leader = -1;
-            config_update_follow(idx);
-            /* Also update gearset so it un-disables */
-            config_update_gearset(idx);
-        }
-        /* The first motor cannot be assigned a leader */
-        else if(idx == 0)
-        {
-            /* Motor does not have leader assigned, but first motor cannot be a leader */
-            LOG_WARN("Trying to make motor %c a follower, but it cannot be a follower",('A'+idx));
-            config_update_follow(idx);
-        }
-        else
-        {
-            /* Motor does not have a leader assigned, look forward to find its leader */
-            for(int i = idx; i > 0; i--)
-            {
-                LOG_DEBUG("Trying to find leader for %c, checking %c",('A'+idx),('A'+i-1));
-                if(motors[i-1].leader < 0)
-                {
-                    LOG_DEBUG("Found leader, using %c",((i-1)+'A'));
-                    motors[idx].leader = i-1;
-                    break;
-                }
-            }
-
-            /* Update our own graphics */
-            config_update_follow(idx);
-            /* Take gearset from the leader and update that too */
-            motors[idx].gearset = motors[motors[idx].leader].gearset;
-            motors[idx].target = motors[motors[idx].leader].target;
-            config_update_gearset(idx); 
-
-            /* Look back to the end of the list to see if anyone is following us
-             * If so, they need to follow our leader now
-             */
-            for(int i = idx + 1; i < NUM_MOTORS;i++)
-            {
-                if(motors[i].leader == idx)
-                {
-                    LOG_DEBUG("Motor %c was following us, now needs to follow %c",(i+'A'),(motors[idx].leader+'A'));
-                    /* Change leader */
-                    motors[i].leader = motors[idx].leader;
-
-                    /* Update graphics */
-                    config_update_follow(i);
-                    /* Also update their gearset */
-                    motors[i].gearset = motors[motors[i].leader].gearset;
-                    motors[i].target = motors[motors[i].leader].target;
-                    config_update_gearset(i); 
-                }
-            }       
-        }
+        msg_ctrl_post(MSG_CTRL_LEAD,idx,0);
         break;
     case CONFIG_CB_REVERSE:
-        /* Flip reversed flag */
-        motors[idx].reversed = !motors[idx].reversed;
-        LOG_DEBUG("Updating reverse on motor %c, value is now %d",(idx+'A'),motors[idx].reversed);
-        /* Update graphics */
-        config_update_reverse(idx);
+        msg_ctrl_post(MSG_CTRL_REVERSE,idx,0);
         break;
     case CONFIG_CB_GEAR:
-        /* Check if we are a leader and can update gearset */
-        if(motors[idx].leader < 0)
-        {
-            /* Increment gearset and roll over */
-            motors[idx].gearset++;
-            if(motors[idx].gearset > E_MOTOR_GEARSET_06) motors[idx].gearset = 0;
-            LOG_DEBUG("Updating gearset on motor %c, value is now %d",('A'+idx),motors[idx].gearset);
-            /* Reset target speed to max for this gearset */
-            motor_reset_max(idx);
-
-            /* Check if we have any followers and update them too */
-            for(int i = idx + 1; i < NUM_MOTORS;i++)
-            {
-                if(motors[i].leader == idx)
-                {
-                    LOG_DEBUG("Updating gearset for motor %c since it follows %c",('A'+i),('A'+idx));
-                    motors[i].gearset = motors[idx].gearset;
-                    motors[i].target = motors[idx].target;
-                    config_update_gearset(i);
-                }
-            }
-        }
-        else
-        {
-            /* Followers can't update gearset */
-            LOG_WARN("Can't update gearset on motor %c since it's a follower",('A'+idx));
-        }
-        /* Update graphics */
-        config_update_gearset(idx);
-        /* Check if we have any followers */
+        msg_ctrl_post(MSG_CTRL_GEAR,idx,0);
         break;
     default:
         LOG_ERROR("Got callback for config, key is %x (motor %c, property %d), property is invalid",key,('A'+idx),cb);
     }
+    return LV_RES_OK;
 }
 
 
@@ -288,11 +212,94 @@ static void config_button_setup(lv_obj_t * button)
 }
 
 
+/* Draw the contents of a motor's subpage */
+static void config_draw_motor(uint8_t i)
+{
+    lv_obj_t * label, * button, * icon;
+    lv_obj_t * newpage = motors[i].config.page;
+
+    /* Label for the motor */
+    label = lv_label_create(newpage,NULL);
+    char name[8];
+    sprintf(name,"MOTOR %c",(i+'A'));
+    lv_label_set_text(label,name);
+
+    /* If the motor is invalid, add a big NA and don't configure the rest */
+    if(motors[i].port < 0)
+    {
+        label = lv_label_create(newpage,NULL);
+        lv_label_set_text(label,"N/A");
+        lv_obj_align(label,0,LV_ALIGN_CENTER,0,100);
+        return;
+    }
+
+    /* Port number button */
+    LV_IMG_DECLARE(mdi_power_plug);
+    button = lv_btn_create(newpage,NULL);
+    motors[i].config.port = button;
+    lv_obj_set_free_num(button,(i+(CONFIG_CB_PORT<<8)));
+    config_button_setup(button);
+    /* Port number icon */
+    icon = lv_img_create(button,NULL);
+    lv_img_set_src(icon,&mdi_power_plug);
+    lv_obj_set_style(icon,&style_dis);
+    /* Port number text */
+    char text[8];
+    sprintf(text,"%d",motors[i].port);
+    label = lv_label_create(button,NULL);
+    motors[i].config.port_label = label;
+    lv_label_set_text(label,text);
+
+    /* Leader/Follower button */
+    button = lv_btn_create(newpage,NULL);
+    motors[i].config.lead = button;
+    lv_obj_set_free_num(button,(i+(CONFIG_CB_LEAD<<8)));
+    config_button_setup(button);
+    /* Leader/Follower icon */
+    icon = lv_img_create(button,NULL);
+    motors[i].config.lead_icon = icon;
+    lv_obj_set_style(icon,&style_dis);
+    /* Leader/Follower text */
+    label = lv_label_create(button,NULL);
+    motors[i].config.lead_label = label;
+    config_update_follow(i);
+
+    /* Reversed button */
+    button = lv_btn_create(newpage,NULL);
+    motors[i].config.reverse = button;
+    lv_obj_set_free_num(button,(i+(CONFIG_CB_REVERSE<<8)));
+    config_button_setup(button);
+    /* Reversed icon */
+    icon = lv_img_create(button,NULL);
+    motors[i].config.reverse_icon = icon;
+    lv_obj_set_style(icon,&style_dis);
+    /* Reversed text */
+    label = lv_label_create(button,NULL);
+    motors[i].config.reverse_label = label;
+    /* Update graphics */
+    config_update_reverse(i);
+
+    /* Gear Ratio button */
+    button = lv_btn_create(newpage,NULL);
+    motors[i].config.gearset = button;
+    lv_obj_set_free_num(button,(i+(CONFIG_CB_GEAR<<8)));
+    config_button_setup(button);
+    /* Gear Ratio icon */
+    icon = lv_img_create(button,NULL);
+    motors[i].config.gearset_icon = icon;
+    lv_obj_set_style(icon,&style_dis);
+    /* Gear Ratio text */
+    label = lv_label_create(button,NULL);
+    motors[i].config.gearset_label = label;
+    /* Update icon and text */
+    config_update_gearset(i);
+}
+
 /* Function to initialize the config page */
 void config_draw(lv_obj_t * page)
 {
     /* Create a title */
-    lv_obj_t * label, * newpage, * button, * icon;
+    lv_obj_t * label, * newpage;
     label = lv_label_create(page,NULL);
     lv_label_set_text(label,"CONFIGURE");
     lv_obj_align(label,0,LV_ALIGN_IN_TOP_MID,0,0);
@@ -309,82 +316,19 @@ void config_draw(lv_obj_t * page)
         lv_obj_set_style(newpage,&style_page);
         lv_page_set_scrl_layout(newpage,LV_LAYOUT_COL_M);
 
-        /* Label for the motor */
-        label = lv_label_create(newpage,NULL);
-        char name[8];
-        sprintf(name,"MOTOR %c",(i+'A'));
-        lv_label_set_text(label,name);
-
-        /* If the motor is invalid, add a big NA and don't configure the rest */
-        if(motors[i].port < 0)
-        {
-            label = lv_label_create(newpage,NULL);
-            lv_label_set_text(label,"N/A");
-            lv_obj_align(label,0,LV_ALIGN_CENTER,0,100);
-            continue;
-        }
-
-        /* Port number button */
-        LV_IMG_DECLARE(mdi_power_plug);
-        button = lv_btn_create(newpage,NULL);
-        motors[i].config.port = button;
-        lv_obj_set_free_num(button,(i+(CONFIG_CB_PORT<<8)));
-        config_button_setup(button);
-        /* Port number icon */
-        icon = lv_img_create(button,NULL);
-        lv_img_set_src(icon,&mdi_power_plug);
-        lv_obj_set_style(icon,&style_dis);
-        /* Port number text */
-        char text[8];
-        sprintf(text,"%d",motors[i].port);
-        label = lv_label_create(button,NULL);
-        motors[i].config.port_label = label;
-        lv_label_set_text(label,text);
-
-        /* Leader/Follower button */
-        button = lv_btn_create(newpage,NULL);
-        motors[i].config.lead = button;
-        lv_obj_set_free_num(button,(i+(CONFIG_CB_LEAD<<8)));
-        config_button_setup(button);
-        /* Leader/Follower icon */
-        icon = lv_img_create(button,NULL);
-        motors[i].config.lead_icon = icon;
-        lv_obj_set_style(icon,&style_dis);
-        /* Leader/Follower text */
-        label = lv_label_create(button,NULL);
-        motors[i].config.lead_label = label;
-        config_update_follow(i);
-
-        /* Reversed button */
-        button = lv_btn_create(newpage,NULL);
-        motors[i].config.reverse = button;
-        lv_obj_set_free_num(button,(i+(CONFIG_CB_REVERSE<<8)));
-        config_button_setup(button);
-        /* Reversed icon */
-        icon = lv_img_create(button,NULL);
-        motors[i].config.reverse_icon = icon;
-        lv_obj_set_style(icon,&style_dis);
-        /* Reversed text */
-        label = lv_label_create(button,NULL);
-        motors[i].config.reverse_label = label;
-        /* Update graphics */
-        config_update_reverse(i);
-
-        /* Gear Ratio button */
-        button = lv_btn_create(newpage,NULL);
-        motors[i].config.gearset = button;
-        lv_obj_set_free_num(button,(i+(CONFIG_CB_GEAR<<8)));
-        config_button_setup(button);
-        /* Gear Ratio icon */
-        icon = lv_img_create(button,NULL);
-        motors[i].config.gearset_icon = icon;
-        lv_obj_set_style(icon,&style_dis);
-        /* Gear Ratio text */
-        label = lv_label_create(button,NULL);
-        motors[i].config.gearset_label = label;
-        /* Update icon and text */
-        config_update_gearset(i);
+        config_draw_motor(i);
     }
-
+    config_has_init = true;
 }
 
+/* Redraw a motor's subpage after its port changed, graphics task only */
+void config_redraw(uint8_t idx)
+{
+    /* Not drawn yet, it will be drawn with the current port */
+    if(!config_has_init)
+    {
+        return;
+    }
+    lv_page_clean(motors[idx].config.page);
+    config_draw_motor(idx);
+}
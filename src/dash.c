@@ -0,0 +1,279 @@
+/* Dashboard on the V5 controller screen */
+#include "main.h"
+
+/* Include pros api */
+#include "pros/apix.h"
+
+/* Use pal log */
+#define LOG_LEVEL_FILE LOG_LEVEL_INFO
+#include "pal/log.h"
+
+#include "dash.h"
+
+#include <stdarg.h>
+
+/* Latest values from the control task, single word stores so no lock is needed */
+static int16_t dash_target[NUM_MOTORS];
+static int16_t dash_actual[NUM_MOTORS];
+/* Last shot, recovery time in 10 ms and lowest speed in % of target (-1 if none yet) */
+static int16_t dash_shot_cs[NUM_MOTORS];
+static int16_t dash_shot_pct[NUM_MOTORS];
+
+/* Lines we want on the screen and lines the controller is showing */
+static char dash_want[DASH_LINES][DASH_COLS+1];
+static char dash_shown[DASH_LINES][DASH_COLS+1];
+/* Slots each line has been waiting with changes (0 if up to date) */
+static uint32_t dash_age[DASH_LINES];
+/* Base priority of each line, age is added so no line waits forever:
+ * selected leader's speeds first, then the last shot, then the other leaders
+ */
+static const uint32_t dash_prio[DASH_LINES] = { 4, 2, 0 };
+
+/* Selected leader */
+static uint8_t dash_sel = 0;
+
+/* Line 1 shows the best result instead of the last shot */
+static bool dash_show_best = false;
+/* Best result last read from the card and the query it answers, read again
+ * only when the query changes or more results match, the index is in RAM
+ */
+static struct
+{
+    int sel;
+    int target;
+    int gearset;
+    int count;
+    bool found;
+    results_rec_t rec;
+} dash_best;
+
+void dash_speed(uint8_t idx, int16_t target, int16_t speed)
+{
+    dash_target[idx] = target;
+    dash_actual[idx] = speed;
+}
+
+void dash_shot(uint8_t idx, float time, float min_pct)
+{
+    dash_shot_pct[idx] = min_pct;
+    dash_shot_cs[idx] = time * 100.0;
+}
+
+/* A configured leader */
+static bool dash_is_leader(int idx)
+{
+    return motors[idx].port >= 0 && motors[idx].leader < 0;
+}
+
+/* Move the selection to the next leader in a direction, stay put if there is none */
+static void dash_select(int direction)
+{
+    for(int i = 1; i <= NUM_MOTORS; i++)
+    {
+        int idx = (dash_sel + direction * i + NUM_MOTORS) % NUM_MOTORS;
+        if(dash_is_leader(idx))
+        {
+            dash_sel = idx;
+            return;
+        }
+    }
+}
+
+/* Print a line padded with spaces to the full width */
+static void dash_line(int line, const char * fmt, ...)
+{
+    va_list args;
+    va_start(args,fmt);
+    int len = vsnprintf(dash_want[line],DASH_COLS+1,fmt,args);
+    va_end(args);
+    if(len < 0) len = 0;
+    for(int i = len; i < DASH_COLS; i++)
+    {
+        dash_want[line][i] = ' ';
+    }
+    dash_want[line][DASH_COLS] = 0;
+}
+
+/* Best 95% spinup of leader i this week at its gearset and target */
+static void dash_best_line(int i)
+{
+    results_query_t q;
+    results_query_any(&q);
+    q.type = RESULTS_SPINUP_95;
+    q.motor = i;
+    q.gearset = motors[i].gearset;
+    q.target = dash_target[i];
+    q.target_tol = DASH_BEST_TOL;
+    q.build_day_min = results_build_day() - (DASH_BEST_DAYS - 1);
+    int count = results_count(&q);
+    if(count != dash_best.count || i != dash_best.sel || q.target != dash_best.target || q.gearset != dash_best.gearset)
+    {
+        dash_best.found = count && results_best(&q,&dash_best.rec);
+        dash_best.count = count;
+        dash_best.sel = i;
+        dash_best.target = q.target;
+        dash_best.gearset = q.gearset;
+    }
+    if(!dash_best.found)
+    {
+        dash_line(1,"Best --");
+        return;
+    }
+    int cs = (int)(dash_best.rec.val[0] * 100.0f + 0.5f);
+    dash_line(1,"Best %d.%02ds x%d",cs / 100,cs % 100,count);
+}
+
+/* Build the screen we want from the latest values */
+static void dash_compose()
+{
+    /* Followers can be promoted and leaders demoted from the screen */
+    if(!dash_is_leader(dash_sel))
+    {
+        dash_select(1);
+    }
+    if(!dash_is_leader(dash_sel))
+    {
+        dash_line(0,"No motors");
+        dash_line(1,"");
+        dash_line(2,"");
+        return;
+    }
+
+    int i = dash_sel;
+    if(MOTOR_SPEED_INVALID == dash_actual[i])
+    {
+        dash_line(0,"%c %3d/ --- %s",'A'+i,dash_target[i],motors[i].powered ? "ON" : "OFF");
+    }
+    else
+    {
+        dash_line(0,"%c %3d/%4d %s",'A'+i,dash_target[i],dash_actual[i],motors[i].powered ? "ON" : "OFF");
+    }
+    if(dash_show_best)
+    {
+        dash_best_line(i);
+    }
+    else if(dash_shot_cs[i] < 0)
+    {
+        dash_line(1,"Shot --");
+    }
+    else
+    {
+        dash_line(1,"Shot %d.%02ds %3d%%",dash_shot_cs[i] / 100,dash_shot_cs[i] % 100,dash_shot_pct[i]);
+    }
+
+    /* Other leaders, actual speed only */
+    char others[DASH_COLS+1];
+    int o = 0;
+    others[0] = 0;
+    for(int j = 0; j < NUM_MOTORS && o < DASH_COLS; j++)
+    {
+        if(j == i || !dash_is_leader(j)) continue;
+        if(MOTOR_SPEED_INVALID == dash_actual[j])
+        {
+            o += snprintf(&others[o],sizeof(others) - o,"%c--- ",'A'+j);
+            continue;
+        }
+        o += snprintf(&others[o],sizeof(others) - o,"%c%3d ",'A'+j,dash_actual[j]);
+    }
+    dash_line(2,"%s",others);
+}
+
+/* Send the most important change, only the characters that differ */
+static void dash_send()
+{
+    int best = -1;
+    for(int line = 0; line < DASH_LINES; line++)
+    {
+        if(!memcmp(dash_want[line],dash_shown[line],DASH_COLS))
+        {
+            dash_age[line] = 0;
+            continue;
+        }
+        dash_age[line]++;
+        if(best < 0 || dash_prio[line] + dash_age[line] > dash_prio[best] + dash_age[best])
+        {
+            best = line;
+        }
+    }
+    if(best < 0)
+    {
+        return;
+    }
+
+    int first = 0, last = DASH_COLS - 1;
+    while(dash_want[best][first] == dash_shown[best][first]) first++;
+    while(dash_want[best][last] == dash_shown[best][last]) last--;
+
+    char text[DASH_COLS+1];
+    memcpy(text,&dash_want[best][first],last - first + 1);
+    text[last - first + 1] = 0;
+    if(controller_set_text(E_CONTROLLER_MASTER,best,first,text) == PROS_ERR)
+    {
+        /* Busy, try again next slot */
+        return;
+    }
+    memcpy(&dash_shown[best][first],text,last - first + 1);
+    dash_age[best] = 0;
+}
+
+/* Buttons, new presses are latched by PROS so polling once per slot loses none */
+static void dash_buttons()
+{
+    if(controller_get_digital_new_press(E_CONTROLLER_MASTER,E_CONTROLLER_DIGITAL_LEFT)) dash_select(-1);
+    if(controller_get_digital_new_press(E_CONTROLLER_MASTER,E_CONTROLLER_DIGITAL_RIGHT)) dash_select(1);
+    if(controller_get_digital_new_press(E_CONTROLLER_MASTER,E_CONTROLLER_DIGITAL_B)) dash_show_best = !dash_show_best;
+    if(controller_get_digital_new_press(E_CONTROLLER_MASTER,E_CONTROLLER_DIGITAL_L1)) msg_ctrl_post(MSG_CTRL_TELEM,0,0);
+    if(!dash_is_leader(dash_sel))
+    {
+        return;
+    }
+    if(controller_get_digital_new_press(E_CONTROLLER_MASTER,E_CONTROLLER_DIGITAL_A)) msg_ctrl_post(MSG_CTRL_POWER,dash_sel,0);
+    if(controller_get_digital_new_press(E_CONTROLLER_MASTER,E_CONTROLLER_DIGITAL_UP)) msg_ctrl_post(MSG_CTRL_SPEED,dash_sel,1);
+    if(controller_get_digital_new_press(E_CONTROLLER_MASTER,E_CONTROLLER_DIGITAL_DOWN)) msg_ctrl_post(MSG_CTRL_SPEED,dash_sel,-1);
+    if(controller_get_digital_new_press(E_CONTROLLER_MASTER,E_CONTROLLER_DIGITAL_X)) msg_ctrl_post(MSG_CTRL_TEST,dash_sel,0);
+    if(controller_get_digital_new_press(E_CONTROLLER_MASTER,E_CONTROLLER_DIGITAL_Y)) msg_ctrl_post(MSG_CTRL_SCRIPT,dash_sel,0);
+}
+
+static void dash_task(void * param)
+{
+    bool connected = false;
+    uint32_t now = millis();
+    while(1)
+    {
+        if(!controller_is_connected(E_CONTROLLER_MASTER))
+        {
+            connected = false;
+        }
+        else
+        {
+            if(!connected)
+            {
+                /* Unknown screen after a (re)connect, clearing takes this slot */
+                LOG_INFO("DASH: Controller connected");
+                controller_clear(E_CONTROLLER_MASTER);
+                memset(dash_shown,' ',sizeof(dash_shown));
+                connected = true;
+            }
+            else
+            {
+                dash_buttons();
+                dash_compose();
+                dash_send();
+            }
+        }
+        task_delay_until(&now,DASH_PERIOD);
+    }
+}
+
+void dash_init()
+{
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        dash_shot_cs[i] = -1;
+    }
+    dash_best.sel = -1;
+    if(!task_create(dash_task,NULL,TASK_PRIORITY_DEFAULT-1,TASK_STACK_DEPTH_DEFAULT,"dash"))
+    {
+        LOG_ERROR("DASH: Unable to create task");
+    }
+}
@@ -0,0 +1,273 @@
+/* Deferred-formatting logger */
+#include "main.h"
+
+/* Include pros api */
+#include "pros/apix.h"
+
+/* Use pal log (not deferred, this file prints the deferred records) */
+#define LOG_LEVEL_FILE LOG_LEVEL_WARN
+#include "pal/log.h"
+
+#include <stdarg.h>
+#include <string.h>
+#include "dlog.h"
+
+/* One recorded call */
+typedef union
+{
+    int i;
+    long l;
+    long long ll;
+    double d;
+    const void * p;
+} dlog_arg_t;
+
+typedef struct
+{
+    /* Slot sequence (see dlog_write), relative to the slot index so a zeroed ring is valid */
+    uint32_t seq;
+    const char * fmt;
+    const char * file;
+    uint16_t line;
+    uint8_t level;
+    uint8_t flevel;
+    uint8_t nargs;
+    uint32_t types;
+    dlog_arg_t args[DLOG_MAX_ARGS];
+    char str[DLOG_STR_BYTES];
+} dlog_rec_t;
+
+/* Multi-producer, single-consumer ring (bounded queue with per-slot sequence numbers)
+ * A producer claims position pos by moving head with a CAS once slot seq == pos,
+ * fills it, then publishes with seq = pos + 1. The consumer frees it with seq = pos + SIZE.
+ */
+#define DLOG_MASK (DLOG_RING_SIZE - 1)
+static dlog_rec_t dlog_ring[DLOG_RING_SIZE];
+static uint32_t dlog_head = 0;
+static uint32_t dlog_tail = 0;
+static uint32_t dlog_dropped = 0;
+
+/* Formatting task */
+static task_t dlog_task_handle = NULL;
+
+/* Runtime log threshold (see pal/log.h), everything above the compile-time floor by default */
+volatile log_level_t log_level_runtime = LOG_LEVEL_DEBUG;
+
+/* Slot sequence with the index offset applied */
+static inline uint32_t dlog_seq_get(uint32_t pos)
+{
+    return __atomic_load_n(&dlog_ring[pos & DLOG_MASK].seq,__ATOMIC_ACQUIRE) + (pos & DLOG_MASK);
+}
+static inline void dlog_seq_set(uint32_t pos, uint32_t seq)
+{
+    __atomic_store_n(&dlog_ring[pos & DLOG_MASK].seq,seq - (pos & DLOG_MASK),__ATOMIC_RELEASE);
+}
+
+/* Record one call, this is the hot path */
+void dlog_write(const char * file, int line, int level, int flevel, const char * fmt, int nargs, uint32_t types, ...)
+{
+    /* Claim a slot */
+    uint32_t pos = __atomic_load_n(&dlog_head,__ATOMIC_RELAXED);
+    while(1)
+    {
+        int32_t dif = (int32_t)(dlog_seq_get(pos) - pos);
+        if(!dif)
+        {
+            if(__atomic_compare_exchange_n(&dlog_head,&pos,pos + 1,true,__ATOMIC_RELAXED,__ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if(dif < 0)
+        {
+            /* Full, the formatter has fallen behind */
+            __atomic_fetch_add(&dlog_dropped,1,__ATOMIC_RELAXED);
+            return;
+        }
+        else
+        {
+            pos = __atomic_load_n(&dlog_head,__ATOMIC_RELAXED);
+        }
+    }
+
+    /* Copy the call */
+    dlog_rec_t * rec = &dlog_ring[pos & DLOG_MASK];
+    rec->fmt = fmt;
+    rec->file = file;
+    rec->line = line;
+    rec->level = level;
+    rec->flevel = flevel;
+    rec->nargs = nargs > DLOG_MAX_ARGS ? DLOG_MAX_ARGS : nargs;
+    rec->types = types;
+
+    va_list ap;
+    va_start(ap,types);
+    size_t str_used = 0;
+    for(int i = 0; i < rec->nargs; i++)
+    {
+        switch((types >> (3 * i)) & 7)
+        {
+        case DLOG_T_LONG:
+            rec->args[i].l = va_arg(ap,long);
+            break;
+        case DLOG_T_LL:
+            rec->args[i].ll = va_arg(ap,long long);
+            break;
+        case DLOG_T_DBL:
+            rec->args[i].d = va_arg(ap,double);
+            break;
+        case DLOG_T_STR:
+        {
+            /* Strings may not outlive the call, so copy what fits */
+            const char * s = va_arg(ap,const char *);
+            char * dst = &rec->str[str_used];
+            size_t room = DLOG_STR_BYTES - str_used;
+            rec->args[i].p = dst;
+            if(!room)
+            {
+                rec->args[i].p = "";
+                break;
+            }
+            size_t n = s ? strnlen(s,room - 1) : 0;
+            memcpy(dst,s ? s : "",n);
+            dst[n] = 0;
+            str_used += n + 1;
+            break;
+        }
+        case DLOG_T_PTR:
+            rec->args[i].p = va_arg(ap,const void *);
+            break;
+        default:
+            rec->args[i].i = va_arg(ap,int);
+            break;
+        }
+    }
+    va_end(ap);
+
+    /* Publish */
+    dlog_seq_set(pos,pos + 1);
+}
+
+/* Format a record into out, one conversion at a time using the recorded types */
+static void dlog_format(const dlog_rec_t * rec, char * out, size_t size)
+{
+    const char * f = rec->fmt;
+    size_t o = 0;
+    int arg = 0;
+    while(*f && o + 1 < size)
+    {
+        if(*f != '%')
+        {
+            out[o++] = *f++;
+            continue;
+        }
+        if(f[1] == '%')
+        {
+            out[o++] = '%';
+            f += 2;
+            continue;
+        }
+
+        /* Copy one conversion spec (flags, width, precision, length, conversion) */
+        char spec[16];
+        size_t s = 0;
+        spec[s++] = *f++;
+        while(*f && s < sizeof(spec) - 1 && !strchr("diouxXeEfFgGaAcspn",*f))
+        {
+            spec[s++] = *f++;
+        }
+        if(*f && s < sizeof(spec) - 1)
+        {
+            spec[s++] = *f++;
+        }
+        spec[s] = 0;
+
+        if(arg >= rec->nargs)
+        {
+            /* Missing argument, print the spec as-is */
+            o += snprintf(&out[o],size - o,"%s",spec);
+        }
+        else
+        {
+            const dlog_arg_t * a = &rec->args[arg];
+            switch((rec->types >> (3 * arg)) & 7)
+            {
+            case DLOG_T_LONG: o += snprintf(&out[o],size - o,spec,a->l); break;
+            case DLOG_T_LL: o += snprintf(&out[o],size - o,spec,a->ll); break;
+            case DLOG_T_DBL: o += snprintf(&out[o],size - o,spec,a->d); break;
+            case DLOG_T_STR:
+            case DLOG_T_PTR: o += snprintf(&out[o],size - o,spec,a->p); break;
+            default: o += snprintf(&out[o],size - o,spec,a->i); break;
+            }
+            arg++;
+        }
+        if(o >= size)
+        {
+            o = size - 1;
+        }
+    }
+    out[o] = 0;
+}
+
+/* Print everything waiting in the ring */
+static void dlog_drain()
+{
+    while(dlog_seq_get(dlog_tail) == dlog_tail + 1)
+    {
+        dlog_rec_t * rec = &dlog_ring[dlog_tail & DLOG_MASK];
+        char text[128];
+        dlog_format(rec,text,sizeof(text));
+
+        /* Same outputs as the immediate LOG_* macros, but formatted once */
+        switch(log_check(rec->file,rec->line,rec->level,rec->flevel))
+        {
+        case 2:
+            fputs(text,fd);
+        case 1:
+            puts(text);
+        }
+
+        dlog_seq_set(dlog_tail,dlog_tail + DLOG_RING_SIZE);
+        dlog_tail++;
+    }
+}
+
+/* Formatting task */
+static void dlog_task(void * param)
+{
+    uint32_t dropped_last = 0;
+    while(1)
+    {
+        PROF_BEGIN(PROF_DLOG);
+        dlog_drain();
+        PROF_END(PROF_DLOG);
+
+        uint32_t dropped = dlog_get_dropped();
+        if(dropped != dropped_last)
+        {
+            LOG_WARN("DLOG: Ring full, %d records dropped",(int)(dropped - dropped_last));
+            dropped_last = dropped;
+        }
+        delay(DLOG_PERIOD);
+    }
+}
+
+/* Start the formatting task, records made before this are kept until it runs */
+void dlog_init()
+{
+    if(dlog_task_handle)
+    {
+        return;
+    }
+    /* Below the control task so formatting only uses idle time */
+    dlog_task_handle = task_create(dlog_task,NULL,TASK_PRIORITY_DEFAULT-2,TASK_STACK_DEPTH_DEFAULT,"dlog");
+    if(!dlog_task_handle)
+    {
+        LOG_ERROR("DLOG: Unable to start task");
+    }
+}
+
+uint32_t dlog_get_dropped()
+{
+    return __atomic_load_n(&dlog_dropped,__ATOMIC_RELAXED);
+}
@@ -0,0 +1,171 @@
+/* Endurance runs */
+#include "main.h"
+
+/* Use pal log, deferred since this runs every tick */
+#define LOG_LEVEL_FILE LOG_LEVEL_INFO
+#define LOG_DEFERRED
+#include "pal/log.h"
+
+#include "endure.h"
+
+/* One period of a run */
+typedef struct
+{
+    uint16_t feeds;
+    uint16_t shots;
+    /* Recovery times (s) */
+    double rec_sum;
+    double rec_max;
+    /* J */
+    double energy;
+    /* Lowest battery (mV) */
+    int32_t batt_min;
+    /* s */
+    double time;
+} endure_period_t;
+
+/* Run state, control task only */
+static struct
+{
+    endure_state_t state;
+    uint8_t lead;
+    float target;
+    int minute;
+    endure_period_t now;
+    /* First minute's average recovery (s), 0 until a minute had shots */
+    double first_avg;
+    /* Slowest minute's average recovery (s) */
+    double worst_avg;
+    int32_t batt_start;
+    uint32_t feeds;
+    uint32_t shots;
+} endure_run;
+
+
+endure_state_t endure_state()
+{
+    return endure_run.state;
+}
+
+static int32_t endure_battery()
+{
+    int32_t mv = battery_get_voltage();
+    return (PROS_ERR == mv) ? 0 : mv;
+}
+
+static void endure_period_reset()
+{
+    memset(&endure_run.now,0,sizeof(endure_run.now));
+    endure_run.now.batt_min = INT32_MAX;
+}
+
+/* Summarize the period and start the next */
+static void endure_summary()
+{
+    endure_period_t * p = &endure_run.now;
+    endure_run.minute++;
+    double avg = p->shots ? p->rec_sum / p->shots : 0.0;
+    if(p->shots && endure_run.first_avg <= 0.0)
+    {
+        endure_run.first_avg = avg;
+    }
+    if(avg > endure_run.worst_avg)
+    {
+        endure_run.worst_avg = avg;
+    }
+    int degrade = 0;
+    if(p->shots && endure_run.first_avg > 0.0)
+    {
+        degrade = (int)lround((avg / endure_run.first_avg - 1.0) * 100.0);
+    }
+    double hottest = thermal_group_temp(endure_run.lead);
+    int32_t batt = (INT32_MAX == p->batt_min) ? 0 : p->batt_min;
+
+    LOG_INFO("ENDURE: Minute %d: %d/%d shots, recovery %f s avg %f s max (%d%% from the first), %f J",
+             endure_run.minute,(int)p->shots,(int)p->feeds,avg,p->rec_max,degrade,p->energy);
+    LOG_INFO("ENDURE: Minute %d: %f C, battery %d mV low (%d mV drop)",endure_run.minute,hottest,(int)batt,
+             (int)(endure_run.batt_start - batt));
+    REPORT_EV(endure_run.lead,REPORT_EV_INFO,"END %d: %d/%d rec %1.2f/%1.2fs %+d%% %dJ %dC %1.1fV",endure_run.minute,
+              (int)p->shots,(int)p->feeds,avg,p->rec_max,degrade,(int)p->energy,(int)hottest,batt / 1000.0);
+    endure_period_reset();
+}
+
+void endure_start(uint8_t lead, float target)
+{
+    endure_stop();
+    memset(&endure_run,0,sizeof(endure_run));
+    endure_run.state = ENDURE_RUNNING;
+    endure_run.lead = lead;
+    endure_run.target = target;
+    endure_run.batt_start = endure_battery();
+    endure_period_reset();
+    LOG_INFO("ENDURE: Starting on group %s, target recovery %f s",groups[lead].name,target);
+    REPORT_EV(lead,REPORT_EV_INFO,"ENDURE: Starting, target recovery %1.2f s",target);
+}
+
+void endure_stop()
+{
+    if(ENDURE_RUNNING != endure_run.state)
+    {
+        return;
+    }
+    /* A part minute counts too, unless the run ended on a minute */
+    if(endure_run.now.feeds || endure_run.now.shots || endure_run.now.time >= 1.0)
+    {
+        endure_summary();
+    }
+    int missed = (int)endure_run.feeds - (int)endure_run.shots;
+    if(missed < 0) missed = 0;
+    bool pass = endure_run.shots && !missed && endure_run.worst_avg <= endure_run.target;
+    endure_run.state = pass ? ENDURE_PASS : ENDURE_FAIL;
+    LOG_INFO("ENDURE: %s, %d shots, %d missed, slowest minute %f s avg, target %f s",pass ? "PASS" : "FAIL",
+             (int)endure_run.shots,missed,endure_run.worst_avg,endure_run.target);
+    REPORT_EV(endure_run.lead,REPORT_EV_INFO,"ENDURE: %s, %d missed, slowest %1.2f s (%1.2f)",pass ? "PASS" : "FAIL",
+              missed,endure_run.worst_avg,endure_run.target);
+}
+
+void endure_tick()
+{
+    if(ENDURE_RUNNING != endure_run.state)
+    {
+        return;
+    }
+    endure_period_t * p = &endure_run.now;
+    p->energy += groups[endure_run.lead].data.power * dt;
+    int32_t batt = endure_battery();
+    if(batt && batt < p->batt_min)
+    {
+        p->batt_min = batt;
+    }
+    p->time += dt;
+    if(p->time >= ENDURE_PERIOD)
+    {
+        endure_summary();
+    }
+}
+
+void endure_feed()
+{
+    if(ENDURE_RUNNING != endure_run.state)
+    {
+        return;
+    }
+    endure_run.now.feeds++;
+    endure_run.feeds++;
+}
+
+void endure_shot(uint8_t lead, float time)
+{
+    if(ENDURE_RUNNING != endure_run.state || lead != endure_run.lead)
+    {
+        return;
+    }
+    endure_period_t * p = &endure_run.now;
+    p->shots++;
+    endure_run.shots++;
+    p->rec_sum += time;
+    if(time > p->rec_max)
+    {
+        p->rec_max = time;
+    }
+}
@@ -0,0 +1,110 @@
+/* Binary frame codec (COBS framing with CRC16) */
+#include "frame.h"
+
+/* CRC16-CCITT, bytewise without a table */
+uint16_t frame_crc16(const uint8_t * buf, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for(size_t i = 0; i < len; i++)
+    {
+        uint8_t x = (crc >> 8) ^ buf[i];
+        x ^= x >> 4;
+        crc = (crc << 8) ^ ((uint16_t)x << 12) ^ ((uint16_t)x << 5) ^ (uint16_t)x;
+    }
+    return crc;
+}
+
+/* Encode a payload into a delimited frame */
+size_t frame_encode(const uint8_t * payload, size_t len, uint8_t * out)
+{
+    if(len > FRAME_MAX_PAYLOAD)
+    {
+        return 0;
+    }
+
+    /* Append the CRC to a local copy so COBS can run over one buffer */
+    uint8_t raw[FRAME_MAX_PAYLOAD + 2];
+    for(size_t i = 0; i < len; i++)
+    {
+        raw[i] = payload[i];
+    }
+    frame_put_u16(&raw[len],frame_crc16(payload,len));
+    len += 2;
+
+    /* Leading delimiter lets the receiver resync after stray text on the port */
+    size_t o = 0;
+    out[o++] = FRAME_DELIM;
+
+    /* COBS: each block starts with a code byte giving the distance to the next zero */
+    size_t code_pos = o++;
+    uint8_t code = 1;
+    for(size_t i = 0; i < len; i++)
+    {
+        if(raw[i] == 0)
+        {
+            out[code_pos] = code;
+            code_pos = o++;
+            code = 1;
+        }
+        else
+        {
+            out[o++] = raw[i];
+            code++;
+            if(code == 0xFF)
+            {
+                out[code_pos] = code;
+                code_pos = o++;
+                code = 1;
+            }
+        }
+    }
+    out[code_pos] = code;
+
+    /* Trailing delimiter */
+    out[o++] = FRAME_DELIM;
+    return o;
+}
+
+/* Decode the bytes between two delimiters */
+int frame_decode(const uint8_t * in, size_t len, uint8_t * out, size_t out_max)
+{
+    size_t o = 0;
+    size_t i = 0;
+    while(i < len)
+    {
+        uint8_t code = in[i++];
+        if(code == 0)
+        {
+            return -1;
+        }
+        for(uint8_t j = 1; j < code; j++)
+        {
+            if(i >= len || o >= out_max || in[i] == 0)
+            {
+                return -1;
+            }
+            out[o++] = in[i++];
+        }
+        /* A short block implies a zero, except at the very end */
+        if(code != 0xFF && i < len)
+        {
+            if(o >= out_max)
+            {
+                return -1;
+            }
+            out[o++] = 0;
+        }
+    }
+
+    /* Need at least the CRC */
+    if(o < 2)
+    {
+        return -1;
+    }
+    o -= 2;
+    if(frame_get_u16(&out[o]) != frame_crc16(out,o))
+    {
+        return -1;
+    }
+    return (int)o;
+}
@@ -0,0 +1,302 @@
+/* Motor groups, command path and detectors */
+#include "main.h"
+
+
+/* Use pal log, deferred since this runs every tick */
+#define LOG_LEVEL_FILE LOG_LEVEL_DEBUG
+#define LOG_DEFERRED
+#include "pal/log.h"
+
+
+/* Groups by leader index */
+group_t groups[NUM_MOTORS];
+
+
+/* Drop whatever the detectors were measuring */
+static void group_reset(group_t * grp)
+{
+    memset(&grp->data,0,sizeof(grp->data));
+}
+
+void group_update()
+{
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        uint8_t members[NUM_MOTORS];
+        uint8_t count = 0;
+        if(motors[i].port >= 0 && motors[i].leader < 0)
+        {
+            members[count++] = i;
+            for(int j = 0; j < NUM_MOTORS; j++)
+            {
+                if(motors[j].port >= 0 && motors[j].leader == i)
+                {
+                    members[count++] = j;
+                }
+            }
+        }
+
+        group_t * grp = &groups[i];
+        if(count == grp->count && !memcmp(members,grp->members,count))
+        {
+            continue;
+        }
+
+        /* Membership changed, measurements so far were of a different flywheel */
+        memcpy(grp->members,members,count);
+        grp->count = count;
+        grp->valid = 0;
+        for(int j = 0; j < count; j++)
+        {
+            grp->name[j] = 'A' + members[j];
+        }
+        grp->name[count] = 0;
+        group_reset(grp);
+        if(count)
+        {
+            LOG_DEBUG("GROUP %c: Members %s",('A'+i),grp->name);
+        }
+    }
+}
+
+/* Spinup detector */
+static void group_spinup(uint8_t idx, bool powered, int target)
+{
+    group_t * grp = &groups[idx];
+    if(!powered)
+    {
+        /* Arm spinup if we are not powered and below 5 RPM */
+        if(fabs(grp->data.speed) <= 5.0)
+        {
+            if(!grp->data.spinup.armed)
+            {
+                LOG_DEBUG("GROUP %s Arming Spinup Detector",grp->name);
+                REPORT_EV(idx,REPORT_EV_SPINUP,"GRP %s: Arming Spinup Detector",grp->name);
+                telem_event(idx,TELEM_EV_SPINUP_ARM,0,0,0);
+                grp->data.spinup.armed = true;
+                /* Reset accum data */
+                grp->data.spinup.speed_max = 0.0;
+                grp->data.spinup.energy = 0.0;
+                grp->data.spinup.time = 0.0;
+            }
+            else if(grp->data.spinup.speed_max > 0.0)
+            {
+                /* Spinup detector was armed, and never finished */
+                LOG_DEBUG("GROUP %s Rearming Spinup Detector, Spinup Never Completed",grp->name);
+                REPORT_EV(idx,REPORT_EV_SPINUP,"GRP %s: Rearming, Spinup Never Completed",grp->name);
+                telem_event(idx,TELEM_EV_SPINUP_REARM,0,0,0);
+                grp->data.spinup.armed = true;
+                /* Reset accum data */
+                grp->data.spinup.speed_max = 0.0;
+                grp->data.spinup.energy = 0.0;
+                grp->data.spinup.time = 0.0;
+            }
+        }
+        return;
+    }
+    if(!grp->data.spinup.armed)
+    {
+        return;
+    }
+
+    /* Powered and armed, note how hot it started then accumulate energy and time */
+    if(0.0 == grp->data.spinup.time)
+    {
+        grp->data.spinup.temp = thermal_group_temp(idx);
+    }
+    grp->data.spinup.energy += dt*grp->data.power;
+    grp->data.spinup.time += dt;
+
+    /* If we reached 66%, 95%, 99%, report */
+    static const double trips[] = {0.66, 0.95, 0.99};
+    static const telem_event_t trip_ev[] = {TELEM_EV_SPINUP_66, TELEM_EV_SPINUP_95, TELEM_EV_SPINUP_99};
+    static const results_type_t trip_res[] = {RESULTS_SPINUP_66, RESULTS_SPINUP_95, RESULTS_SPINUP_99};
+    for(int t = 0; t < 3; t++)
+    {
+        /* We have crossed the trip, and the last speed was below it */
+        if((grp->data.speed >= ((double)target*trips[t])) &&
+           (grp->data.spinup.speed_max < ((double)target*trips[t])))
+        {
+            int pct = (int)(trips[t] * 100.0 + 0.5);
+            LOG_ALWAYS("GROUP %s: SPINUP Reached %d%% in %f sec (%f J)",grp->name,pct,grp->data.spinup.time,grp->data.spinup.energy);
+            REPORT_EV(idx,REPORT_EV_SPINUP,"GRP %s: SPINUP %d%% in %1.2f sec (%1.3f J)",grp->name,pct,grp->data.spinup.time,grp->data.spinup.energy);
+            telem_event(idx,trip_ev[t],grp->data.spinup.time,grp->data.spinup.energy,0);
+            results_add(idx,trip_res[t],grp->data.spinup.time,grp->data.spinup.energy,grp->data.spinup.temp);
+        }
+    }
+    /* De-arm spinup detect after 99%, must spindown to re-run test */
+    if(grp->data.speed >= ((double)target*0.99))
+    {
+        grp->data.spinup.armed = false;
+        LOG_DEBUG("GROUP %s: Disarming spinup detector",grp->name);
+    }
+    /* Store max speed for spinup detector only if new speed is higher than last speed */
+    if(grp->data.spinup.speed_max < grp->data.speed)
+    {
+        grp->data.spinup.speed_max = grp->data.speed;
+    }
+}
+
+/* Shot detector */
+static void group_shot(uint8_t idx, bool powered, int target)
+{
+    group_t * grp = &groups[idx];
+    if(!powered)
+    {
+        /* Disarm for sure */
+        grp->data.shot.armed = false;
+    }
+    else if(!grp->data.shot.armed)
+    {
+        /* Check if we should arm it */
+        if(grp->data.speed >= (double)target*0.95)
+        {
+            LOG_DEBUG("GROUP %s Arming Shot Detector",grp->name);
+            REPORT_EV(idx,REPORT_EV_SHOT,"GRP %s: Arming Shot Detector",grp->name);
+            telem_event(idx,TELEM_EV_SHOT_ARM,0,0,0);
+            grp->data.shot.armed = true;
+            grp->data.shot.energy = 0.0;
+            grp->data.shot.inprog = false;
+            grp->data.shot.min_speed = target;
+            grp->data.shot.time = 0.0;
+        }
+    }
+    /* Check if we are not inprog and if we should be */
+    else if(!grp->data.shot.inprog)
+    {
+        /* If we get an accel < -2000, we become inprog */
+        if(grp->data.accel < -2000.0)
+        {
+            LOG_DEBUG("GROUP %s Shot Detected",grp->name);
+            REPORT_EV(idx,REPORT_EV_SHOT,"GRP %s: Shot Detected",grp->name);
+            telem_event(idx,TELEM_EV_SHOT_START,0,0,0);
+            grp->data.shot.inprog = true;
+        }
+    }
+    /* Otherwise we are both armed and inprog */
+    else
+    {
+        /* Accumulate time and energy */
+        grp->data.shot.energy += grp->data.power*dt;
+        grp->data.shot.time += dt;
+
+        /* Check min speed we reached */
+        if(grp->data.speed < grp->data.shot.min_speed)
+        {
+            grp->data.shot.min_speed = grp->data.speed;
+        }
+
+        /* If we reach 95% of target, report */
+        if(grp->data.speed >= (double)target*0.95)
+        {
+            double min_pct = grp->data.shot.min_speed / (double)target * 100.0;
+            LOG_DEBUG("GROUP %s Shot Returned, took %f sec (%f J), Min speed of %f (%f %%)",
+                      grp->name,grp->data.shot.time,grp->data.shot.energy,grp->data.shot.min_speed,min_pct);
+            REPORT_EV(idx,REPORT_EV_SHOT,"GRP %s: Shot Complete, Took %1.2f sec (%1.3f J)",
+                      grp->name,grp->data.shot.time,grp->data.shot.energy);
+            REPORT_EV(idx,REPORT_EV_SHOT,"GRP %s: Shot min speed was %3.0f (%3.0f %%)",
+                      grp->name,grp->data.shot.min_speed,min_pct);
+            telem_event(idx,TELEM_EV_SHOT_DONE,grp->data.shot.time,grp->data.shot.energy,grp->data.shot.min_speed);
+            results_add(idx,RESULTS_SHOT,grp->data.shot.time,grp->data.shot.energy,grp->data.shot.min_speed);
+            dash_shot(idx,grp->data.shot.time,min_pct);
+            endure_shot(idx,grp->data.shot.time);
+            /* End inprog and arm */
+            grp->data.shot.armed = false;
+            grp->data.shot.inprog = false;
+        }
+    }
+}
+
+/* Running energy usage */
+static void group_power(uint8_t idx, bool powered)
+{
+    group_t * grp = &groups[idx];
+    if(!powered)
+    {
+        grp->data.run.time = 0.0;
+        grp->data.run.energy = 0.0;
+        return;
+    }
+
+    /* Accum energy and time */
+    grp->data.run.energy += grp->data.power*dt;
+    grp->data.run.time += dt;
+
+    /* At 5sec, print the data */
+    if(grp->data.run.time > 5.0)
+    {
+        double avg = grp->data.run.energy/grp->data.run.time;
+        LOG_ALWAYS("GROUP %s Runtime Power %f W avg",grp->name,avg);
+        REPORT_EV(idx,REPORT_EV_POWER,"GRP %s: Runtime Power %2.2f W avg",grp->name,avg);
+        telem_event(idx,TELEM_EV_RUN_POWER,avg,grp->data.run.energy,grp->data.run.time);
+        results_add(idx,RESULTS_RUN_POWER,avg,grp->data.run.energy,grp->data.run.time);
+        grp->data.run.time = 0.0;
+        grp->data.run.energy = 0.0;
+    }
+}
+
+void group_run(uint8_t idx)
+{
+    group_t * grp = &groups[idx];
+    if(!grp->count)
+    {
+        return;
+    }
+    bool powered = motors[idx].powered;
+    int target = motors[idx].target;
+
+    /* One command path for every member */
+    for(int i = 0; i < grp->count; i++)
+    {
+        motor_command(grp->members[i],powered,target);
+    }
+
+    /* Combine the members that have valid samples, a short gap holds a member's last sample */
+    uint8_t valid = 0;
+    int n = 0;
+    double speed = 0.0, curr = 0.0, power = 0.0;
+    for(int i = 0; i < grp->count; i++)
+    {
+        motor_t * m = &motors[grp->members[i]];
+        if(!m->data.valid)
+        {
+            continue;
+        }
+        valid |= (1 << m->idx);
+        n++;
+        speed += m->data.speed;
+        curr += m->data.curr;
+        power += m->data.power;
+    }
+
+    /* A member lost or back changes what is being measured, start the detectors over */
+    bool restart = (valid != grp->valid);
+    if(restart && grp->valid)
+    {
+        REPORT_EV(idx,REPORT_EV_INFO,"GRP %s: %d of %d members answering, tests restarted",grp->name,n,grp->count);
+        group_reset(grp);
+    }
+    grp->valid = valid;
+    if(!n)
+    {
+        /* Nothing to measure, detectors paused */
+        dash_speed(idx,target,MOTOR_SPEED_INVALID);
+        return;
+    }
+
+    double speed_last = restart ? speed / n : grp->data.speed;
+    grp->data.speed = speed / n;
+    grp->data.curr = curr;
+    grp->data.power = power;
+
+    /* Calculated parameters */
+    grp->data.accel = (grp->data.speed - speed_last) / dt;
+    double filt_const = 0.1;
+    grp->data.accel_filt = filt_const * grp->data.accel + (1.0-filt_const) * grp->data.accel_filt;
+
+    group_spinup(idx,powered,target);
+    group_shot(idx,powered,target);
+    group_power(idx,powered);
+
+    dash_speed(idx,target,(int16_t)grp->data.speed);
+}
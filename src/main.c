@@ -9,12 +9,6 @@
 /* Include all of our files */
 #include "motor.h"
 
-/* Controller code */
-void controller()
-{
-	/* Check if we actually have a controller, and leave if we don't */
-}
-
 /**
  * Runs initialization code. This occurs as soon as the program is started.
  *
@@ -26,14 +20,37 @@ void initialize()
 	/* Initiailze logger */
 	log_init();
 
+	/* Start the deferred log formatter */
+	dlog_init();
+
 	/* Let them know we are in initialize */
 	LOG_ALWAYS("In Initialize");
 
+	/* Create the control/graphics message queues */
+	msg_init();
+
+	/* Measure what the UI costs */
+	uiprof_init();
+	prof_init();
+	taskmon_init();
+
 	/* Initialize styles */
 	style_init();
 
 	/* Initiailze device allocations */
 	motor_init();
+
+	/* Initialize telemetry stream */
+	telem_init();
+
+	/* Open the result store */
+	results_init();
+
+	/* Load the test script */
+	script_init();
+
+	/* Start the controller dashboard */
+	dash_init();
 }
 
 /**
@@ -108,15 +125,59 @@ void opcontrol()
 
 	while(1)
 	{
-		/* Process each motor */
+		uint64_t tick_start = micros();
+		PROF_BEGIN(PROF_TICK);
+
+		/* Apply configuration changes from the screen */
+		PROF_BEGIN(PROF_MSG);
+		msg_ctrl_apply();
+		PROF_END(PROF_MSG);
+
+		/* Run the test script's steps for this tick */
+		PROF_BEGIN(PROF_SCRIPT);
+		script_tick();
+		PROF_END(PROF_SCRIPT);
+
+		/* Sample every motor */
+		PROF_BEGIN(PROF_SAMPLE);
 		for(int i = 0; i < NUM_MOTORS; i++)
 		{
-			/* Set speeds and data log */
-			motor_run(i);
+			motor_sample(i);
+		}
+		PROF_END(PROF_SAMPLE);
 
-			/* Update graphics */
-			run_update_speeds(i);
+		/* Command each group and run its detectors on the combined samples */
+		PROF_BEGIN(PROF_GROUP);
+		group_update();
+		for(int i = 0; i < NUM_MOTORS; i++)
+		{
+			group_run(i);
 		}
+		PROF_END(PROF_GROUP);
+
+		/* Send the speeds to the graphics task */
+		PROF_BEGIN(PROF_UI_POST);
+		for(int i = 0; i < NUM_MOTORS; i++)
+		{
+			int target = (motors[i].leader >= 0) ? motors[motors[i].leader].target : motors[i].target;
+			int16_t speed = motors[i].data.valid ? (int16_t)motors[i].data.speed : MOTOR_SPEED_INVALID;
+			msg_ui_post(MSG_UI_SPEED,i,target,speed);
+		}
+		PROF_END(PROF_UI_POST);
+
+		/* Send this tick's samples */
+		PROF_BEGIN(PROF_TELEM);
+		telem_tick();
+		PROF_END(PROF_TELEM);
+
+		/* Add this tick to the strip chart */
+		PROF_BEGIN(PROF_PLOT);
+		plot_tick();
+		PROF_END(PROF_PLOT);
+
+		/* Time spent in this tick, for the UI profiler */
+		PROF_END(PROF_TICK);
+		uiprof_ctrl(micros() - tick_start);
 		delay(dt*1000);
 	}
 
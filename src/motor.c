@@ -2,8 +2,9 @@
 #include "main.h"
 
 
-/* Use pal log */
+/* Use pal log, deferred since this runs every tick */
 #define LOG_LEVEL_FILE LOG_LEVEL_DEBUG
+#define LOG_DEFERRED
 #include "pal/log.h"
 
 
@@ -14,6 +15,12 @@ motor_t motors[NUM_MOTORS];
 static const int inc_amt[] = {5, 5, 10};
 static const int max_spd[] = {100, 200, 600};
 
+/* Highest target for a motor's gearset */
+int motor_max_speed(uint8_t idx)
+{
+    return max_spd[motors[idx].gearset];
+}
+
 /* Function to update a motor to its max speed when gear ratio is changed */
 void motor_reset_max(uint8_t idx)
 {
@@ -34,78 +41,223 @@ void motor_inc(uint8_t idx, int8_t direction)
     if(motors[idx].target > max_spd[motors[idx].gearset]) motors[idx].target = max_spd[motors[idx].gearset];
 }
 
-/* Functions to operate on motors */
-void motor_init()
+/* Toggle power of a leader */
+void motor_toggle_power(uint8_t idx)
 {
-    LOG_DEBUG("Init Motors");
-    int nextAlloc = 0;
+    motors[idx].powered = !motors[idx].powered;
+    LOG_DEBUG("Changing motor state for %c to %d",('A'+idx),motors[idx].powered);
+}
+
+/* Start a spinup test, power on only once the spinup detector has re-armed */
+void motor_start_test(uint8_t idx)
+{
+    if(motors[idx].powered)
+    {
+        REPORT_EV(idx,REPORT_EV_SPINUP,"MTR %c: Test not started, already powered",idx+'A');
+        return;
+    }
+    if(!groups[idx].data.spinup.armed)
+    {
+        REPORT_EV(idx,REPORT_EV_SPINUP,"MTR %c: Test not started, still spinning down",idx+'A');
+        return;
+    }
+    motors[idx].powered = true;
+    LOG_DEBUG("Starting spinup test on motor %c",('A'+idx));
+}
+
+/* Toggle reversed */
+void motor_toggle_reverse(uint8_t idx)
+{
+    motors[idx].reversed = !motors[idx].reversed;
+    LOG_DEBUG("Updating reverse on motor %c, value is now %d",(idx+'A'),motors[idx].reversed);
+}
 
-    /* Iterate through all V5 ports to find the first 4 motors (A,B,C,D) */
-    for(int i = 0; i < 21; i++)
-	{
-		v5_device_e_t type = registry_get_plugged_type(i);
-		LOG_DEBUG("Port %02d has device class %03d",(i+1),type);
+/* Move a leader to the next gearset, followers take it too */
+void motor_next_gearset(uint8_t idx)
+{
+    /* Followers can't update gearset */
+    if(motors[idx].leader >= 0)
+    {
+        LOG_WARN("Can't update gearset on motor %c since it's a follower",('A'+idx));
+        return;
+    }
 
-        /* If it's a motor, set it as the next alloc motor */
-        if(E_DEVICE_MOTOR == type)
+    /* Increment gearset and roll over */
+    motors[idx].gearset++;
+    if(motors[idx].gearset > E_MOTOR_GEARSET_06) motors[idx].gearset = 0;
+    LOG_DEBUG("Updating gearset on motor %c, value is now %d",('A'+idx),motors[idx].gearset);
+    /* Reset target speed to max for this gearset */
+    motor_reset_max(idx);
+
+    /* Check if we have any followers and update them too */
+    for(int i = idx + 1; i < NUM_MOTORS;i++)
+    {
+        if(motors[i].leader == idx)
         {
-            /* Configure this motor with defaults */
-            motors[nextAlloc].idx = nextAlloc;
-            motors[nextAlloc].port = i+1; /* i is zero-indexed */
-            motors[nextAlloc].gearset = E_MOTOR_GEARSET_06;
-            motors[nextAlloc].leader = -1;
-            motors[nextAlloc].reversed = false;
-            motors[nextAlloc].powered = false;
-            motors[nextAlloc].target = 600; /* Max for gearset 06 */
-            LOG_ALWAYS("Found motor on port %02d, allocating as motor %c",(i+1),(nextAlloc+'A'));
-            nextAlloc++;
+            LOG_DEBUG("Updating gearset for motor %c since it follows %c",('A'+i),('A'+idx));
+            motors[i].gearset = motors[idx].gearset;
+            motors[i].target = motors[idx].target;
         }
+    }
+}
+
+/* Toggle between leader and follower of the nearest leader to the left */
+void motor_toggle_lead(uint8_t idx)
+{
+    /* If we are currently a follower, promote ourselves to leader
+     * We kick our followers onto our leader when we follow
+     * So we can't have any followers ourselves at this point
+     */
+    if(motors[idx].leader >= 0)
+    {
+        /* Promote ourself, and turn ourself off */
+        LOG_DEBUG("Promoting motor %c to leader",('A'+idx));
+        motors[idx].powered = 0;
+        motors[idx].leader = -1;
+        return;
+    }
+
+    /* The first motor cannot be assigned a leader */
+    if(idx == 0)
+    {
+        LOG_WARN("Trying to make motor %c a follower, but it cannot be a follower",('A'+idx));
+        return;
+    }
 
-        /* If we have allocated too many motors, break out early */
-        if(nextAlloc >= NUM_MOTORS)
+    /* Motor does not have a leader assigned, look forward to find its leader */
+    for(int i = idx; i > 0; i--)
+    {
+        LOG_DEBUG("Trying to find leader for %c, checking %c",('A'+idx),('A'+i-1));
+        if(motors[i-1].leader < 0)
         {
+            LOG_DEBUG("Found leader, using %c",((i-1)+'A'));
+            motors[idx].leader = i-1;
             break;
         }
+    }
+
+    /* Take gearset and target from the leader */
+    motors[idx].gearset = motors[motors[idx].leader].gearset;
+    motors[idx].target = motors[motors[idx].leader].target;
+
+    /* Look back to the end of the list to see if anyone is following us
+     * If so, they need to follow our leader now
+     */
+    for(int i = idx + 1; i < NUM_MOTORS;i++)
+    {
+        if(motors[i].leader == idx)
+        {
+            LOG_DEBUG("Motor %c was following us, now needs to follow %c",(i+'A'),(motors[idx].leader+'A'));
+            motors[i].leader = motors[idx].leader;
+            motors[i].gearset = motors[motors[i].leader].gearset;
+            motors[i].target = motors[motors[i].leader].target;
+        }
+    }
+}
+
+/* Give a free motor slot a port, with default configuration */
+void motor_attach(uint8_t idx, int8_t port)
+{
+    if(motors[idx].port >= 0)
+    {
+        LOG_WARN("Motor %c is already on port %02d, not attaching port %02d",(idx+'A'),motors[idx].port,port);
+        return;
+    }
+    memset(&motors[idx].data,0,sizeof(motors[idx].data));
+    motors[idx].data.valid = true;
+    motors[idx].gearset = E_MOTOR_GEARSET_06;
+    motors[idx].leader = -1;
+    motors[idx].reversed = false;
+    motors[idx].powered = false;
+    motors[idx].target = 600; /* Max for gearset 06 */
+    motors[idx].port = port;
+    thermal_reset(idx);
+    LOG_ALWAYS("Allocating port %02d as motor %c",port,(idx+'A'));
+}
+
+/* Move a motor to the next motor port without a slot, keeping its configuration */
+void motor_next_port(uint8_t idx)
+{
+    int8_t port = ports_next_free(idx);
+    if(port < 0)
+    {
+        REPORT_EV(idx,REPORT_EV_INFO,"MTR %c: No free motor port",(idx+'A'));
+        return;
+    }
+    LOG_ALWAYS("Moving motor %c from port %02d to port %02d",(idx+'A'),motors[idx].port,port);
+    motor_brake(motors[idx].port);
+    memset(&motors[idx].data,0,sizeof(motors[idx].data));
+    motors[idx].data.valid = true;
+    motors[idx].powered = false;
+    motors[idx].port = port;
+    thermal_reset(idx);
+}
 
-	}
+/* Functions to operate on motors */
+void motor_init()
+{
+    LOG_DEBUG("Init Motors");
 
-    /* If we haven't allocated all motors, fill in the rest with -1 so they are unused */
-    for(int i = nextAlloc; i < NUM_MOTORS; i++)
+    /* Slots start free, ports come from the registry and the port cache */
+    int8_t ports[NUM_MOTORS];
+    ports_init(ports);
+    for(int i = 0; i < NUM_MOTORS; i++)
     {
         motors[i].idx = i;
         motors[i].port = -1;
         motors[i].leader = -1;
         motors[i].gearset = E_MOTOR_GEARSET_06;
-        LOG_ALWAYS("No more motors found for motor %c",(i+'A'));
+        if(ports[i] < 0)
+        {
+            LOG_ALWAYS("No motor found for motor %c",(i+'A'));
+            continue;
+        }
+        motor_attach(i,ports[i]);
     }
 }
 
-/* Function for runtime motor control */
-void motor_run(uint8_t idx)
-{   
-    if(motors[idx].port < 0)
+/* No answer this tick, hold the last sample */
+static void motor_missed(uint8_t idx)
+{
+    motor_t * mine = &motors[idx];
+    mine->data.missed += dt;
+    if(!mine->data.valid || mine->data.missed < MOTOR_LOST_TIME)
     {
-        /* Break out, invalid motor */
         return;
     }
 
-    /* Get a pointer to our motor to make it easier */
-    motor_t * mine = &motors[idx];
+    /* Gone too long to bridge, its group restarts its tests without it */
+    mine->data.valid = false;
+    LOG_WARN("MOTOR %c: No answer from port %02d for %f sec, samples invalid",(idx+'A'),mine->port,mine->data.missed);
+    REPORT_EV(idx,REPORT_EV_INFO,"MTR %c: Lost on port %02d",(idx+'A'),mine->port);
+    telem_event(idx,TELEM_EV_LOST,mine->port,0,0);
+}
 
-    /* Set brake mode to coast */
-    motor_set_brake_mode(mine->port,E_MOTOR_BRAKE_COAST);
+/* First answer after missed ticks, a short gap needs nothing as the group held the last sample */
+static void motor_found(uint8_t idx)
+{
+    motor_t * mine = &motors[idx];
+    double gap = mine->data.missed;
+    mine->data.missed = 0.0;
+    if(!mine->data.valid)
+    {
+        mine->data.valid = true;
+        LOG_WARN("MOTOR %c: Port %02d answering again after %f sec",(idx+'A'),mine->port,gap);
+        REPORT_EV(idx,REPORT_EV_INFO,"MTR %c: Back on port %02d after %1.1f sec",(idx+'A'),mine->port,gap);
+        telem_event(idx,TELEM_EV_FOUND,mine->port,gap,0);
+        return;
+    }
+    LOG_DEBUG("MOTOR %c: Held last sample for %f sec",(idx+'A'),gap);
+}
 
-    /* Get powered and target from leader if applicable */
-    bool powered = mine->powered;
-    int target = mine->target;
+/* Send the group's power and target to one member, called by group_run */
+void motor_command(uint8_t idx, bool powered, int target)
+{
+    motor_t * mine = &motors[idx];
     int direction = mine->reversed ? -1 : 1;
 
-    if(mine->leader >= 0)
-    {
-        powered = motors[mine->leader].powered;
-        target = motors[mine->leader].target;
-        /* Reversed does not come from the leader */
-    }
+    /* Set brake mode to coast */
+    motor_set_brake_mode(mine->port,E_MOTOR_BRAKE_COAST);
 
     /* If not powered, stop and update gearset */
     if(!powered)
@@ -118,177 +270,42 @@ void motor_run(uint8_t idx)
     {
         motor_move_velocity(mine->port,target*direction);
     }
+}
 
-    /* Read data parameters */
-    double speed_last = mine->data.speed;
-    mine->data.speed = motor_get_actual_velocity(mine->port)*(float)direction;
-    mine->data.curr = (double)motor_get_current_draw(mine->port)/1000.0;
-    mine->data.volt = (double)motor_get_voltage(mine->port)/1000.0;
-    mine->data.temp = motor_get_temperature(mine->port);
-    mine->data.power = motor_get_power(mine->port);
-
-    /* Calculated parameters */
-    mine->data.accel = (mine->data.speed - speed_last) / dt;
-    double filt_const = 0.1;
-    mine->data.accel_filt = filt_const * mine->data.accel + (1.0-filt_const) * mine->data.accel_filt;
-
-
-    /* Spinup detector */
-    if(!powered)
+/* Read one motor's feedback, once per tick before the groups run */
+void motor_sample(uint8_t idx)
+{
+    if(motors[idx].port < 0)
     {
-        /* Arm spinup if we are not powered and below 5 RPM */
-        if(fabs(mine->data.speed) <= 5.0)
-        {
-            if(!mine->data.spinup.armed)
-            {
-                LOG_DEBUG("MOTOR %c Arming Spinup Detector",mine->idx+'A');
-                REPORT("MTR %c: Arming Spinup Detector",mine->idx+'A');
-                mine->data.spinup.armed = true;
-                /* Reset accum data */
-                mine->data.spinup.speed_max = 0.0;
-                mine->data.spinup.energy = 0.0;
-                mine->data.spinup.time = 0.0;
-            }
-            else if(mine->data.spinup.speed_max > 0.0)
-            {
-                /* Spinup detector was armed, and never finished */
-                LOG_DEBUG("MOTOR %c Rearming Spinup Detector, Spinup Never Completed",mine->idx+'A');
-                REPORT("MTR %c: Rearming, Spinup Never Completed",mine->idx+'A');
-                mine->data.spinup.armed = true;
-                /* Reset accum data */
-                mine->data.spinup.speed_max = 0.0;
-                mine->data.spinup.energy = 0.0;
-                mine->data.spinup.time = 0.0;
-            }
-        }
+        /* Break out, invalid motor */
+        return;
     }
-    /* If we are powered and armed, run the spinup detector */
-    else if(mine->data.spinup.armed && powered)
-    {
-        /* Accumulate energy and time */
-        mine->data.spinup.energy += dt*mine->data.power;
-        mine->data.spinup.time += dt;
 
-        /* If we reached 66%, 95%, 99%, report */
+    /* Get a pointer to our motor to make it easier */
+    motor_t * mine = &motors[idx];
+    int direction = mine->reversed ? -1 : 1;
 
-        
-        if((mine->data.speed >= ((double)mine->target*0.66)) &&             /* We have crossed 66% */
-           (mine->data.spinup.speed_max < ((double)mine->target*0.66)))     /* Last speed was below 66% */
-        {
-            /* Report 66% trip */
-            LOG_ALWAYS("MOTOR %c: SPINUP Reached 66%% in %f sec (%f J)",(mine->idx+'A'),mine->data.spinup.time,mine->data.spinup.energy);
-            REPORT("MTR %c: SPINUP 66%% in %1.2f sec (%1.3f J)",(mine->idx+'A'),mine->data.spinup.time,mine->data.spinup.energy);
-        }
-        if((mine->data.speed >= ((double)mine->target*0.95)) &&        /* We have crossed 95% */
-           (mine->data.spinup.speed_max < ((double)mine->target*0.95)))     /* Last speed was below 95% */
-        {
-            /* Report 95% trip */
-            LOG_ALWAYS("MOTOR %c: SPINUP Reached 95%% in %f sec (%f J)",(mine->idx+'A'),mine->data.spinup.time,mine->data.spinup.energy);
-            REPORT("MTR %c: SPINUP 95%% in %1.2f sec (%1.3f J)",(mine->idx+'A'),mine->data.spinup.time,mine->data.spinup.energy);
-        }
-        if((mine->data.speed >= ((double)mine->target*0.99)) &&        /* We have crossed 99% */
-           (mine->data.spinup.speed_max < ((double)mine->target*0.99)))     /* Last speed was below 99% */
-        {
-            /* Report 95% trip */
-            LOG_ALWAYS("MOTOR %c: SPINUP Reached 99%% in %f sec (%f J)",(mine->idx+'A'),mine->data.spinup.time,mine->data.spinup.energy);
-            REPORT("MTR %c: SPINUP 99%% in %1.2f sec (%1.3f J)",(mine->idx+'A'),mine->data.spinup.time,mine->data.spinup.energy);
-            /* De-arm spinup detect, must spindown to re-run test */
-            mine->data.spinup.armed = false;
-            LOG_DEBUG("MTR %c: Disarming spinup detector",mine->idx+'A');
-        }
-        /* Store max speed for spinup detector only if new speed is higher than last speed */
-        if(mine->data.spinup.speed_max < mine->data.speed)
-        {
-            mine->data.spinup.speed_max = mine->data.speed;
-        }
-    }
+    /* Power and target come from the leader */
+    motor_t * lead = (mine->leader >= 0) ? &motors[mine->leader] : mine;
 
-    /* Shot detector */
-    if(!powered)
-    {
-        /* Disarm for sure */
-        mine->data.shot.armed = false;
-    }
-    else if(!mine->data.shot.armed)
-    {
-        /* Check if we should arm it */
-        if(mine->data.speed >= (double)mine->target*0.95)
-        {
-            LOG_DEBUG("MOTOR %c Arming Shot Detector",mine->idx+'A');
-            REPORT("MTR %c: Arming Shot Detector",mine->idx+'A');
-            mine->data.shot.armed = true;
-            mine->data.shot.energy = 0.0;
-            mine->data.shot.inprog = false;
-            mine->data.shot.min_speed = mine->target;
-            mine->data.shot.time = 0.0;
-        }
-    }
-    /* Check if we are not inprog and if we should be */
-    else if(!mine->data.shot.inprog)
+    /* Read data parameters, a motor that does not answer reads PROS_ERR_F */
+    double speed = motor_get_actual_velocity(mine->port);
+    if(PROS_ERR_F == speed)
     {
-        /* If we get an accel < -2000, we become inprog */
-        if(mine->data.accel < -2000.0)
-        {
-            LOG_DEBUG("MOTOR %c Shot Detected",mine->idx+'A');
-            REPORT("MTR %c: Shot Detected",mine->idx+'A');
-            mine->data.shot.inprog = true;
-        }
-    }
-    /* Otherwise we are both armed and inprog */
-    else
-    {
-        /* Accumulate time and energy */
-        mine->data.shot.energy += mine->data.power*dt;
-        mine->data.shot.time += dt;
-
-        /* Check min speed we reached */
-        if(mine->data.speed < mine->data.shot.min_speed)
-        {
-            mine->data.shot.min_speed = mine->data.speed;
-        }
-
-        /* If we reach 98% of target, report */
-        if(mine->data.speed >= (double)mine->target*0.95)
-        {
-            LOG_DEBUG("MOTOR %c Shot Returned, took %f sec (%f J), Min speed of %f (%f %%)",
-                      mine->idx+'A',
-                      mine->data.shot.time,
-                      mine->data.shot.energy,
-                      mine->data.shot.min_speed,
-                      mine->data.shot.min_speed / (double)mine->target * 100.0);
-            REPORT("MTR %c: Shot Complete, Took %1.2f sec (%1.3f J)",
-                      mine->idx+'A',
-                      mine->data.shot.time,
-                      mine->data.shot.energy);
-            REPORT("MTR %c: Shot min speed was %3.0f (%3.0f %%)",
-                      mine->idx+'A',
-                      mine->data.shot.min_speed,
-                      mine->data.shot.min_speed / (double)mine->target * 100.0);
-            /* End inprog and arm */
-            mine->data.shot.armed = false;
-            mine->data.shot.inprog = false;
-        }
+        motor_missed(idx);
+        return;
     }
-
-    /* Running energy usage */
-    if(!powered)
+    if(mine->data.missed > 0.0)
     {
-        mine->data.run.time = 0.0;
-        mine->data.run.energy = 0.0;
+        motor_found(idx);
     }
-    else
-    {
-        /* Accum energy and time */
-        mine->data.run.energy += mine->data.power*dt;
-        mine->data.run.time += dt;
+    mine->data.speed = speed*(float)direction;
+    mine->data.curr = (double)motor_get_current_draw(mine->port)/1000.0;
+    mine->data.volt = (double)motor_get_voltage(mine->port)/1000.0;
+    mine->data.temp = motor_get_temperature(mine->port);
+    mine->data.power = motor_get_power(mine->port);
+    thermal_sample(idx);
 
-        /* At 5sec, print the data */
-        if(mine->data.run.time > 5.0)
-        {
-            LOG_ALWAYS("MOTOR %c Runtime Power %f W avg",(mine->idx+'A'),mine->data.run.energy/mine->data.run.time);
-            REPORT("MTR %c: Runtime Power %2.2f W avg",(mine->idx+'A'),mine->data.run.energy/mine->data.run.time);
-            mine->data.run.time = 0.0;
-            mine->data.run.energy = 0.0;
-        }
-    }
-}
\ No newline at end of file
+    /* Stream the raw sample */
+    telem_sample(idx,lead->powered,lead->target);
+}
@@ -0,0 +1,190 @@
+/* Messages between the control task and the graphics task */
+#include "main.h"
+
+/* Include pros api */
+#include "pros/apix.h"
+
+/* Use pal log */
+#define LOG_LEVEL_FILE LOG_LEVEL_WARN
+#include "pal/log.h"
+
+#include "msg.h"
+
+static queue_t msg_ctrl_queue = NULL;
+static queue_t msg_ui_queue = NULL;
+
+/* Dropped message counts, reported by the graphics side */
+static uint32_t msg_ctrl_dropped = 0;
+static uint32_t msg_ui_dropped = 0;
+
+bool msg_ctrl_post(msg_ctrl_type_t type, uint8_t motor, int16_t arg)
+{
+    msg_ctrl_t m = { .type = type, .motor = motor, .arg = arg };
+    if(!msg_ctrl_queue || !queue_append(msg_ctrl_queue,&m,0))
+    {
+        msg_ctrl_dropped++;
+        return false;
+    }
+    return true;
+}
+
+bool msg_ui_post(msg_ui_type_t type, uint8_t motor, int16_t target, int16_t speed)
+{
+    msg_ui_t m = { .type = type, .motor = motor, .target = target, .speed = speed };
+    if(!msg_ui_queue || !queue_append(msg_ui_queue,&m,0))
+    {
+        msg_ui_dropped++;
+        return false;
+    }
+    return true;
+}
+
+/* Control side, configuration changes happen here between ticks */
+void msg_ctrl_apply()
+{
+    msg_ctrl_t m;
+    bool changed = false;
+    while(msg_ctrl_queue && queue_recv(msg_ctrl_queue,&m,0))
+    {
+        if(m.type == MSG_CTRL_TELEM)
+        {
+            telem_set_binary(!telem_get_binary());
+            continue;
+        }
+        if(m.motor >= NUM_MOTORS || (motors[m.motor].port < 0 && m.type != MSG_CTRL_ATTACH))
+        {
+            LOG_WARN("MSG: Control message %d for unconfigured motor %d",m.type,m.motor);
+            continue;
+        }
+
+        /* Followers take power and speed from their leader */
+        if(motors[m.motor].leader >= 0 && (m.type == MSG_CTRL_POWER || m.type == MSG_CTRL_SPEED || m.type == MSG_CTRL_TEST ||
+                                          m.type == MSG_CTRL_SCRIPT))
+        {
+            LOG_WARN("MSG: Attempted to change property %d of motor %c, but it's a follower",m.type,('A'+m.motor));
+            changed = true;
+            continue;
+        }
+
+        switch(m.type)
+        {
+        case MSG_CTRL_POWER:
+            motor_toggle_power(m.motor);
+            break;
+        case MSG_CTRL_SPEED:
+            motor_inc(m.motor,m.arg);
+            break;
+        case MSG_CTRL_LEAD:
+            motor_toggle_lead(m.motor);
+            break;
+        case MSG_CTRL_REVERSE:
+            motor_toggle_reverse(m.motor);
+            break;
+        case MSG_CTRL_GEAR:
+            motor_next_gearset(m.motor);
+            break;
+        case MSG_CTRL_TEST:
+            motor_start_test(m.motor);
+            break;
+        case MSG_CTRL_SCRIPT:
+            script_toggle(m.motor);
+            break;
+        case MSG_CTRL_ATTACH:
+            motor_attach(m.motor,m.arg);
+            msg_ui_post(MSG_UI_MOTOR,m.motor,0,0);
+            break;
+        case MSG_CTRL_PORT:
+            motor_next_port(m.motor);
+            msg_ui_post(MSG_UI_MOTOR,m.motor,0,0);
+            break;
+        default:
+            LOG_ERROR("MSG: Invalid control message %d",m.type);
+            break;
+        }
+        changed = true;
+    }
+
+    /* A change can touch several motors (followers), so redraw all of them */
+    if(changed)
+    {
+        for(int i = 0; i < NUM_MOTORS; i++)
+        {
+            msg_ui_post(MSG_UI_CONFIG,i,0,0);
+        }
+        msg_ui_post(MSG_UI_RUN,0,0,0);
+    }
+}
+
+/* Graphics side, runs as an lv_task so LVGL objects are only touched by the graphics task */
+static void msg_ui_apply(void * param)
+{
+    /* Speeds are coalesced, only the newest per motor is drawn each period */
+    static msg_ui_t speeds[NUM_MOTORS];
+    bool speed_pending[NUM_MOTORS] = {0};
+    PROF_BEGIN(PROF_UI_APPLY);
+
+    msg_ui_t m;
+    while(queue_recv(msg_ui_queue,&m,0))
+    {
+        if(m.motor >= NUM_MOTORS)
+        {
+            continue;
+        }
+        switch(m.type)
+        {
+        case MSG_UI_SPEED:
+            if(speed_pending[m.motor])
+            {
+                view_stats.coalesced++;
+            }
+            speeds[m.motor] = m;
+            speed_pending[m.motor] = true;
+            break;
+        case MSG_UI_RUN:
+            for(int i = 0; i < NUM_MOTORS; i++)
+            {
+                run_update_run(i);
+            }
+            break;
+        case MSG_UI_CONFIG:
+            config_update(m.motor);
+            break;
+        case MSG_UI_MOTOR:
+            config_redraw(m.motor);
+            run_redraw(m.motor);
+            break;
+        default:
+            LOG_ERROR("MSG: Invalid UI message %d",m.type);
+            break;
+        }
+    }
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        if(speed_pending[i])
+        {
+            run_update_speeds(i,speeds[i].target,speeds[i].speed);
+        }
+    }
+    PROF_END(PROF_UI_APPLY);
+
+    static uint32_t dropped_last = 0;
+    uint32_t dropped = msg_ctrl_dropped + msg_ui_dropped;
+    if(dropped != dropped_last)
+    {
+        LOG_WARN("MSG: %d messages dropped (queue full)",(int)(dropped - dropped_last));
+        dropped_last = dropped;
+    }
+}
+
+void msg_init()
+{
+    msg_ctrl_queue = queue_create(MSG_CTRL_QUEUE_LEN,sizeof(msg_ctrl_t));
+    msg_ui_queue = queue_create(MSG_UI_QUEUE_LEN,sizeof(msg_ui_t));
+    if(!msg_ctrl_queue || !msg_ui_queue)
+    {
+        LOG_ERROR("MSG: Unable to create queues");
+        return;
+    }
+    lv_task_create(msg_ui_apply,MSG_UI_PERIOD,LV_TASK_PRIO_MID,NULL);
+    view_init();
+}
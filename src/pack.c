@@ -0,0 +1,192 @@
+/* Delta/varint compression of telemetry sample records */
+#include "pack.h"
+
+/* Zig-zag maps small signed values to small unsigned ones (0,-1,1,-2 -> 0,1,2,3) */
+static inline uint32_t pack_zz(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+static inline int32_t pack_unzz(uint32_t v)
+{
+    return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+/* LEB128 varint, 7 bits per byte */
+static inline uint8_t * pack_put_var(uint8_t * p, uint32_t v)
+{
+    while(v >= 0x80)
+    {
+        *p++ = (uint8_t)v | 0x80;
+        v >>= 7;
+    }
+    *p++ = (uint8_t)v;
+    return p;
+}
+static inline const uint8_t * pack_get_var(const uint8_t * p, const uint8_t * end, uint32_t * v)
+{
+    uint32_t out = 0;
+    for(int shift = 0; shift < 35 && p < end; shift += 7)
+    {
+        uint8_t b = *p++;
+        out |= (uint32_t)(b & 0x7F) << shift;
+        if(!(b & 0x80))
+        {
+            *v = out;
+            return p;
+        }
+    }
+    return NULL;
+}
+
+void pack_reset(pack_ctx_t * ctx)
+{
+    ctx->valid = false;
+    ctx->mask = 0;
+    ctx->time = 0;
+    ctx->period = 0;
+}
+
+size_t pack_tick(pack_ctx_t * ctx, uint8_t * out, uint32_t time, const telem_rec_t * recs, uint8_t count, bool key)
+{
+    if(!ctx->valid)
+    {
+        key = true;
+    }
+
+    /* Tick byte, filled in once we know which motors we kept */
+    uint8_t * p = out + 1;
+    uint8_t mask = 0;
+
+    if(key)
+    {
+        p = pack_put_var(p,time);
+        ctx->period = 0;
+    }
+    else
+    {
+        int32_t period = (int32_t)(time - ctx->time);
+        p = pack_put_var(p,pack_zz(period - ctx->period));
+        ctx->period = period;
+    }
+    ctx->time = time;
+
+    for(uint8_t r = 0; r < count; r++)
+    {
+        const telem_rec_t * rec = &recs[r];
+        if(rec->idx >= PACK_MAX_MOTORS || (mask >> rec->idx))
+        {
+            /* Out of range or out of order, cannot be represented */
+            continue;
+        }
+        mask |= 1 << rec->idx;
+
+        /* Absolute if the decoder may have no history for this motor */
+        bool abs = key || !(ctx->mask & (1 << rec->idx));
+        uint8_t * hdr = p++;
+        uint8_t h = 0;
+        if(abs || rec->flags != ctx->motor[rec->idx].flags)
+        {
+            h |= PACK_REC_FLAGS;
+            *p++ = rec->flags;
+            ctx->motor[rec->idx].flags = rec->flags;
+        }
+        for(int i = 0; i < TELEM_CH_COUNT; i++)
+        {
+            int32_t v = rec->ch[i];
+            int32_t d = abs ? v : v - ctx->motor[rec->idx].ch[i];
+            if(abs || d)
+            {
+                h |= 1 << i;
+                p = pack_put_var(p,pack_zz(d));
+            }
+            ctx->motor[rec->idx].ch[i] = v;
+        }
+        *hdr = h;
+    }
+
+    out[0] = mask | (key ? PACK_TICK_KEY : 0);
+    ctx->mask = mask;
+    ctx->valid = true;
+    return p - out;
+}
+
+int pack_untick(pack_ctx_t * ctx, const uint8_t * in, size_t len, uint32_t * time, telem_rec_t * recs, uint8_t * count)
+{
+    const uint8_t * p = in;
+    const uint8_t * end = in + len;
+    if(p >= end)
+    {
+        return -1;
+    }
+
+    uint8_t tick = *p++;
+    bool key = tick & PACK_TICK_KEY;
+    if(!key && !ctx->valid)
+    {
+        return -1;
+    }
+
+    uint32_t v;
+    if(!(p = pack_get_var(p,end,&v)))
+    {
+        return -1;
+    }
+    if(key)
+    {
+        ctx->time = v;
+        ctx->period = 0;
+    }
+    else
+    {
+        ctx->period += pack_unzz(v);
+        ctx->time += ctx->period;
+    }
+    *time = ctx->time;
+
+    uint8_t n = 0;
+    for(uint8_t idx = 0; idx < PACK_MAX_MOTORS; idx++)
+    {
+        if(!(tick & (1 << idx)))
+        {
+            continue;
+        }
+        if(p >= end)
+        {
+            return -1;
+        }
+        uint8_t h = *p++;
+        bool abs = key || !(ctx->mask & (1 << idx));
+        if(abs && ((h & PACK_REC_MASK) != PACK_REC_MASK || !(h & PACK_REC_FLAGS)))
+        {
+            return -1;
+        }
+        if(h & PACK_REC_FLAGS)
+        {
+            if(p >= end)
+            {
+                return -1;
+            }
+            ctx->motor[idx].flags = *p++;
+        }
+        for(int i = 0; i < TELEM_CH_COUNT; i++)
+        {
+            if(h & (1 << i))
+            {
+                if(!(p = pack_get_var(p,end,&v)))
+                {
+                    return -1;
+                }
+                ctx->motor[idx].ch[i] = (abs ? 0 : ctx->motor[idx].ch[i]) + pack_unzz(v);
+            }
+            recs[n].ch[i] = ctx->motor[idx].ch[i];
+        }
+        recs[n].idx = idx;
+        recs[n].flags = ctx->motor[idx].flags;
+        n++;
+    }
+
+    ctx->mask = tick & PACK_TICK_MASK;
+    ctx->valid = true;
+    *count = n;
+    return p - in;
+}
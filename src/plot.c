@@ -0,0 +1,316 @@
+/* This code runs the strip chart on the LOG page */
+#include "main.h"
+
+/* Include pros api */
+#include "pros/apix.h"
+
+/* Use pal log */
+#define LOG_LEVEL_FILE LOG_LEVEL_WARN
+#include "pal/log.h"
+
+#include <string.h>
+
+/* One bucket, values in the order they happened (POINT_DEF if no data) */
+typedef struct
+{
+    int16_t first;
+    int16_t second;
+} plot_bucket_t;
+
+/* Bucket being filled */
+typedef struct
+{
+    bool valid;
+    bool min_first;
+    int16_t min;
+    int16_t max;
+} plot_acc_t;
+
+/* Reduction state for one span */
+typedef struct
+{
+    /* Bucket length (ms) */
+    uint32_t bucket_ms;
+    /* Start time of the bucket being filled */
+    uint32_t start;
+    /* Next ring slot and number of filled slots */
+    uint16_t head;
+    uint16_t count;
+    plot_acc_t acc[NUM_MOTORS][PLOT_CH_COUNT];
+    plot_bucket_t ring[PLOT_BUCKETS][NUM_MOTORS][PLOT_CH_COUNT];
+} plot_reduce_t;
+
+static plot_reduce_t plot_spans[PLOT_SPAN_COUNT] =
+{
+    [PLOT_SPAN_5S] = { .bucket_ms = 5000 / PLOT_BUCKETS },
+    [PLOT_SPAN_30S] = { .bucket_ms = 30000 / PLOT_BUCKETS },
+    [PLOT_SPAN_2M] = { .bucket_ms = 120000 / PLOT_BUCKETS },
+};
+
+/* Incremented whenever a bucket is committed, so the chart only redraws on new data */
+static volatile uint32_t plot_seq = 0;
+
+/* Button maps and what they select */
+static const char * plot_ch_map[] = {"Speed","Current","Power",""};
+static const char * plot_span_map[] = {"5 s","30 s","2 min",""};
+static const char * plot_ch_unit[PLOT_CH_COUNT] = {"rpm","A","W"};
+/* Autoscale step and display divisor per quantity */
+static const int16_t plot_ch_step[PLOT_CH_COUNT] = {100,500,100};
+static const int16_t plot_ch_div[PLOT_CH_COUNT] = {1,1000,10};
+
+/* Motor colors, also used for the legend */
+static const lv_color_t plot_colors[NUM_MOTORS] = {LV_COLOR_RED, LV_COLOR_BLUE, LV_COLOR_YELLOW, LV_COLOR_LIME};
+
+/* Graphics objects and selection (graphics task only) */
+static lv_obj_t * plot_page = NULL;
+static lv_obj_t * plot_chart = NULL;
+static lv_obj_t * plot_scale = NULL;
+static lv_chart_series_t * plot_series[NUM_MOTORS];
+static plot_ch_t plot_ch = PLOT_CH_SPEED;
+static plot_span_t plot_span = PLOT_SPAN_5S;
+static uint32_t plot_seq_drawn = 0;
+static bool plot_dirty = true;
+
+/* Add one value to a bucket */
+static inline void plot_acc_add(plot_acc_t * acc, int16_t v)
+{
+    if(!acc->valid)
+    {
+        acc->valid = true;
+        acc->min_first = true;
+        acc->min = v;
+        acc->max = v;
+    }
+    else if(v < acc->min)
+    {
+        acc->min = v;
+        acc->min_first = false;
+    }
+    else if(v > acc->max)
+    {
+        acc->max = v;
+        acc->min_first = true;
+    }
+}
+
+/* Close a bucket into the ring slot */
+static inline void plot_acc_commit(plot_acc_t * acc, plot_bucket_t * out)
+{
+    if(!acc->valid)
+    {
+        out->first = LV_CHART_POINT_DEF;
+        out->second = LV_CHART_POINT_DEF;
+        return;
+    }
+    out->first = acc->min_first ? acc->min : acc->max;
+    out->second = acc->min_first ? acc->max : acc->min;
+    acc->valid = false;
+}
+
+static inline int16_t plot_clamp(double v)
+{
+    if(v > INT16_MAX) return INT16_MAX;
+    if(v < 0) return 0;
+    return (int16_t)v;
+}
+
+/* Runs in the control task, only a few compares per motor so sampling is never delayed */
+void plot_tick()
+{
+    uint32_t now = millis();
+    int16_t vals[NUM_MOTORS][PLOT_CH_COUNT];
+    for(int m = 0; m < NUM_MOTORS; m++)
+    {
+        vals[m][PLOT_CH_SPEED] = plot_clamp(fabs(motors[m].data.speed));
+        vals[m][PLOT_CH_CURR] = plot_clamp(motors[m].data.curr * 1000.0);
+        vals[m][PLOT_CH_POWER] = plot_clamp(motors[m].data.power * 10.0);
+    }
+
+    for(int s = 0; s < PLOT_SPAN_COUNT; s++)
+    {
+        plot_reduce_t * span = &plot_spans[s];
+        for(int m = 0; m < NUM_MOTORS; m++)
+        {
+            /* Invalid samples leave a gap */
+            if(motors[m].port < 0 || !motors[m].data.valid)
+            {
+                continue;
+            }
+            for(int c = 0; c < PLOT_CH_COUNT; c++)
+            {
+                plot_acc_add(&span->acc[m][c],vals[m][c]);
+            }
+        }
+
+        if(now - span->start < span->bucket_ms)
+        {
+            continue;
+        }
+        /* Commit, the chart reads committed slots only */
+        for(int m = 0; m < NUM_MOTORS; m++)
+        {
+            for(int c = 0; c < PLOT_CH_COUNT; c++)
+            {
+                plot_acc_commit(&span->acc[m][c],&span->ring[span->head][m][c]);
+            }
+        }
+        span->head = (span->head + 1) % PLOT_BUCKETS;
+        if(span->count < PLOT_BUCKETS) span->count++;
+        /* Stay on the bucket grid unless we fell behind by more than a bucket */
+        span->start += span->bucket_ms;
+        if(now - span->start >= span->bucket_ms) span->start = now;
+        plot_seq++;
+    }
+}
+
+/* Redraw the chart from the selected span, runs in the graphics task */
+static void plot_refresh(void * param)
+{
+    if(!plot_chart || lv_obj_get_hidden(plot_page))
+    {
+        return;
+    }
+    uint32_t seq = plot_seq;
+    if(seq == plot_seq_drawn && !plot_dirty)
+    {
+        return;
+    }
+    plot_seq_drawn = seq;
+    plot_dirty = false;
+
+    /* Oldest bucket first, the empty part of the span on the left */
+    const plot_reduce_t * span = &plot_spans[plot_span];
+    uint16_t head = span->head;
+    uint16_t count = span->count;
+    static lv_coord_t pts[NUM_MOTORS][PLOT_POINTS];
+    int16_t top = 0;
+    for(int m = 0; m < NUM_MOTORS; m++)
+    {
+        int p = 0;
+        for(int b = count; b < PLOT_BUCKETS; b++)
+        {
+            pts[m][p++] = LV_CHART_POINT_DEF;
+            pts[m][p++] = LV_CHART_POINT_DEF;
+        }
+        for(int b = 0; b < count; b++)
+        {
+            const plot_bucket_t * bk = &span->ring[(head + PLOT_BUCKETS - count + b) % PLOT_BUCKETS][m][plot_ch];
+            pts[m][p++] = bk->first;
+            pts[m][p++] = bk->second;
+            if(bk->first > top) top = bk->first;
+            if(bk->second > top) top = bk->second;
+        }
+    }
+
+    /* Autoscale to the next step above the largest value */
+    int16_t step = plot_ch_step[plot_ch];
+    top = (top / step + 1) * step;
+    lv_chart_set_range(plot_chart,0,top);
+    for(int m = 0; m < NUM_MOTORS; m++)
+    {
+        lv_chart_set_points(plot_chart,plot_series[m],pts[m]);
+    }
+
+    char text[24];
+    int div = plot_ch_div[plot_ch];
+    if(div > 1)
+    {
+        snprintf(text,sizeof(text),"%d.%d %s",top / div,(top % div) * 10 / div,plot_ch_unit[plot_ch]);
+    }
+    else
+    {
+        snprintf(text,sizeof(text),"%d %s",top,plot_ch_unit[plot_ch]);
+    }
+    lv_label_set_text(plot_scale,text);
+}
+
+/* Quantity button callback */
+static lv_res_t plot_ch_cb(lv_obj_t * btnm, const char * txt)
+{
+    for(int i = 0; i < PLOT_CH_COUNT; i++)
+    {
+        if(!strcmp(txt,plot_ch_map[i]))
+        {
+            LOG_DEBUG("PLOT: Showing %s",txt);
+            plot_ch = i;
+            plot_dirty = true;
+        }
+    }
+    return LV_RES_OK;
+}
+
+/* Span button callback */
+static lv_res_t plot_span_cb(lv_obj_t * btnm, const char * txt)
+{
+    for(int i = 0; i < PLOT_SPAN_COUNT; i++)
+    {
+        if(!strcmp(txt,plot_span_map[i]))
+        {
+            LOG_DEBUG("PLOT: Span %s",txt);
+            plot_span = i;
+            plot_dirty = true;
+        }
+    }
+    return LV_RES_OK;
+}
+
+/* Create a selector button matrix */
+static lv_obj_t * plot_btnm(lv_obj_t * page, const char ** map, lv_btnm_action_t cb, lv_coord_t x)
+{
+    lv_obj_t * btnm = lv_btnm_create(page,NULL);
+    lv_btnm_set_map(btnm,map);
+    lv_btnm_set_action(btnm,cb);
+    lv_btnm_set_toggle(btnm,true,0);
+    lv_btnm_set_style(btnm,LV_BTNM_STYLE_BG,&style_page);
+    lv_btnm_set_style(btnm,LV_BTNM_STYLE_BTN_REL,&style_blu_ina);
+    lv_btnm_set_style(btnm,LV_BTNM_STYLE_BTN_PR,&style_blu_act);
+    lv_btnm_set_style(btnm,LV_BTNM_STYLE_BTN_TGL_REL,&style_blu_act);
+    lv_btnm_set_style(btnm,LV_BTNM_STYLE_BTN_TGL_PR,&style_blu_act);
+    /* Under the chart, ending inside the 240 px page so nothing needs scrolling */
+    lv_obj_set_size(btnm,202,34);
+    lv_obj_align(btnm,0,LV_ALIGN_IN_TOP_LEFT,x,202);
+    return btnm;
+}
+
+/* Function to initialize the log page */
+void plot_draw(lv_obj_t * page)
+{
+    LOG_DEBUG("PLOT: Draw");
+    plot_page = page;
+
+    /* Title, scale and legend */
+    lv_obj_t * label;
+    label = lv_label_create(page,NULL);
+    lv_label_set_text(label,"LOG");
+    lv_obj_align(label,0,LV_ALIGN_IN_TOP_MID,0,0);
+
+    plot_scale = lv_label_create(page,NULL);
+    lv_label_set_text(plot_scale,"");
+    lv_obj_align(plot_scale,0,LV_ALIGN_IN_TOP_LEFT,4,0);
+
+    label = lv_label_create(page,NULL);
+    lv_label_set_recolor(label,true);
+    lv_label_set_text(label,"#ff0000 A# #0000ff B# #ffff00 C# #00ff00 D#");
+    lv_obj_align(label,0,LV_ALIGN_IN_TOP_RIGHT,-4,0);
+
+    /* Chart, one series per motor */
+    plot_chart = lv_chart_create(page,NULL);
+    lv_obj_set_size(plot_chart,408,174);
+    lv_obj_align(plot_chart,0,LV_ALIGN_IN_TOP_LEFT,4,24);
+    lv_chart_set_type(plot_chart,LV_CHART_TYPE_LINE);
+    lv_chart_set_series_width(plot_chart,1);
+    lv_chart_set_div_line_count(plot_chart,3,5);
+    lv_chart_set_point_count(plot_chart,PLOT_POINTS);
+    for(int m = 0; m < NUM_MOTORS; m++)
+    {
+        plot_series[m] = lv_chart_add_series(plot_chart,plot_colors[m]);
+        lv_chart_init_points(plot_chart,plot_series[m],LV_CHART_POINT_DEF);
+    }
+
+    /* Selectors */
+    plot_btnm(page,plot_ch_map,plot_ch_cb,4);
+    plot_btnm(page,plot_span_map,plot_span_cb,210);
+
+    /* Redraw from the graphics task, at most every PLOT_PERIOD and only while visible */
+    lv_task_create(plot_refresh,PLOT_PERIOD,LV_TASK_PRIO_LOW,NULL);
+}
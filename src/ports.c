@@ -0,0 +1,242 @@
+/* Smart port discovery */
+#include "main.h"
+
+/* Include pros api */
+#include "pros/apix.h"
+
+/* Use pal log */
+#define LOG_LEVEL_FILE LOG_LEVEL_INFO
+#include "pal/log.h"
+
+#include "ports.h"
+
+/* Port of each motor slot as the rescan task knows it (-1 if free)
+ * Attaches are posted to the control task, which owns motors[]
+ */
+static int8_t ports_assigned[NUM_MOTORS];
+/* Motor ports in the last scan, bit n is port n+1 */
+static uint32_t ports_last = 0;
+/* Assignment changes are made by the rescan task and the control task */
+static mutex_t ports_lock = NULL;
+/* Assignment changed by the control task, saved by the rescan task */
+static volatile bool ports_dirty = false;
+
+
+/* One pass over the registry, returns the motor ports, only plugged ports are logged */
+static uint32_t ports_scan()
+{
+    uint32_t found = 0;
+    for(int i = 0; i < PORTS_COUNT; i++)
+    {
+        v5_device_e_t type = registry_get_plugged_type(i);
+        if(E_DEVICE_NONE == type)
+        {
+            continue;
+        }
+        LOG_DEBUG("PORTS: Port %02d has device class %03d",(i+1),type);
+        if(E_DEVICE_MOTOR == type)
+        {
+            found |= (1 << i);
+        }
+    }
+    return found;
+}
+
+/* Read the cached assignment, keeping the entries that are still motors */
+static void ports_load(uint32_t found)
+{
+    FILE * f = fopen(PORTS_FILE,"r");
+    if(!f)
+    {
+        LOG_INFO("PORTS: No port cache, assigning in port order");
+        return;
+    }
+
+    char letter;
+    int port;
+    while(fscanf(f," %c %d",&letter,&port) == 2)
+    {
+        int idx = letter - 'A';
+        if(idx < 0 || idx >= NUM_MOTORS || port < 1 || port > PORTS_COUNT)
+        {
+            LOG_WARN("PORTS: Ignoring cache entry %c %d",letter,port);
+            continue;
+        }
+        /* Gone, or already taken by an earlier line */
+        if(!(found & (1 << (port-1))))
+        {
+            LOG_INFO("PORTS: Motor %c was on port %02d, no longer there",letter,port);
+            continue;
+        }
+        found &= ~(1 << (port-1));
+        ports_assigned[idx] = port;
+    }
+    fclose(f);
+}
+
+static void ports_save()
+{
+    if(!usd_is_installed())
+    {
+        return;
+    }
+    FILE * f = fopen(PORTS_FILE,"w");
+    if(!f)
+    {
+        LOG_ERROR("PORTS: Error writing %s",PORTS_FILE);
+        return;
+    }
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        if(ports_assigned[i] > 0)
+        {
+            fprintf(f,"%c %d\n",('A'+i),ports_assigned[i]);
+        }
+    }
+    fclose(f);
+}
+
+/* Give motor ports without a slot the free slots in order, returns the slots filled */
+static uint32_t ports_fill(uint32_t found)
+{
+    uint32_t filled = 0;
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        if(ports_assigned[i] > 0)
+        {
+            found &= ~(1 << (ports_assigned[i]-1));
+        }
+    }
+    for(int i = 0; i < NUM_MOTORS && found; i++)
+    {
+        if(ports_assigned[i] > 0)
+        {
+            continue;
+        }
+        int port = __builtin_ctz(found) + 1;
+        found &= ~(1 << (port-1));
+        ports_assigned[i] = port;
+        filled |= (1 << i);
+    }
+    if(found)
+    {
+        LOG_INFO("PORTS: No free motor slot for %d more motors",__builtin_popcount(found));
+    }
+    return filled;
+}
+
+/* Pick up motors plugged in while running */
+static void ports_task(void * param)
+{
+    uint32_t now = millis();
+    while(1)
+    {
+        task_delay_until(&now,PORTS_RESCAN_PERIOD);
+
+        uint32_t found = ports_scan();
+        uint32_t added = found & ~ports_last;
+        uint32_t removed = ports_last & ~found;
+        ports_last = found;
+
+        /* The control task notices a motor that stops answering, here it is only logged */
+        mutex_take(ports_lock,TIMEOUT_MAX);
+        for(int i = 0; i < NUM_MOTORS; i++)
+        {
+            int port = ports_assigned[i];
+            if(port > 0 && (removed & (1 << (port-1))))
+            {
+                LOG_WARN("PORTS: Port %02d (motor %c) unplugged",port,('A'+i));
+            }
+            else if(port > 0 && (added & (1 << (port-1))))
+            {
+                LOG_WARN("PORTS: Port %02d (motor %c) plugged back in",port,('A'+i));
+            }
+        }
+        uint32_t filled = added ? ports_fill(found) : 0;
+        /* Still locked, so ports_next_free never sees a slot that is rolled back */
+        for(int i = 0; i < NUM_MOTORS; i++)
+        {
+            if(filled & (1 << i))
+            {
+                LOG_ALWAYS("PORTS: Motor plugged into port %02d, attaching as motor %c",ports_assigned[i],('A'+i));
+                if(!msg_ctrl_post(MSG_CTRL_ATTACH,i,ports_assigned[i]))
+                {
+                    /* Queue full, treat the port as new again on the next scan */
+                    ports_last &= ~(1 << (ports_assigned[i]-1));
+                    ports_assigned[i] = -1;
+                    filled &= ~(1 << i);
+                }
+            }
+        }
+        mutex_give(ports_lock);
+        if(filled || ports_dirty)
+        {
+            ports_dirty = false;
+            ports_save();
+        }
+    }
+}
+
+int8_t ports_next_free(uint8_t idx)
+{
+    int8_t port = -1;
+    uint32_t found = ports_scan();
+
+    mutex_take(ports_lock,TIMEOUT_MAX);
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        if(ports_assigned[i] > 0)
+        {
+            found &= ~(1 << (ports_assigned[i]-1));
+        }
+    }
+    /* Search upwards from the current port, wrapping around */
+    int from = (ports_assigned[idx] > 0) ? ports_assigned[idx] : 0;
+    for(int i = 0; i < PORTS_COUNT && found; i++)
+    {
+        int p = (from + i) % PORTS_COUNT;
+        if(found & (1 << p))
+        {
+            port = p + 1;
+            ports_assigned[idx] = port;
+            ports_dirty = true;
+            break;
+        }
+    }
+    mutex_give(ports_lock);
+    return port;
+}
+
+void ports_init(int8_t * ports)
+{
+    uint32_t start = micros();
+    ports_lock = mutex_create();
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        ports_assigned[i] = -1;
+    }
+
+    ports_last = ports_scan();
+    bool sd = usd_is_installed();
+    if(sd)
+    {
+        ports_load(ports_last);
+    }
+    bool changed = ports_fill(ports_last) != 0;
+    if(changed)
+    {
+        ports_save();
+    }
+
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        ports[i] = ports_assigned[i];
+    }
+    LOG_ALWAYS("PORTS: %d motors found in %d us%s",__builtin_popcount(ports_last),(int)(micros() - start),
+               !sd ? ", no SD card for the port cache" : (changed ? ", port cache updated" : ""));
+
+    if(!task_create(ports_task,NULL,TASK_PRIORITY_DEFAULT-2,TASK_STACK_DEPTH_DEFAULT,"ports"))
+    {
+        LOG_ERROR("PORTS: Unable to start rescan task");
+    }
+}
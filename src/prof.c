@@ -0,0 +1,165 @@
+/* Hot path span profiler */
+#include "main.h"
+
+/* Include pros api */
+#include "pros/apix.h"
+
+/* Use pal log */
+#define LOG_LEVEL_FILE LOG_LEVEL_INFO
+#include "pal/log.h"
+
+#include "prof.h"
+
+/* Histogram of one span over a window */
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint32_t sum;
+    uint16_t bucket[PROF_BUCKETS];
+} prof_hist_t;
+
+static const char * prof_names[PROF_COUNT] =
+{
+    "tick", "msg", "script", "sample", "group", "ui_post", "telem", "plot", "ui_apply", "refr", "dlog",
+};
+
+/* Two windows, spans write to prof_win while the window task reads and clears the other */
+static prof_hist_t prof_hist[2][PROF_COUNT];
+static uint8_t prof_win = 0;
+/* Last complete window */
+static prof_stats_t prof_last[PROF_COUNT];
+static uint32_t prof_last_ms = 0;
+
+
+/* Bucket of a time, 4 per octave above 4 us */
+static int prof_bucket(uint32_t us)
+{
+    if(us < 4)
+    {
+        return us;
+    }
+    int octave = 31 - __builtin_clz(us);
+    int b = (octave - 1) * 4 + ((us >> (octave - 2)) & 3);
+    return (b < PROF_BUCKETS) ? b : PROF_BUCKETS - 1;
+}
+
+/* Largest time in a bucket */
+static uint32_t prof_bucket_top(int b)
+{
+    if(b < 4)
+    {
+        return b;
+    }
+    b++;
+    return ((uint32_t)(4 + b % 4) << (b / 4 - 1)) - 1;
+}
+
+void prof_add(prof_span_t span, uint32_t us)
+{
+    /* A sample racing the window swap lands in the next window but one, which is harmless */
+    prof_hist_t * h = &prof_hist[__atomic_load_n(&prof_win,__ATOMIC_RELAXED)][span];
+    if(!h->count || us < h->min) h->min = us;
+    if(us > h->max) h->max = us;
+    h->count++;
+    h->sum += us;
+    uint16_t * n = &h->bucket[prof_bucket(us)];
+    if(*n < UINT16_MAX) (*n)++;
+}
+
+/* Upper edge of the bucket holding the q'th fraction of samples, within min and max */
+static uint32_t prof_percentile(const prof_hist_t * h, uint32_t num, uint32_t den)
+{
+    uint32_t want = (h->count * num + den - 1) / den;
+    uint32_t seen = 0;
+    for(int b = 0; b < PROF_BUCKETS; b++)
+    {
+        seen += h->bucket[b];
+        if(seen >= want)
+        {
+            uint32_t top = prof_bucket_top(b);
+            if(top > h->max) top = h->max;
+            if(top < h->min) top = h->min;
+            return top;
+        }
+    }
+    return h->max;
+}
+
+void prof_get(prof_span_t span, prof_stats_t * stats)
+{
+    *stats = prof_last[span];
+}
+
+uint32_t prof_window_ms()
+{
+    return prof_last_ms;
+}
+
+const char * prof_name(prof_span_t span)
+{
+    return (span < PROF_COUNT) ? prof_names[span] : "?";
+}
+
+void prof_format(char * out, size_t size)
+{
+    int o = snprintf(out,size,"SPAN (us, last %d s)  n  min  p50  p99  max  avg",(int)(prof_last_ms / 1000));
+    for(int i = 0; i < PROF_COUNT && o < (int)size; i++)
+    {
+        const prof_stats_t * s = &prof_last[i];
+        if(!s->count)
+        {
+            continue;
+        }
+        o += snprintf(&out[o],size - o,"\n%-8s %5d %4d %4d %4d %5d %4d",prof_names[i],(int)s->count,
+                      (int)s->min,(int)s->p50,(int)s->p99,(int)s->max,(int)s->avg);
+    }
+#if !PROF_ENABLE
+    snprintf(&out[o],size - o,"\nSpans removed from this build (PROF_ENABLE=0)");
+#endif
+}
+
+void prof_dump()
+{
+    for(int i = 0; i < PROF_COUNT; i++)
+    {
+        const prof_stats_t * s = &prof_last[i];
+        if(!s->count)
+        {
+            continue;
+        }
+        LOG_INFO("PROF: %s n %d, min %d p50 %d p99 %d max %d avg %d us",prof_names[i],(int)s->count,
+                 (int)s->min,(int)s->p50,(int)s->p99,(int)s->max,(int)s->avg);
+    }
+}
+
+/* Runs in the graphics task, closes a window every PROF_PERIOD */
+static void prof_task(void * param)
+{
+    static uint32_t start_ms = 0;
+    uint32_t ms = millis();
+    uint8_t old = prof_win;
+    __atomic_store_n(&prof_win,old ^ 1,__ATOMIC_RELAXED);
+
+    for(int i = 0; i < PROF_COUNT; i++)
+    {
+        prof_hist_t * h = &prof_hist[old][i];
+        prof_stats_t * s = &prof_last[i];
+        s->count = h->count;
+        s->min = h->min;
+        s->max = h->max;
+        s->avg = h->count ? h->sum / h->count : 0;
+        s->p50 = h->count ? prof_percentile(h,50,100) : 0;
+        s->p99 = h->count ? prof_percentile(h,99,100) : 0;
+        memset(h,0,sizeof(*h));
+    }
+    prof_last_ms = ms - start_ms;
+    start_ms = ms;
+    prof_dump();
+}
+
+void prof_init()
+{
+    lv_task_create(prof_task,PROF_PERIOD,LV_TASK_PRIO_LOWEST,NULL);
+}
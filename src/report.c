@@ -1,4 +1,4 @@
-/* This code runs the configuration screen */
+/* This code runs the report screen */
 #include "main.h"
 
 /* Include pros api */
@@ -8,89 +8,268 @@
 #define LOG_LEVEL_FILE LOG_LEVEL_WARN
 #include "pal/log.h"
 
-static bool report_has_init = false;
+#include <string.h>
 
-/* Report buffer sizing */
-#define REPORT_BUF_LINES 9
-/* Actual printable 44, allowing 48 bytes (including null) */
-#define REPORT_BUF_CHARS 44
+/* One report line */
+typedef struct
+{
+    /* Line number + 1 once written, 0 while being written */
+    uint32_t seq;
+    uint32_t time;
+    uint8_t motor;
+    uint8_t type;
+    char text[REPORT_LINE_CHARS];
+} report_line_t;
+
+/* Scrollback arena, a fixed ring of lines so appending never allocates or copies old lines */
+#define REPORT_MASK (REPORT_HISTORY - 1)
+static report_line_t report_lines[REPORT_HISTORY];
+/* Number of lines ever claimed */
+static uint32_t report_head = 0;
+
+/* Graphics objects (graphics task only) */
+static lv_obj_t * report_page = NULL;
+static lv_obj_t * report_title = NULL;
+static lv_obj_t * report_rows[REPORT_VIEW_LINES];
+/* Line number + 1 shown in each row, 0 if empty */
+static uint32_t report_shown[REPORT_VIEW_LINES];
+
+/* View state, end is the line number after the newest shown line, 0 to follow new lines */
+static uint32_t report_view_end = 0;
+static uint32_t report_view_first = 0;
+static int report_view_count = 0;
+static int report_filter_motor = -1;
+static int report_filter_type = -1;
+static uint32_t report_drawn_head = 0;
+static bool report_dirty = true;
+
+/* Button maps */
+static const char * report_motor_map[] = {"All","A","B","C","D",""};
+static const char * report_type_map[] = {"All","Spin","Shot","Pwr",""};
+static const char * report_scroll_map[] = {SYMBOL_UP,SYMBOL_DOWN,""};
 
-/* Circular buffer for the report - extra 4 bytes pad are aligned, guaranteed null */
-static char report_buf[REPORT_BUF_LINES][REPORT_BUF_CHARS+4] = {0};
-static int report_buf_next = 0;
 
-/* Global text label */
-static lv_obj_t * report_stream;
+/* Public report print with a motor and type for filtering */
+void report_event(uint8_t motor, report_type_t type, const char * str)
+{
+    LOG_INFO("REPORT: Got request to report %s",str);
+
+    /* Claim the next line, then publish it with its sequence once filled */
+    uint32_t n = __atomic_fetch_add(&report_head,1,__ATOMIC_RELAXED);
+    report_line_t * line = &report_lines[n & REPORT_MASK];
+    __atomic_store_n(&line->seq,0,__ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    line->time = millis();
+    line->motor = motor;
+    line->type = type;
+    strncpy(line->text,str,REPORT_LINE_CHARS - 1);
+    line->text[REPORT_LINE_CHARS - 1] = 0;
+    __atomic_store_n(&line->seq,n + 1,__ATOMIC_RELEASE);
+}
 
-/* Public report print buffer - note string is truncated at null or 44 printable chars */
+/* Public report print buffer - note string is truncated at REPORT_LINE_CHARS-1 chars */
 void report_print(const char * str)
 {
-    /* Verify report has init */
-    if(!report_has_init)
+    report_event(REPORT_MOTOR_NONE,REPORT_EV_INFO,str);
+}
+
+/* Copy line n, false if it was overwritten or is still being written */
+static bool report_read(uint32_t n, report_line_t * out)
+{
+    const report_line_t * line = &report_lines[n & REPORT_MASK];
+    if(__atomic_load_n(&line->seq,__ATOMIC_ACQUIRE) != n + 1)
     {
-        LOG_ERROR("REPORT: Tried to report before initialized");
-        return;
+        return false;
     }
+    memcpy(out,line,sizeof(*out));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&line->seq,__ATOMIC_RELAXED) == n + 1;
+}
 
-    LOG_INFO("REPORT: Got request to report %s",str);
-    LOG_DEBUG("buf next is %d",report_buf_next);
-    /* Copy incoming string into print buffer as-is at the next entry space */
-    strncpy(&report_buf[report_buf_next][0],str,REPORT_BUF_CHARS);
+/* True if a line passes the filters */
+static bool report_match(const report_line_t * line)
+{
+    if(report_filter_motor >= 0 && line->motor != report_filter_motor) return false;
+    if(report_filter_type >= 0 && line->type != report_filter_type) return false;
+    return true;
+}
 
-    /* Increment next line and roll over */
-    report_buf_next++;
-    if(report_buf_next >= REPORT_BUF_LINES)
+/* Oldest line still in the arena */
+static inline uint32_t report_oldest(uint32_t head)
+{
+    return head > REPORT_HISTORY ? head - REPORT_HISTORY : 0;
+}
+
+/* Update the visible rows, runs in the graphics task */
+static void report_refresh(void * param)
+{
+    if(!report_page || lv_obj_get_hidden(report_page))
+    {
+        return;
+    }
+    uint32_t head = __atomic_load_n(&report_head,__ATOMIC_ACQUIRE);
+    if(head == report_drawn_head && !report_dirty)
+    {
+        return;
+    }
+    report_drawn_head = head;
+    report_dirty = false;
+
+    /* Scrolled past the end of the arena, back to following */
+    uint32_t oldest = report_oldest(head);
+    if(report_view_end && report_view_end <= oldest)
     {
-        report_buf_next = 0;
+        report_view_end = 0;
     }
 
-    /* Now concat each string with a newline */
-    static char report_out[REPORT_BUF_LINES*(REPORT_BUF_CHARS+1)+1];
-    report_out[0] = 0;
-    for(int i = 0; i < REPORT_BUF_LINES; i++)
+    /* Walk back from the end of the view for the newest matching lines */
+    uint32_t end = report_view_end ? report_view_end : head;
+    static report_line_t found[REPORT_VIEW_LINES];
+    uint32_t found_n[REPORT_VIEW_LINES];
+    int count = 0;
+    for(uint32_t n = end; n > oldest && count < REPORT_VIEW_LINES; n--)
     {
-        /* Get index into circular buf and wrap */
-        int j = i + report_buf_next;
-        if(j >= REPORT_BUF_LINES)
+        if(report_read(n - 1,&found[count]) && report_match(&found[count]))
         {
-            j -= REPORT_BUF_LINES;
+            found_n[count++] = n - 1;
         }
+    }
+    report_view_count = count;
+    report_view_first = count ? found_n[count - 1] : end;
 
-        LOG_DEBUG("Concat'ing buf entry %d, line %d",j,i);
+    /* Oldest at the top, only touching rows that changed */
+    for(int r = 0; r < REPORT_VIEW_LINES; r++)
+    {
+        int i = count - 1 - r;
+        uint32_t shown = i >= 0 ? found_n[i] + 1 : 0;
+        if(shown == report_shown[r])
+        {
+            continue;
+        }
+        report_shown[r] = shown;
+        lv_label_set_text(report_rows[r],i >= 0 ? found[i].text : "");
+    }
 
-        /* Concat this line in the entry into the out string */
-        strcat(report_out,&report_buf[j][0]);
-        strcat(report_out,"\n");
+    /* Title shows how far back we are */
+    char title[32];
+    if(report_view_end)
+    {
+        snprintf(title,sizeof(title),"REPORT (%d newer)",(int)(head - report_view_end));
+    }
+    else
+    {
+        strcpy(title,"REPORT");
+    }
+    if(strcmp(title,lv_label_get_text(report_title)))
+    {
+        lv_label_set_text(report_title,title);
     }
+}
 
-    /* Remove the last char (the newline) */
-    report_out[strlen(report_out)-1] = 0;
+/* Motor filter callback */
+static lv_res_t report_motor_cb(lv_obj_t * btnm, const char * txt)
+{
+    report_filter_motor = strcmp(txt,"All") ? txt[0] - 'A' : -1;
+    report_view_end = 0;
+    report_dirty = true;
+    return LV_RES_OK;
+}
 
-    /* Send to graphics layer */
-    lv_label_set_text(report_stream,report_out);
+/* Type filter callback */
+static lv_res_t report_type_cb(lv_obj_t * btnm, const char * txt)
+{
+    for(int i = 0; i < REPORT_EV_COUNT; i++)
+    {
+        if(!strcmp(txt,report_type_map[i]))
+        {
+            /* Map index 0 is All, types start at SPINUP */
+            report_filter_type = i ? i : -1;
+        }
+    }
+    report_view_end = 0;
+    report_dirty = true;
+    return LV_RES_OK;
 }
 
+/* Scroll callback, a page at a time */
+static lv_res_t report_scroll_cb(lv_obj_t * btnm, const char * txt)
+{
+    uint32_t head = __atomic_load_n(&report_head,__ATOMIC_ACQUIRE);
+    if(!strcmp(txt,SYMBOL_UP))
+    {
+        /* Only if the view is full, otherwise there is nothing older */
+        if(report_view_count >= REPORT_VIEW_LINES)
+        {
+            report_view_end = report_view_first;
+        }
+    }
+    else if(report_view_end)
+    {
+        /* Forward over one page of matching lines, following again at the end */
+        uint32_t n = report_view_end;
+        report_line_t line;
+        for(int count = 0; n < head && count < REPORT_VIEW_LINES; n++)
+        {
+            if(report_read(n,&line) && report_match(&line))
+            {
+                count++;
+            }
+        }
+        report_view_end = n >= head ? 0 : n;
+    }
+    report_dirty = true;
+    return LV_RES_OK;
+}
 
+/* Create a selector button matrix */
+static lv_obj_t * report_btnm(lv_obj_t * page, const char ** map, lv_btnm_action_t cb, bool toggle, lv_coord_t x, lv_coord_t w)
+{
+    lv_obj_t * btnm = lv_btnm_create(page,NULL);
+    lv_btnm_set_map(btnm,map);
+    lv_btnm_set_action(btnm,cb);
+    lv_btnm_set_toggle(btnm,toggle,0);
+    lv_btnm_set_style(btnm,LV_BTNM_STYLE_BG,&style_page);
+    lv_btnm_set_style(btnm,LV_BTNM_STYLE_BTN_REL,&style_blu_ina);
+    lv_btnm_set_style(btnm,LV_BTNM_STYLE_BTN_PR,&style_blu_act);
+    lv_btnm_set_style(btnm,LV_BTNM_STYLE_BTN_TGL_REL,&style_blu_act);
+    lv_btnm_set_style(btnm,LV_BTNM_STYLE_BTN_TGL_PR,&style_blu_act);
+    /* Under the rows, ending inside the 240 px page so nothing needs scrolling */
+    lv_obj_set_size(btnm,w,34);
+    lv_obj_align(btnm,0,LV_ALIGN_IN_TOP_LEFT,x,202);
+    return btnm;
+}
 
 /* Function to initialize the report page */
 void report_draw(lv_obj_t * page)
 {
+    report_page = page;
+
     /* Create a title */
-    lv_obj_t * label, * newpage, * button, * icon;
-    label = lv_label_create(page,NULL);
-    lv_label_set_text(label,"REPORT");
-    lv_obj_align(label,0,LV_ALIGN_IN_TOP_MID,0,0);
-
-    /* Create a page for the report data */
-    newpage = lv_page_create(page,NULL);
-    lv_obj_set_style(newpage,&style_page);
-    lv_obj_align(newpage,0,LV_ALIGN_IN_TOP_LEFT,4,32);
-    lv_obj_set_size(newpage,408,200);
-    lv_page_set_scrl_layout(newpage,LV_LAYOUT_COL_L);
-
-    /* Create a label on that page */
-    report_stream = lv_label_create(newpage,NULL);
-    lv_label_set_text(report_stream,"");
-    report_has_init = true;
-}
+    report_title = lv_label_create(page,NULL);
+    lv_label_set_text(report_title,"REPORT");
+    lv_obj_align(report_title,0,LV_ALIGN_IN_TOP_MID,0,0);
+
+    /* Create a box with one label per visible row, rows are reused as the view moves */
+    lv_obj_t * box = lv_cont_create(page,NULL);
+    lv_obj_set_style(box,&style_page);
+    lv_obj_align(box,0,LV_ALIGN_IN_TOP_LEFT,4,22);
+    lv_obj_set_size(box,408,178);
+    lv_cont_set_layout(box,LV_LAYOUT_COL_L);
+    for(int r = 0; r < REPORT_VIEW_LINES; r++)
+    {
+        report_rows[r] = lv_label_create(box,NULL);
+        lv_label_set_long_mode(report_rows[r],LV_LABEL_LONG_DOT);
+        lv_obj_set_width(report_rows[r],400);
+        lv_label_set_text(report_rows[r],"");
+        report_shown[r] = 0;
+    }
 
+    /* Filters and scrolling */
+    report_btnm(page,report_motor_map,report_motor_cb,true,4,180);
+    report_btnm(page,report_type_map,report_type_cb,true,188,154);
+    report_btnm(page,report_scroll_map,report_scroll_cb,false,346,66);
+
+    /* Lines reported before the page existed are already in the arena */
+    report_dirty = true;
+    lv_task_create(report_refresh,REPORT_PERIOD,LV_TASK_PRIO_LOW,NULL);
+}
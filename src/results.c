@@ -0,0 +1,415 @@
+/* Test result store on the SD card */
+#include "main.h"
+
+/* Include pros api */
+#include "pros/apix.h"
+
+/* Use pal log */
+#define LOG_LEVEL_FILE LOG_LEVEL_WARN
+#include "pal/log.h"
+
+#include <string.h>
+#include "frame.h"
+#include "results.h"
+
+/* Card record layout (see results_pack) */
+#define RESULTS_MAGIC 0x5352
+#define RESULTS_CRC_OFS (RESULTS_REC_SIZE - 2)
+
+/* Index entry, enough to filter and rank without reading the card */
+typedef struct
+{
+    uint32_t session;
+    uint32_t recno;
+    float val;
+    int16_t target;
+    uint16_t build_day;
+    uint8_t type;
+    uint8_t motor;
+    uint8_t gearset;
+} results_idx_t;
+
+static results_idx_t results_index[RESULTS_INDEX_MAX];
+static int results_nindex = 0;
+/* Record number of the next record written to the card */
+static uint32_t results_nrec = 0;
+
+/* Store is open */
+static bool results_enabled = false;
+static uint32_t results_cur_session = 0;
+static uint16_t results_cur_day = 0;
+
+/* Pending records, written by the writer task so the control loop never waits on the card */
+static queue_t results_queue = NULL;
+/* Index lock (short, never held across card access) and card lock */
+static mutex_t results_idx_lock = NULL;
+static mutex_t results_file_lock = NULL;
+
+/* Float to/from wire format */
+static uint8_t * results_put_f32(uint8_t * p, float v)
+{
+    union { float f; uint32_t u; } conv;
+    conv.f = v;
+    return frame_put_u32(p,conv.u);
+}
+static float results_get_f32(const uint8_t * p)
+{
+    union { float f; uint32_t u; } conv;
+    conv.u = frame_get_u32(p);
+    return conv.f;
+}
+
+void results_pack(const results_rec_t * rec, uint8_t * out)
+{
+    uint8_t * p = out;
+    memset(out,0,RESULTS_REC_SIZE);
+    p = frame_put_u16(p,RESULTS_MAGIC);
+    *p++ = RESULTS_VERSION;
+    *p++ = rec->type;
+    p = frame_put_u32(p,rec->session);
+    p = frame_put_u32(p,rec->time);
+    p = frame_put_u16(p,rec->build_day);
+    *p++ = rec->motor;
+    *p++ = rec->port;
+    *p++ = rec->gearset;
+    *p++ = rec->flags;
+    *p++ = rec->members;
+    p++;
+    p = frame_put_u16(p,(uint16_t)rec->target);
+    p += 2;
+    for(int i = 0; i < 3; i++)
+    {
+        p = results_put_f32(p,rec->val[i]);
+    }
+    frame_put_u16(&out[RESULTS_CRC_OFS],frame_crc16(out,RESULTS_CRC_OFS));
+}
+
+bool results_unpack(const uint8_t * in, results_rec_t * rec)
+{
+    if(frame_get_u16(in) != RESULTS_MAGIC || in[2] != RESULTS_VERSION ||
+       frame_get_u16(&in[RESULTS_CRC_OFS]) != frame_crc16(in,RESULTS_CRC_OFS))
+    {
+        return false;
+    }
+    rec->type = in[3];
+    rec->session = frame_get_u32(&in[4]);
+    rec->time = frame_get_u32(&in[8]);
+    rec->build_day = frame_get_u16(&in[12]);
+    rec->motor = in[14];
+    rec->port = in[15];
+    rec->gearset = in[16];
+    rec->flags = in[17];
+    rec->members = in[18];
+    rec->target = (int16_t)frame_get_u16(&in[20]);
+    for(int i = 0; i < 3; i++)
+    {
+        rec->val[i] = results_get_f32(&in[24 + 4 * i]);
+    }
+    return rec->type < RESULTS_TYPE_COUNT;
+}
+
+/* Days since 2000-01-01 from a __DATE__ string ("Mmm dd yyyy") */
+static uint16_t results_parse_date(const char * date)
+{
+    static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    static const uint16_t mdays[] = {0,31,59,90,120,151,181,212,243,273,304,334};
+    int month = 0;
+    while(month < 12 && strncmp(&months[month * 3],date,3)) month++;
+    if(month >= 12) return 0;
+    int day = atoi(&date[4]);
+    int year = atoi(&date[7]) - 2000;
+    if(year < 0) return 0;
+    int days = year * 365 + (year + 3) / 4 + mdays[month] + day - 1;
+    if(!(year % 4) && month >= 2) days++;
+    return days;
+}
+
+/* Add a record to the index, caller holds the index lock */
+static void results_index_add(const results_rec_t * rec, uint32_t recno)
+{
+    if(results_nindex >= RESULTS_INDEX_MAX)
+    {
+        /* Keep the newest, dropping the oldest half at once so this is rare */
+        memmove(results_index,&results_index[RESULTS_INDEX_MAX / 2],sizeof(results_index[0]) * (RESULTS_INDEX_MAX / 2));
+        results_nindex = RESULTS_INDEX_MAX / 2;
+    }
+    results_idx_t * e = &results_index[results_nindex++];
+    e->session = rec->session;
+    e->recno = recno;
+    e->val = rec->val[0];
+    e->target = rec->target;
+    e->build_day = rec->build_day;
+    e->type = rec->type;
+    e->motor = rec->motor;
+    e->gearset = rec->gearset;
+}
+
+static bool results_match(const results_idx_t * e, const results_query_t * q)
+{
+    if(q->type >= 0 && e->type != q->type) return false;
+    if(q->motor >= 0 && e->motor != q->motor) return false;
+    if(q->gearset >= 0 && e->gearset != q->gearset) return false;
+    if(q->target >= 0 && abs(e->target - q->target) > q->target_tol) return false;
+    if(q->build_day_min >= 0 && e->build_day < q->build_day_min) return false;
+    if(q->session >= 0 && e->session != (uint32_t)q->session) return false;
+    return true;
+}
+
+/* Index entry of the best match, -1 if none, caller holds the index lock */
+static int results_find_best(const results_query_t * q)
+{
+    int best = -1;
+    for(int i = 0; i < results_nindex; i++)
+    {
+        if(results_match(&results_index[i],q) && (best < 0 || results_index[i].val < results_index[best].val))
+        {
+            best = i;
+        }
+    }
+    return best;
+}
+
+/* Read the file, building the index and finding the last session */
+static void results_load()
+{
+    FILE * f = fopen(RESULTS_FILE,"rb");
+    if(!f)
+    {
+        LOG_INFO("RESULTS: No result file, starting a new one");
+        return;
+    }
+
+    uint8_t buf[RESULTS_REC_SIZE];
+    results_rec_t rec;
+    int bad = 0;
+    size_t got;
+    while((got = fread(buf,1,RESULTS_REC_SIZE,f)) == RESULTS_REC_SIZE)
+    {
+        if(results_unpack(buf,&rec))
+        {
+            results_index_add(&rec,results_nrec);
+            if(rec.session > results_cur_session)
+            {
+                results_cur_session = rec.session;
+            }
+        }
+        else
+        {
+            bad++;
+        }
+        results_nrec++;
+    }
+    fclose(f);
+
+    /* A write cut short leaves a partial record, pad it out so later records stay aligned */
+    if(got)
+    {
+        f = fopen(RESULTS_FILE,"ab");
+        if(f)
+        {
+            memset(buf,0,sizeof(buf));
+            fwrite(buf,1,RESULTS_REC_SIZE - got,f);
+            fclose(f);
+        }
+        results_nrec++;
+        bad++;
+    }
+    if(bad)
+    {
+        LOG_WARN("RESULTS: Skipped %d damaged records",bad);
+    }
+    LOG_INFO("RESULTS: Loaded %d records, last session %d",results_nindex,(int)results_cur_session);
+}
+
+/* Writer task, appends each record and closes the file so it is committed to the card */
+static void results_task(void * param)
+{
+    results_rec_t rec;
+    uint8_t buf[RESULTS_REC_SIZE];
+    while(1)
+    {
+        if(!queue_recv(results_queue,&rec,TIMEOUT_MAX))
+        {
+            continue;
+        }
+        results_pack(&rec,buf);
+
+        mutex_take(results_file_lock,TIMEOUT_MAX);
+        FILE * f = fopen(RESULTS_FILE,"ab");
+        bool ok = f && fwrite(buf,1,RESULTS_REC_SIZE,f) == RESULTS_REC_SIZE;
+        if(f) fclose(f);
+        uint32_t recno = results_nrec;
+        if(ok) results_nrec++;
+        mutex_give(results_file_lock);
+
+        if(!ok)
+        {
+            LOG_ERROR("RESULTS: Error writing %s",RESULTS_FILE);
+            continue;
+        }
+        mutex_take(results_idx_lock,TIMEOUT_MAX);
+        results_index_add(&rec,recno);
+        mutex_give(results_idx_lock);
+    }
+}
+
+void results_query_any(results_query_t * q)
+{
+    q->type = -1;
+    q->motor = -1;
+    q->gearset = -1;
+    q->target = -1;
+    q->target_tol = 0;
+    q->build_day_min = -1;
+    q->session = -1;
+}
+
+void results_init()
+{
+    results_cur_day = results_parse_date(__DATE__);
+    if(!usd_is_installed())
+    {
+        LOG_INFO("RESULTS: No SD card, results not saved");
+        return;
+    }
+
+    results_idx_lock = mutex_create();
+    results_file_lock = mutex_create();
+    results_queue = queue_create(RESULTS_QUEUE_LEN,sizeof(results_rec_t));
+    if(!results_idx_lock || !results_file_lock || !results_queue)
+    {
+        LOG_ERROR("RESULTS: Unable to allocate");
+        return;
+    }
+
+    results_load();
+    results_cur_session++;
+
+    /* Below the control task, the card can take tens of ms */
+    if(!task_create(results_task,NULL,TASK_PRIORITY_DEFAULT-1,TASK_STACK_DEPTH_DEFAULT,"results"))
+    {
+        LOG_ERROR("RESULTS: Unable to start task");
+        return;
+    }
+    results_enabled = true;
+    LOG_ALWAYS("RESULTS: Session %d, build day %d",(int)results_cur_session,results_cur_day);
+}
+
+void results_add(uint8_t motor, results_type_t type, float a, float b, float c)
+{
+    if(!results_enabled)
+    {
+        return;
+    }
+
+    /* Followers run with the leader's configuration */
+    motor_t * mine = &motors[motor];
+    motor_t * lead = mine->leader >= 0 ? &motors[mine->leader] : mine;
+    results_rec_t rec;
+    rec.session = results_cur_session;
+    rec.build_day = results_cur_day;
+    rec.time = millis();
+    rec.type = type;
+    rec.motor = motor;
+    rec.port = mine->port;
+    rec.gearset = lead->gearset;
+    rec.flags = mine->reversed ? RESULTS_FLAG_REVERSED : 0;
+    rec.members = 0;
+    for(int i = 0; i < NUM_MOTORS; i++)
+    {
+        if(motors[i].port >= 0 && (i == lead->idx || motors[i].leader == lead->idx))
+        {
+            rec.members++;
+        }
+    }
+    rec.target = lead->target;
+    rec.val[0] = a;
+    rec.val[1] = b;
+    rec.val[2] = c;
+
+    /* Compare against earlier results with the same configuration */
+    results_query_t q;
+    results_query_any(&q);
+    q.type = type;
+    q.gearset = rec.gearset;
+    q.target = rec.target;
+    int prev = -1;
+    float prev_val = 0;
+    if(mutex_take(results_idx_lock,0))
+    {
+        prev = results_find_best(&q);
+        if(prev >= 0) prev_val = results_index[prev].val;
+        mutex_give(results_idx_lock);
+    }
+    if(prev >= 0 && a < prev_val && type != RESULTS_RUN_POWER)
+    {
+        REPORT_EV(motor,type == RESULTS_SHOT ? REPORT_EV_SHOT : REPORT_EV_SPINUP,"MTR %c: New best, was %1.2f",motor+'A',prev_val);
+    }
+
+    if(!queue_append(results_queue,&rec,0))
+    {
+        LOG_WARN("RESULTS: Queue full, result dropped");
+    }
+}
+
+bool results_best(const results_query_t * q, results_rec_t * out)
+{
+    if(!results_enabled)
+    {
+        return false;
+    }
+
+    mutex_take(results_idx_lock,TIMEOUT_MAX);
+    int best = results_find_best(q);
+    uint32_t recno = best >= 0 ? results_index[best].recno : 0;
+    mutex_give(results_idx_lock);
+    if(best < 0)
+    {
+        return false;
+    }
+
+    /* Full record from the card */
+    uint8_t buf[RESULTS_REC_SIZE];
+    bool ok = false;
+    mutex_take(results_file_lock,TIMEOUT_MAX);
+    FILE * f = fopen(RESULTS_FILE,"rb");
+    if(f)
+    {
+        ok = !fseek(f,(long)recno * RESULTS_REC_SIZE,SEEK_SET) &&
+             fread(buf,1,RESULTS_REC_SIZE,f) == RESULTS_REC_SIZE &&
+             results_unpack(buf,out);
+        fclose(f);
+    }
+    mutex_give(results_file_lock);
+    if(!ok)
+    {
+        LOG_ERROR("RESULTS: Error reading record %d",(int)recno);
+    }
+    return ok;
+}
+
+int results_count(const results_query_t * q)
+{
+    if(!results_enabled)
+    {
+        return 0;
+    }
+    int count = 0;
+    mutex_take(results_idx_lock,TIMEOUT_MAX);
+    for(int i = 0; i < results_nindex; i++)
+    {
+        count += results_match(&results_index[i],q);
+    }
+    mutex_give(results_idx_lock);
+    return count;
+}
+
+uint32_t results_session()
+{
+    return results_cur_session;
+}
+
+uint16_t results_build_day()
+{
+    return results_cur_day;
+}
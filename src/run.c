@@ -21,6 +21,12 @@ enum
 
 static bool run_has_init = false;
 
+/* Cached speed widgets, so only changes reach LVGL */
+static view_t run_view_set[NUM_MOTORS];
+static view_t run_view_act[NUM_MOTORS];
+static view_t run_view_act_label[NUM_MOTORS];
+static view_t run_view_power[NUM_MOTORS];
+
 
 /* Function to update run button */
 void run_update_run(uint8_t idx)
@@ -43,17 +49,17 @@ void run_update_run(uint8_t idx)
     /* Motor is follower, gray out */
     if(motors[idx].leader >= 0)
     {
-        lv_obj_set_style(motors[idx].run.power,&style_dis);
+        view_set_style(&run_view_power[idx],&style_dis);
     }
     /* Motor is on, set green */
     else if(powered)
     {
-        lv_obj_set_style(motors[idx].run.power,&style_grn_act);
+        view_set_style(&run_view_power[idx],&style_grn_act);
     }
     /* Motor is off, set red */
     else
     {
-        lv_obj_set_style(motors[idx].run.power,&style_red_ina); 
+        view_set_style(&run_view_power[idx],&style_red_ina);
     }  
 }
 
@@ -77,14 +83,14 @@ void run_update_follow(uint8_t idx)
     lv_obj_set_style(motors[idx].run.inc,style);
     lv_obj_set_style(motors[idx].run.dec,style);
     lv_obj_set_style(motors[idx].run.set,style);
-    lv_obj_set_style(motors[idx].run.act,style);
+    /* The actual speed's style belongs to run_update_speeds, through its view cache */
 
     /* Call run update run to update it's grayed out status */
     run_update_run(idx);
 }
 
-/* Update speeds */
-void run_update_speeds(uint8_t idx)
+/* Update speeds with the values from the control task */
+void run_update_speeds(uint8_t idx, int target, int speed)
 {
     /* Break out if init isn't done */
     if(!run_has_init)
@@ -98,33 +104,29 @@ void run_update_speeds(uint8_t idx)
         return;
     }   
 
-    /* Get our target from the leader if leading */
-    int target = motors[idx].target;
-    if(motors[idx].leader >= 0) target = motors[motors[idx].leader].target;
-
     /* Set speed */
     char temp[8];
     sprintf(temp,"%4d",target);
-    lv_label_set_text(motors[idx].run.set_label,temp);
+    view_set_text(&run_view_set[idx],temp);
 
     /* Act speed always comes from this motor */
-    sprintf(temp,"%4d",(int)motors[idx].data.speed);
-    lv_label_set_text(motors[idx].run.act_label,temp);
+    if(MOTOR_SPEED_INVALID == speed)
+    {
+        view_set_text(&run_view_act_label[idx]," ---");
+        view_set_style(&run_view_act[idx],&style_red_ina);
+        view_set_style(&run_view_act_label[idx],&style_red_ina);
+        return;
+    }
+    sprintf(temp,"%4d",speed);
+    view_set_text(&run_view_act_label[idx],temp);
 
     /* Act speed green if within 5% of target */
     double tol = target * 0.05;
     double min = target - tol;
     double max = target + tol;
-    if(motors[idx].data.speed >= min && motors[idx].data.speed <= max)
-    {
-        lv_obj_set_style(motors[idx].run.act,&style_grn_act);
-        lv_obj_set_style(motors[idx].run.act_label,&style_grn_act);
-    }
-    else
-    {
-        lv_obj_set_style(motors[idx].run.act,&style_red_ina);
-        lv_obj_set_style(motors[idx].run.act_label,&style_red_ina);
-    }
+    lv_style_t * style = (speed >= min && speed <= max) ? &style_grn_act : &style_red_ina;
+    view_set_style(&run_view_act[idx],style);
+    view_set_style(&run_view_act_label[idx],style);
 }
 
 
@@ -147,34 +149,20 @@ static lv_res_t run_cb(lv_obj_t *obj)
         return LV_RES_OK;
     }
 
-    /* If we are currently a follower, ignore the button */
-    if(motors[idx].leader >= 0)
-    {
-        LOG_WARN("Attempted to change property %d of motor %c, but it's a follower",cb,('A'+idx));
-        /* Update styles so it's grayed out still */
-        run_update_follow(idx);
-        return LV_RES_OK;
-    }
-
-    /* Selection based on property */
+    /* Selection based on property, the change itself is made by the control task */
     switch(cb)
     {
     case RUN_CB_RUN:
-        motors[idx].powered = !motors[idx].powered;
-        LOG_DEBUG("Changing motor state for %c to %d",('A'+idx),motors[idx].powered);
-        /* Easiest to just update powered for everyone */
-        for(int i = 0; i < NUM_MOTORS;i++)
-        {
-            run_update_run(i);
-        }
+        msg_ctrl_post(MSG_CTRL_POWER,idx,0);
         break;
     case RUN_CB_INC:
-        motor_inc(idx,1);
+        msg_ctrl_post(MSG_CTRL_SPEED,idx,1);
         break;
     case RUN_CB_DEC:
-        motor_inc(idx,-1);
+        msg_ctrl_post(MSG_CTRL_SPEED,idx,-1);
         break;
     }
+    return LV_RES_OK;
 }
 
 
@@ -193,11 +181,104 @@ static void run_button_setup(lv_obj_t * button)
 }
 
 
+/* Draw the contents of a motor's subpage */
+static void run_draw_motor(uint8_t i)
+{
+    lv_obj_t * label, * button, * icon;
+    lv_obj_t * newpage = motors[i].run.page;
+
+    /* Label for the motor */
+    label = lv_label_create(newpage,NULL);
+    char name[8];
+    sprintf(name,"MOTOR %c",(i+'A'));
+    lv_label_set_text(label,name);
+
+    /* If the motor is invalid, add a big NA and don't configure the rest */
+    if(motors[i].port < 0)
+    {
+        label = lv_label_create(newpage,NULL);
+        lv_label_set_text(label,"N/A");
+        lv_obj_align(label,0,LV_ALIGN_CENTER,0,100);
+        return;
+    }
+
+    /* Power button */
+    LV_IMG_DECLARE(mdi_power);
+    button = lv_btn_create(newpage,NULL);
+    motors[i].run.power = button;
+    view_bind(&run_view_power[i],button);
+    lv_obj_set_free_num(button,(i+(RUN_CB_RUN<<8)));
+    run_button_setup(button);
+    /* power icon */
+    icon = lv_img_create(button,NULL);
+    lv_img_set_src(icon,&mdi_power);
+    /* power text */
+    label = lv_label_create(button,NULL);
+    lv_label_set_text(label,"RUN");
+
+    /* Decrement button */
+    button = lv_btn_create(newpage,NULL);
+    motors[i].run.dec = button;
+    lv_obj_set_free_num(button,(i+(RUN_CB_DEC<<8)));
+    run_button_setup(button);
+    lv_obj_set_width(button,42);
+    lv_btn_set_layout(button,LV_LAYOUT_CENTER);
+    /* icon */
+    LV_IMG_DECLARE(mdi_arrow_down_bold);
+    icon = lv_img_create(button,NULL);
+    lv_img_set_src(icon,&mdi_arrow_down_bold);
+    lv_obj_set_style(icon,&style_dis);
+
+    /* Increment button */
+    button = lv_btn_create(newpage,NULL);
+    motors[i].run.inc = button;
+    lv_obj_set_free_num(button,(i+(RUN_CB_INC<<8)));
+    run_button_setup(button);
+    lv_obj_set_width(button,42);
+    lv_btn_set_layout(button,LV_LAYOUT_CENTER);
+    /* icon */
+    LV_IMG_DECLARE(mdi_arrow_up_bold);
+    icon = lv_img_create(button,NULL);
+    lv_img_set_src(icon,&mdi_arrow_up_bold);
+    lv_obj_set_style(icon,&style_dis);
+
+    /* Speed 'Button' */
+    button = lv_btn_create(newpage,NULL);
+    motors[i].run.set = button;
+    lv_obj_set_free_num(button,(i+(RUN_CB_SET<<8)));
+    run_button_setup(button);
+    /* icon */
+    LV_IMG_DECLARE(mdi_play_circle);
+    icon = lv_img_create(button,NULL);
+    lv_img_set_src(icon,&mdi_play_circle);
+    lv_obj_set_style(icon,&style_dis);
+    /* label */
+    label = lv_label_create(button,NULL);
+    motors[i].run.set_label = label;
+    view_bind(&run_view_set[i],label);
+
+    /* Act Speed 'Button' */
+    button = lv_btn_create(newpage,NULL);
+    motors[i].run.act = button;
+    view_bind(&run_view_act[i],button);
+    lv_obj_set_free_num(button,(i+(RUN_CB_ACT<<8)));
+    run_button_setup(button);
+    /* icon */
+    LV_IMG_DECLARE(mdi_speedometer);
+    icon = lv_img_create(button,NULL);
+    lv_img_set_src(icon,&mdi_speedometer);
+    lv_obj_set_style(icon,&style_dis);
+    /* label */
+    label = lv_label_create(button,NULL);
+    motors[i].run.act_label = label;
+    view_bind(&run_view_act_label[i],label);
+}
+
 /* Function to initialize the run page */
 void run_draw(lv_obj_t * page)
 {
     /* Create a title */
-    lv_obj_t * label, * newpage, * button, * icon;
+    lv_obj_t * label, * newpage;
     label = lv_label_create(page,NULL);
     lv_label_set_text(label,"RUN");
     lv_obj_align(label,0,LV_ALIGN_IN_TOP_MID,0,0);
@@ -214,93 +295,26 @@ void run_draw(lv_obj_t * page)
         lv_obj_set_style(newpage,&style_page);
         lv_page_set_scrl_layout(newpage,LV_LAYOUT_PRETTY);
 
-        /* Label for the motor */
-        label = lv_label_create(newpage,NULL);
-        char name[8];
-        sprintf(name,"MOTOR %c",(i+'A'));
-        lv_label_set_text(label,name);
-
-        /* If the motor is invalid, add a big NA and don't configure the rest */
-        if(motors[i].port < 0)
-        {
-            label = lv_label_create(newpage,NULL);
-            lv_label_set_text(label,"N/A");
-            lv_obj_align(label,0,LV_ALIGN_CENTER,0,100);
-            continue;
-        }
-
-        /* Power button */
-        LV_IMG_DECLARE(mdi_power);
-        button = lv_btn_create(newpage,NULL);
-        motors[i].run.power = button;
-        lv_obj_set_free_num(button,(i+(RUN_CB_RUN<<8)));
-        run_button_setup(button);
-        /* power icon */
-        icon = lv_img_create(button,NULL);
-        lv_img_set_src(icon,&mdi_power);
-        /* power text */
-        label = lv_label_create(button,NULL);
-        lv_label_set_text(label,"RUN");
-        /* Update active style */
-        run_update_run(i);
-
-        /* Decrement button */
-        button = lv_btn_create(newpage,NULL);
-        motors[i].run.dec = button;
-        lv_obj_set_free_num(button,(i+(RUN_CB_DEC<<8)));
-        run_button_setup(button);
-        lv_obj_set_width(button,42);
-        lv_btn_set_layout(button,LV_LAYOUT_CENTER);
-        /* icon */
-        LV_IMG_DECLARE(mdi_arrow_down_bold);
-        icon = lv_img_create(button,NULL);
-        lv_img_set_src(icon,&mdi_arrow_down_bold);
-        lv_obj_set_style(icon,&style_dis);
-
-        /* Increment button */
-        button = lv_btn_create(newpage,NULL);
-        motors[i].run.inc = button;
-        lv_obj_set_free_num(button,(i+(RUN_CB_INC<<8)));
-        run_button_setup(button);
-        lv_obj_set_width(button,42);
-        lv_btn_set_layout(button,LV_LAYOUT_CENTER);
-        /* icon */
-        LV_IMG_DECLARE(mdi_arrow_up_bold);
-        icon = lv_img_create(button,NULL);
-        lv_img_set_src(icon,&mdi_arrow_up_bold);
-        lv_obj_set_style(icon,&style_dis);
-
-        /* Speed 'Button' */
-        button = lv_btn_create(newpage,NULL);
-        motors[i].run.set = button;
-        lv_obj_set_free_num(button,(i+(RUN_CB_SET<<8)));
-        run_button_setup(button);
-        /* icon */
-        LV_IMG_DECLARE(mdi_play_circle);
-        icon = lv_img_create(button,NULL);
-        lv_img_set_src(icon,&mdi_play_circle);
-        lv_obj_set_style(icon,&style_dis);
-        /* label */
-        label = lv_label_create(button,NULL);
-        motors[i].run.set_label = label;
-
-        /* Act Speed 'Button' */
-        button = lv_btn_create(newpage,NULL);
-        motors[i].run.act = button;
-        lv_obj_set_free_num(button,(i+(RUN_CB_ACT<<8)));
-        run_button_setup(button);
-        /* icon */
-        LV_IMG_DECLARE(mdi_speedometer);
-        icon = lv_img_create(button,NULL);
-        lv_img_set_src(icon,&mdi_speedometer);
-        lv_obj_set_style(icon,&style_dis);
-        /* label */
-        label = lv_label_create(button,NULL);
-        motors[i].run.act_label = label;
-
-        /* Update run for this motor */
-        run_update_run(i);
+        run_draw_motor(i);
     }
     run_has_init = true;
+
+    /* Drawn on first visit, so catch up with configuration changes made before then */
+    for(int i = 0; i < 4; i++)
+    {
+        run_update_follow(i);
+    }
 }
 
+/* Redraw a motor's subpage after its port changed, graphics task only */
+void run_redraw(uint8_t idx)
+{
+    /* Not drawn yet, it will be drawn with the current port */
+    if(!run_has_init)
+    {
+        return;
+    }
+    lv_page_clean(motors[idx].run.page);
+    run_draw_motor(idx);
+    run_update_follow(idx);
+}
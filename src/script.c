@@ -0,0 +1,523 @@
+/* Scripted test sequences */
+#include "main.h"
+
+/* Include pros api */
+#include "pros/apix.h"
+
+/* Use pal log, deferred since this runs every tick */
+#define LOG_LEVEL_FILE LOG_LEVEL_INFO
+#define LOG_DEFERRED
+#include "pal/log.h"
+
+#include "script.h"
+
+/* Keywords, in script_op_t order, with the numbers each takes */
+static const struct
+{
+    const char * name;
+    uint8_t args_min;
+    uint8_t args_max;
+} script_ops[SCRIPT_OP_COUNT] =
+{
+    [SCRIPT_OP_MOTOR]  = {"motor",  1, 1},
+    [SCRIPT_OP_TARGET] = {"target", 1, 1},
+    [SCRIPT_OP_ON]     = {"on",     0, 0},
+    [SCRIPT_OP_OFF]    = {"off",    0, 0},
+    [SCRIPT_OP_SETTLE] = {"settle", 1, 2},
+    [SCRIPT_OP_HOLD]   = {"hold",   1, 1},
+    [SCRIPT_OP_FEED]   = {"feed",   1, 1},
+    [SCRIPT_OP_REPEAT] = {"repeat", 1, 1},
+    [SCRIPT_OP_END]    = {"end",    0, 0},
+    [SCRIPT_OP_COOL]   = {"cool",   1, 2},
+    [SCRIPT_OP_BAND]   = {"band",   1, 1},
+    [SCRIPT_OP_ENDURE] = {"endure", 1, 1},
+};
+
+/* Loaded script */
+static script_step_t script_steps[SCRIPT_MAX_STEPS];
+static uint16_t script_nsteps = 0;
+
+/* Result of running a step for a tick */
+typedef enum
+{
+    SCRIPT_NEXT,
+    SCRIPT_WAIT,
+    SCRIPT_FAIL,
+} script_res_t;
+
+/* An open repeat */
+typedef struct
+{
+    uint16_t start;
+    uint32_t left;
+    uint32_t pass;
+} script_loop_t;
+
+/* Interpreter state, control task only */
+static struct
+{
+    bool running;
+    uint8_t lead;
+    uint16_t pc;
+    /* Time the current step started and the speed entered the settle band (ms) */
+    uint32_t step_ms;
+    uint32_t band_ms;
+    bool in_band;
+    /* Hottest a group may start a test at (C), 0 for any, and the wait for it was reported */
+    double band;
+    bool told;
+    /* Open repeats */
+    int8_t depth;
+    script_loop_t loops[SCRIPT_DEPTH];
+    /* Feeder pulse */
+    bool feeding;
+    uint32_t feed_off_ms;
+    /* Why the last step failed */
+    const char * why;
+    bool completed;
+} script_run;
+
+
+/* Parse one line into a step, returns false and an error on a bad line, a blank line gives op COUNT */
+static bool script_parse_line(char * text, script_step_t * step, const char ** err)
+{
+    char * hash = strchr(text,'#');
+    if(hash) *hash = 0;
+
+    char word[16];
+    char rest[64];
+    int n = sscanf(text,"%15s %63[^\n]",word,rest);
+    step->op = SCRIPT_OP_COUNT;
+    if(n < 1)
+    {
+        return true;
+    }
+    if(n < 2) rest[0] = 0;
+
+    int op;
+    for(op = 0; op < SCRIPT_OP_COUNT; op++)
+    {
+        if(!strcmp(word,script_ops[op].name)) break;
+    }
+    if(op >= SCRIPT_OP_COUNT)
+    {
+        *err = "unknown step";
+        return false;
+    }
+    step->op = op;
+    step->a = 0;
+    step->b = 0;
+
+    /* The motor is a letter, everything else numbers */
+    int args;
+    char letter = 0;
+    if(SCRIPT_OP_MOTOR == op)
+    {
+        args = sscanf(rest," %c",&letter);
+        step->a = letter - 'A';
+        if(args == 1 && (step->a < 0 || step->a >= NUM_MOTORS))
+        {
+            *err = "no such motor";
+            return false;
+        }
+    }
+    else
+    {
+        char extra;
+        args = sscanf(rest,"%f %f %c",&step->a,&step->b,&extra);
+        if(args < 0) args = 0;
+    }
+    if(args < script_ops[op].args_min || args > script_ops[op].args_max)
+    {
+        *err = "wrong number of values";
+        return false;
+    }
+
+    switch(op)
+    {
+    case SCRIPT_OP_TARGET:
+        if(step->a < 0 || step->a > 600) { *err = "target out of 0-600"; return false; }
+        break;
+    case SCRIPT_OP_SETTLE:
+        if(step->a <= 0) { *err = "band must be positive"; return false; }
+        if(args < 2) step->b = SCRIPT_SETTLE_TIMEOUT;
+        break;
+    case SCRIPT_OP_HOLD:
+        if(step->a < 0) { *err = "negative time"; return false; }
+        break;
+    case SCRIPT_OP_FEED:
+        if(step->a < 1 || step->a > 5000) { *err = "pulse out of 1-5000 ms"; return false; }
+        break;
+    case SCRIPT_OP_REPEAT:
+        if(step->a < 0 || step->a != (int)step->a) { *err = "count must be a whole number"; return false; }
+        break;
+    case SCRIPT_OP_COOL:
+        if(args < 2) step->b = SCRIPT_COOL_TIMEOUT;
+        break;
+    case SCRIPT_OP_BAND:
+        if(step->a < 0) { *err = "negative temperature"; return false; }
+        break;
+    case SCRIPT_OP_ENDURE:
+        if(step->a < 0) { *err = "negative time"; return false; }
+        break;
+    }
+    return true;
+}
+
+bool script_parse(FILE * f)
+{
+    uint16_t open[SCRIPT_DEPTH];
+    int depth = 0;
+    int line = 0;
+    char text[96];
+    const char * err = NULL;
+    script_nsteps = 0;
+    script_run.running = false;
+
+    while(!err && fgets(text,sizeof(text),f))
+    {
+        line++;
+        script_step_t step;
+        if(!script_parse_line(text,&step,&err))
+        {
+            break;
+        }
+        if(SCRIPT_OP_COUNT == step.op)
+        {
+            continue;
+        }
+        if(script_nsteps >= SCRIPT_MAX_STEPS)
+        {
+            err = "too many steps";
+            break;
+        }
+        step.line = line;
+        step.jump = 0;
+        if(SCRIPT_OP_REPEAT == step.op)
+        {
+            if(depth >= SCRIPT_DEPTH)
+            {
+                err = "repeats nested too deep";
+                break;
+            }
+            open[depth++] = script_nsteps;
+        }
+        else if(SCRIPT_OP_END == step.op)
+        {
+            if(!depth)
+            {
+                err = "end without repeat";
+                break;
+            }
+            step.jump = open[--depth];
+        }
+        script_steps[script_nsteps++] = step;
+    }
+    if(!err && depth)
+    {
+        line = script_steps[open[depth-1]].line;
+        err = "repeat without end";
+    }
+    if(err)
+    {
+        LOG_ERROR("SCRIPT: Line %d: %s",line,err);
+        REPORT("SCRIPT: Line %d: %s",line,err);
+        script_nsteps = 0;
+        return false;
+    }
+    LOG_INFO("SCRIPT: Loaded %d steps",(int)script_nsteps);
+    return true;
+}
+
+void script_init()
+{
+    adi_port_set_config(SCRIPT_FEED_PORT,E_ADI_DIGITAL_OUT);
+    adi_digital_write(SCRIPT_FEED_PORT,false);
+
+    if(!usd_is_installed())
+    {
+        LOG_INFO("SCRIPT: No SD card, no script");
+        return;
+    }
+    FILE * f = fopen(SCRIPT_FILE,"r");
+    if(!f)
+    {
+        LOG_INFO("SCRIPT: No %s",SCRIPT_FILE);
+        return;
+    }
+    if(script_parse(f))
+    {
+        REPORT("SCRIPT: %d steps loaded, Y on the controller starts it",(int)script_nsteps);
+    }
+    fclose(f);
+}
+
+bool script_running()
+{
+    return script_run.running;
+}
+
+bool script_completed()
+{
+    return script_run.completed;
+}
+
+/* Power the group, the run tab shows it like a button press */
+static void script_power(bool powered)
+{
+    if(motors[script_run.lead].powered != powered)
+    {
+        motors[script_run.lead].powered = powered;
+        msg_ui_post(MSG_UI_RUN,0,0,0);
+    }
+}
+
+static void script_stop(const char * why)
+{
+    uint8_t idx = script_run.lead;
+    script_power(false);
+    adi_digital_write(SCRIPT_FEED_PORT,false);
+    script_run.feeding = false;
+    script_run.running = false;
+    endure_stop();
+    script_run.completed = !why;
+    if(why)
+    {
+        int line = (script_run.pc < script_nsteps) ? script_steps[script_run.pc].line : 0;
+        LOG_WARN("SCRIPT: Stopped at line %d: %s",line,why);
+        REPORT_EV(idx,REPORT_EV_INFO,"SCRIPT: Stopped at line %d: %s",line,why);
+    }
+    else
+    {
+        LOG_INFO("SCRIPT: Complete");
+        REPORT_EV(idx,REPORT_EV_INFO,"SCRIPT: Complete");
+    }
+}
+
+void script_toggle(uint8_t idx)
+{
+    if(script_run.running)
+    {
+        script_stop("stopped by user");
+        return;
+    }
+    if(!script_nsteps)
+    {
+        REPORT_EV(idx,REPORT_EV_INFO,"SCRIPT: No script loaded from %s",SCRIPT_FILE);
+        return;
+    }
+    memset(&script_run,0,sizeof(script_run));
+    script_run.running = true;
+    script_run.lead = idx;
+    script_run.depth = -1;
+    script_run.band = THERMAL_BAND;
+    script_run.step_ms = millis();
+    LOG_INFO("SCRIPT: Starting on motor %c",idx+'A');
+    REPORT_EV(idx,REPORT_EV_INFO,"SCRIPT: Starting, %d steps",(int)script_nsteps);
+}
+
+/* Wait with the power off until the group's model says it is below a temperature,
+ * reporting the forecast once
+ */
+static script_res_t script_cool(double limit, double timeout, float elapsed)
+{
+    script_power(false);
+    if(thermal_group_temp(script_run.lead) <= limit)
+    {
+        return SCRIPT_NEXT;
+    }
+    if(!script_run.told)
+    {
+        double wait = thermal_group_cool_time(script_run.lead,limit);
+        LOG_INFO("SCRIPT: Cooling to %f C, forecast %f s",limit,wait);
+        if(wait < 0.0)
+        {
+            REPORT_EV(script_run.lead,REPORT_EV_INFO,"SCRIPT: Cooling to %d C, ambient is warmer",(int)limit);
+        }
+        else
+        {
+            REPORT_EV(script_run.lead,REPORT_EV_INFO,"SCRIPT: Cooling to %d C, about %d s",(int)limit,(int)wait);
+        }
+        script_run.told = true;
+    }
+    if(elapsed > timeout)
+    {
+        script_run.why = "never cooled down";
+        return SCRIPT_FAIL;
+    }
+    return SCRIPT_WAIT;
+}
+
+/* Run one step, NEXT once it is done */
+static script_res_t script_exec(const script_step_t * step, uint32_t now)
+{
+    motor_t * lead = &motors[script_run.lead];
+    group_t * grp = &groups[script_run.lead];
+    float elapsed = (now - script_run.step_ms) / 1000.0f;
+
+    switch(step->op)
+    {
+    case SCRIPT_OP_MOTOR:
+        if(motors[(int)step->a].port < 0 || motors[(int)step->a].leader >= 0)
+        {
+            script_run.why = "motor is not a leader";
+            return SCRIPT_FAIL;
+        }
+        script_power(false);
+        script_run.lead = (int)step->a;
+        return SCRIPT_NEXT;
+    case SCRIPT_OP_TARGET:
+        /* Checked here since the cartridge can change after the script is loaded */
+        if(step->a > motor_max_speed(script_run.lead))
+        {
+            static char why[40];
+            snprintf(why,sizeof(why),"target over cartridge max %d rpm",motor_max_speed(script_run.lead));
+            script_run.why = why;
+            return SCRIPT_FAIL;
+        }
+        lead->target = (int32_t)step->a;
+        return SCRIPT_NEXT;
+    case SCRIPT_OP_ON:
+        if(lead->powered)
+        {
+            return SCRIPT_NEXT;
+        }
+        if(!grp->data.spinup.armed)
+        {
+            if(elapsed > SCRIPT_ARM_TIMEOUT)
+            {
+                script_run.why = "spinup detector never re-armed";
+                return SCRIPT_FAIL;
+            }
+            return SCRIPT_WAIT;
+        }
+        /* Tests are only comparable from the same temperature */
+        if(script_run.band > 0.0 && thermal_group_temp(script_run.lead) > script_run.band)
+        {
+            return script_cool(script_run.band,SCRIPT_COOL_TIMEOUT,elapsed);
+        }
+        script_power(true);
+        return SCRIPT_NEXT;
+    case SCRIPT_OP_OFF:
+        script_power(false);
+        return SCRIPT_NEXT;
+    case SCRIPT_OP_SETTLE:
+        if(fabs(grp->data.speed - lead->target) <= lead->target * step->a / 100.0)
+        {
+            if(!script_run.in_band)
+            {
+                script_run.in_band = true;
+                script_run.band_ms = now;
+            }
+            if(now - script_run.band_ms >= SCRIPT_SETTLE_TIME * 1000)
+            {
+                return SCRIPT_NEXT;
+            }
+        }
+        else
+        {
+            script_run.in_band = false;
+        }
+        if(elapsed > step->b)
+        {
+            script_run.why = "speed never settled";
+            return SCRIPT_FAIL;
+        }
+        return SCRIPT_WAIT;
+    case SCRIPT_OP_HOLD:
+        return (elapsed >= step->a) ? SCRIPT_NEXT : SCRIPT_WAIT;
+    case SCRIPT_OP_FEED:
+        adi_digital_write(SCRIPT_FEED_PORT,true);
+        script_run.feeding = true;
+        script_run.feed_off_ms = now + (uint32_t)step->a;
+        endure_feed();
+        return SCRIPT_NEXT;
+    case SCRIPT_OP_REPEAT:
+        script_run.depth++;
+        script_run.loops[script_run.depth].start = script_run.pc + 1;
+        script_run.loops[script_run.depth].left = (uint32_t)step->a;
+        script_run.loops[script_run.depth].pass = 1;
+        return SCRIPT_NEXT;
+    case SCRIPT_OP_END:
+    {
+        /* Back to the top of the loop, or fall out of it */
+        script_loop_t * loop = &script_run.loops[script_run.depth];
+        if(!loop->left || --loop->left)
+        {
+            loop->pass++;
+            script_run.pc = loop->start - 1;
+            REPORT_EV(script_run.lead,REPORT_EV_INFO,"SCRIPT: Line %d pass %d",
+                      (int)script_steps[step->jump].line,(int)loop->pass);
+        }
+        else
+        {
+            script_run.depth--;
+        }
+        return SCRIPT_NEXT;
+    }
+    case SCRIPT_OP_COOL:
+        return script_cool(step->a,step->b,elapsed);
+    case SCRIPT_OP_BAND:
+        script_run.band = step->a;
+        return SCRIPT_NEXT;
+    case SCRIPT_OP_ENDURE:
+        if(step->a > 0)
+        {
+            endure_start(script_run.lead,step->a);
+        }
+        else
+        {
+            endure_stop();
+        }
+        return SCRIPT_NEXT;
+    }
+    script_run.why = "bad step";
+    return SCRIPT_FAIL;
+}
+
+void script_tick()
+{
+    uint32_t now = millis();
+
+    /* The feeder pulse ends on time whatever step is running */
+    if(script_run.feeding && (int32_t)(now - script_run.feed_off_ms) >= 0)
+    {
+        adi_digital_write(SCRIPT_FEED_PORT,false);
+        script_run.feeding = false;
+    }
+    if(!script_run.running)
+    {
+        return;
+    }
+    if(motors[script_run.lead].port < 0 || !groups[script_run.lead].count)
+    {
+        script_stop("group is gone");
+        return;
+    }
+    endure_tick();
+
+    for(int n = 0; n < SCRIPT_STEPS_PER_TICK; n++)
+    {
+        const script_step_t * step = &script_steps[script_run.pc];
+        script_res_t res = script_exec(step,now);
+        if(SCRIPT_WAIT == res)
+        {
+            return;
+        }
+        if(SCRIPT_FAIL == res)
+        {
+            script_stop(script_run.why);
+            return;
+        }
+        LOG_DEBUG("SCRIPT: Line %d %s done",(int)step->line,script_ops[step->op].name);
+        script_run.pc++;
+        script_run.step_ms = now;
+        script_run.in_band = false;
+        script_run.told = false;
+        if(script_run.pc >= script_nsteps)
+        {
+            script_stop(NULL);
+            return;
+        }
+    }
+}
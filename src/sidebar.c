@@ -23,6 +23,33 @@ static lv_obj_t * sidebar_objs[SIDEBAR_OBJ_COUNT];
 static lv_obj_t * sidebar_icons[SIDEBAR_OBJ_COUNT];
 /* Pages list */
 static lv_obj_t * sidebar_pages[SIDEBAR_OBJ_COUNT];
+/* Page contents are drawn on the first visit, boot only pays for the first page */
+static void (* const sidebar_draws[SIDEBAR_OBJ_COUNT])(lv_obj_t * page) =
+{
+    [SIDEBAR_OBJ_CONFIG] = config_draw,
+    [SIDEBAR_OBJ_RUN] = run_draw,
+    [SIDEBAR_OBJ_LOG] = plot_draw,
+    [SIDEBAR_OBJ_TEST] = report_draw,
+};
+static bool sidebar_drawn[SIDEBAR_OBJ_COUNT];
+static const char * sidebar_names[SIDEBAR_OBJ_COUNT] = {"CONFIG","RUN","LOG","TEST"};
+
+
+/* Draw a page if this is its first visit */
+static void sidebar_draw(uint32_t idx)
+{
+    if(sidebar_drawn[idx])
+    {
+        return;
+    }
+    uint64_t start = micros();
+    sidebar_draws[idx](sidebar_pages[idx]);
+    sidebar_drawn[idx] = true;
+
+    uint32_t count = 0, bytes = 0;
+    uiprof_tree(sidebar_pages[idx],&count,&bytes);
+    LOG_ALWAYS("Drew %s page in %d us, %d objects, %d bytes",sidebar_names[idx],(int)(micros() - start),(int)count,(int)bytes);
+}
 
 
 /* Sidebar button callback routine */
@@ -35,6 +62,7 @@ static lv_res_t sidebar_cb(lv_obj_t *obj)
     {
         /* Valid idx, change visible page by hiding all but this one */
         LOG_DEBUG("Page flipping to %d",idx);
+        sidebar_draw(idx);
         for(int i = 0; i < SIDEBAR_OBJ_COUNT; i++)
         {
             lv_obj_set_hidden(sidebar_pages[i],true);
@@ -50,10 +78,18 @@ static lv_res_t sidebar_cb(lv_obj_t *obj)
     return LV_RES_OK;
 }
 
+/* Sidebar long press, toggles the UI profiler overlay */
+static lv_res_t sidebar_long_cb(lv_obj_t *obj)
+{
+    uiprof_toggle();
+    return LV_RES_OK;
+}
+
 /* Initialize our data */
 void sidebar_init()
 {
     LOG_ALWAYS("Sidebar Init");
+    uint64_t start = micros();
 
     /* Declare all of the button icons we need */
     LV_IMG_DECLARE(mdi_cog_48px);
@@ -65,6 +101,7 @@ void sidebar_init()
     {
         sidebar_objs[i] = lv_btn_create(lv_scr_act(),NULL);
         lv_btn_set_action(sidebar_objs[i],LV_BTN_ACTION_CLICK,sidebar_cb);
+        lv_btn_set_action(sidebar_objs[i],LV_BTN_ACTION_LONG_PR,sidebar_long_cb);
         lv_obj_set_free_num(sidebar_objs[i],i);
         lv_btn_set_style(sidebar_objs[i],LV_BTN_STYLE_INA,&style_grn_ina);
         lv_btn_set_style(sidebar_objs[i],LV_BTN_STYLE_PR,&style_grn_ina);
@@ -95,7 +132,7 @@ void sidebar_init()
             break;
         }
 
-        /* Create a page corresponding to this button, currently empty */
+        /* Create a page corresponding to this button, drawn on first visit */
         sidebar_pages[i] = lv_page_create(lv_scr_act(),NULL);
         lv_obj_set_style(sidebar_pages[i],&style_page);
         lv_obj_align(sidebar_pages[i],0,LV_ALIGN_IN_TOP_LEFT,0,0);
@@ -103,22 +140,20 @@ void sidebar_init()
         lv_obj_set_hidden(sidebar_pages[i],true);
     }
 
-    /* Call all of the other functions to draw their pages */
-    config_draw(sidebar_pages[SIDEBAR_OBJ_CONFIG]);
-    run_draw(sidebar_pages[SIDEBAR_OBJ_RUN]);
-    report_draw(sidebar_pages[SIDEBAR_OBJ_TEST]);
+    /* Let the profiler count widgets per tab */
+    uiprof_set_tabs(sidebar_pages,sidebar_names,SIDEBAR_OBJ_COUNT);
 
     /* Select the config page by default */
     LOG_DEBUG("Flipping to page 0 by default");
     sidebar_cb(sidebar_objs[SIDEBAR_OBJ_CONFIG]);
 
-    /* Create a label on each page */
-    lv_obj_t * label;
-    label = lv_label_create(sidebar_pages[2],NULL);
-    lv_label_set_text(label,"LOG");
-
     /* Invalidate the screen and redraw it */
     lv_obj_invalidate(lv_scr_act());
     lv_refr_now();
 
+    /* Boot cost of the UI, millis() counts from power on */
+    uint32_t count = 0, bytes = 0;
+    uiprof_tree(lv_scr_act(),&count,&bytes);
+    LOG_ALWAYS("Sidebar: first frame at %d ms, init took %d us, %d objects, %d bytes",
+               (int)millis(),(int)(micros() - start),(int)count,(int)bytes);
 }
\ No newline at end of file
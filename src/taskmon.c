@@ -0,0 +1,215 @@
+/* RTOS task monitor */
+#include "main.h"
+
+/* Include pros api */
+#include "pros/apix.h"
+
+/* Use pal log */
+#define LOG_LEVEL_FILE LOG_LEVEL_INFO
+#include "pal/log.h"
+
+#include "taskmon.h"
+
+/* Stack headroom (words), from the kernel's FreeRTOS but not in the public
+ * headers. Weak so a kernel without it still links, headroom then shows as ?
+ */
+extern uint32_t task_get_stack_high_water_mark(task_t task) __attribute__((weak));
+
+/* Tasks watched, the app's own and the kernel's (names as of PROS 3).
+ * A task that isn't found is left out. Depth is 0 where the kernel doesn't say.
+ */
+typedef struct
+{
+    const char * name;
+    const char * label;
+    uint32_t depth;
+} taskmon_watch_t;
+
+static const taskmon_watch_t taskmon_watch[] =
+{
+    {"User Operator Control (PROS)", "ctrl",    TASK_STACK_DEPTH_DEFAULT},
+    {"dlog",                         "dlog",    TASK_STACK_DEPTH_DEFAULT},
+    {"tlmsd",                        "tlmsd",   TASK_STACK_DEPTH_DEFAULT},
+    {"results",                      "results", TASK_STACK_DEPTH_DEFAULT},
+    {"dash",                         "dash",    TASK_STACK_DEPTH_DEFAULT},
+    {"ports",                        "ports",   TASK_STACK_DEPTH_DEFAULT},
+    {"taskmon",                      "probe",   TASK_STACK_DEPTH_MIN},
+    {"Display Daemon (PROS)",        "display", 0},
+    {"PROS System Daemon",           "daemon",  0},
+};
+#define TASKMON_WATCH_COUNT (sizeof(taskmon_watch) / sizeof(taskmon_watch[0]))
+
+/* One watched task in the last window */
+typedef struct
+{
+    bool found;
+    task_state_e_t state;
+    uint32_t prio;
+    /* Stack words never used, -1 if unknown */
+    int32_t free;
+} taskmon_task_t;
+
+/* Last window */
+static struct
+{
+    uint32_t ms;
+    uint32_t count;
+    /* Percent of CPU */
+    int busy;
+    int ctrl;
+    int ui;
+    int dlog;
+    int other;
+    /* LVGL heap */
+    uint32_t objs;
+    uint32_t bytes;
+    uint32_t bytes_peak;
+#if LV_MEM_CUSTOM == 0
+    lv_mem_monitor_t mem;
+#endif
+    taskmon_task_t tasks[TASKMON_WATCH_COUNT];
+} taskmon_last;
+
+/* Probe totals (us), taken and cleared by the window task */
+static uint32_t taskmon_idle_us = 0;
+static uint32_t taskmon_awake_us = 0;
+
+static const char taskmon_state_names[] = "RrBSD?";
+
+
+/* Lowest priority task, any time it can run is idle time */
+static void taskmon_probe(void * param)
+{
+    while(1)
+    {
+        uint32_t start = (uint32_t)micros();
+        uint32_t last = start, now = start, ran = 0;
+        while(now - start < TASKMON_SLICE_US)
+        {
+            now = (uint32_t)micros();
+            if(now - last < TASKMON_GAP_US)
+            {
+                ran += now - last;
+            }
+            last = now;
+        }
+        __atomic_fetch_add(&taskmon_idle_us,ran,__ATOMIC_RELAXED);
+        __atomic_fetch_add(&taskmon_awake_us,now - start,__ATOMIC_RELAXED);
+        delay(1);
+    }
+}
+
+/* Share (percent) of a window taken by a span */
+static int taskmon_share(prof_span_t span, uint32_t window_ms)
+{
+    prof_stats_t s;
+    prof_get(span,&s);
+    if(!window_ms)
+    {
+        return 0;
+    }
+    return (int)((uint64_t)s.avg * s.count / (window_ms * 10));
+}
+
+void taskmon_format(char * out, size_t size)
+{
+    int o = snprintf(out,size,"CPU %d%% busy: ctrl %d%% ui %d%% dlog %d%% other %d%%, %d tasks",
+                     taskmon_last.busy,taskmon_last.ctrl,taskmon_last.ui,taskmon_last.dlog,taskmon_last.other,
+                     (int)taskmon_last.count);
+#if LV_MEM_CUSTOM == 0
+    o += snprintf(&out[o],size - o,"\nLVGL heap %d%% of %d B, %d%% frag, %d B biggest free",
+                  (int)taskmon_last.mem.used_pct,(int)LV_MEM_SIZE,(int)taskmon_last.mem.frag_pct,
+                  (int)taskmon_last.mem.free_biggest_size);
+#endif
+    o += snprintf(&out[o],size - o,"\nLVGL %d objects, %d B (%d B peak)",(int)taskmon_last.objs,
+                  (int)taskmon_last.bytes,(int)taskmon_last.bytes_peak);
+    o += snprintf(&out[o],size - o,"\nTASK     st pri stack free");
+    for(unsigned i = 0; i < TASKMON_WATCH_COUNT && o < (int)size; i++)
+    {
+        const taskmon_task_t * t = &taskmon_last.tasks[i];
+        if(!t->found)
+        {
+            continue;
+        }
+        o += snprintf(&out[o],size - o,"\n%-8s %c %3d",taskmon_watch[i].label,
+                      taskmon_state_names[(t->state < E_TASK_STATE_INVALID) ? t->state : E_TASK_STATE_INVALID],
+                      (int)t->prio);
+        if(t->free < 0)
+        {
+            o += snprintf(&out[o],size - o,"  ?");
+        }
+        else if(taskmon_watch[i].depth)
+        {
+            o += snprintf(&out[o],size - o,"  %d/%d",(int)t->free,(int)taskmon_watch[i].depth);
+        }
+        else
+        {
+            o += snprintf(&out[o],size - o,"  %d",(int)t->free);
+        }
+    }
+}
+
+/* Runs in the graphics task, closes a window every TASKMON_PERIOD */
+static void taskmon_task(void * param)
+{
+    static uint32_t start_ms = 0;
+    uint32_t ms = millis();
+    taskmon_last.ms = ms - start_ms;
+    start_ms = ms;
+
+    /* Load, a starved probe means the CPU was never idle */
+    uint32_t idle = __atomic_exchange_n(&taskmon_idle_us,0,__ATOMIC_RELAXED);
+    uint32_t awake = __atomic_exchange_n(&taskmon_awake_us,0,__ATOMIC_RELAXED);
+    taskmon_last.busy = awake ? 100 - (int)((uint64_t)idle * 100 / awake) : 100;
+    uint32_t prof_ms = prof_window_ms();
+    taskmon_last.ctrl = taskmon_share(PROF_TICK,prof_ms);
+    taskmon_last.ui = taskmon_share(PROF_REFR,prof_ms) + taskmon_share(PROF_UI_APPLY,prof_ms);
+    taskmon_last.dlog = taskmon_share(PROF_DLOG,prof_ms);
+    taskmon_last.other = taskmon_last.busy - taskmon_last.ctrl - taskmon_last.ui - taskmon_last.dlog;
+    if(taskmon_last.other < 0) taskmon_last.other = 0;
+
+    /* Tasks */
+    taskmon_last.count = task_get_count();
+    for(unsigned i = 0; i < TASKMON_WATCH_COUNT; i++)
+    {
+        taskmon_task_t * t = &taskmon_last.tasks[i];
+        task_t task = task_get_by_name(taskmon_watch[i].name);
+        t->found = (task != NULL);
+        if(!task)
+        {
+            continue;
+        }
+        t->state = task_get_state(task);
+        t->prio = task_get_priority(task);
+        t->free = task_get_stack_high_water_mark ? (int32_t)task_get_stack_high_water_mark(task) : -1;
+    }
+
+    /* LVGL heap, only the objects can be counted when LVGL allocates from the kernel heap */
+#if LV_MEM_CUSTOM == 0
+    lv_mem_monitor(&taskmon_last.mem);
+#endif
+    taskmon_last.objs = 0;
+    taskmon_last.bytes = 0;
+    uiprof_tree(lv_scr_act(),&taskmon_last.objs,&taskmon_last.bytes);
+    uiprof_tree(lv_layer_top(),&taskmon_last.objs,&taskmon_last.bytes);
+    if(taskmon_last.bytes > taskmon_last.bytes_peak) taskmon_last.bytes_peak = taskmon_last.bytes;
+
+    /* Log, one line for the load and heap and one per task */
+    char text[512];
+    taskmon_format(text,sizeof(text));
+    char * line = strtok(text,"\n");
+    while(line)
+    {
+        LOG_INFO("TASKMON: %s",line);
+        line = strtok(NULL,"\n");
+    }
+}
+
+void taskmon_init()
+{
+    if(!task_create(taskmon_probe,NULL,TASK_PRIORITY_MIN,TASK_STACK_DEPTH_MIN,"taskmon"))
+    {
+        LOG_ERROR("TASKMON: Unable to start probe");
+    }
+    lv_task_create(taskmon_task,TASKMON_PERIOD,LV_TASK_PRIO_LOWEST,NULL);
+}
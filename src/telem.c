@@ -0,0 +1,366 @@
+/* Binary telemetry stream over the USB serial port and to the SD card */
+#include "main.h"
+
+/* Include pros api */
+#include "pros/apix.h"
+
+/* Use pal log */
+#define LOG_LEVEL_FILE LOG_LEVEL_WARN
+#include "pal/log.h"
+
+#include "frame.h"
+#include "pack.h"
+#include "telem.h"
+
+/* Serial stream enabled */
+static bool telem_binary = false;
+/* SD recording, the file belongs to the SD task, the ring is filled by the control task */
+static bool telem_sd = false;
+static FILE * telem_sd_file = NULL;
+static char telem_sd_name[24];
+static uint8_t telem_sd_ring[TELEM_SD_RING];
+static uint32_t telem_sd_head = 0;
+static uint32_t telem_sd_tail = 0;
+static uint32_t telem_sd_dropped = 0;
+/* Sequence number of the next frame */
+static uint16_t telem_seq = 0;
+/* Time the schema was last sent */
+static uint32_t telem_schema_last = 0;
+/* Ticks since init, used to schedule keyframes */
+static uint32_t telem_ticks = 0;
+
+/* Records collected for this tick */
+static telem_rec_t telem_recs[NUM_MOTORS];
+static uint8_t telem_nrecs = 0;
+
+/* Frame being built (packed block or raw samples) */
+static uint8_t telem_blk[FRAME_MAX_PAYLOAD];
+static size_t telem_blk_len = 0;
+static uint8_t telem_blk_ticks = 0;
+static pack_ctx_t telem_pack;
+
+/* Encoded output buffer */
+static uint8_t telem_out[FRAME_MAX_ENCODED];
+
+/* True if any sink wants frames */
+static inline bool telem_active()
+{
+    return telem_binary || telem_sd;
+}
+
+/* Float to wire format */
+static uint8_t * telem_put_f32(uint8_t * p, float v)
+{
+    union { float f; uint32_t u; } conv;
+    conv.f = v;
+    return frame_put_u32(p,conv.u);
+}
+
+/* Write the common header to the start of a payload, the sequence number is
+ * stamped by telem_send so frames are numbered in the order they go out
+ */
+static uint8_t * telem_put_hdr(uint8_t * p, telem_frame_t type)
+{
+    *p++ = type;
+    p = frame_put_u16(p,0);
+    p = frame_put_u32(p,millis());
+    return p;
+}
+
+/* Queue a frame for the SD task, whole or not at all */
+static void telem_sd_put(const uint8_t * data, size_t len)
+{
+    uint32_t head = telem_sd_head;
+    uint32_t tail = __atomic_load_n(&telem_sd_tail,__ATOMIC_ACQUIRE);
+    if(len > TELEM_SD_RING - (head - tail))
+    {
+        telem_sd_dropped++;
+        return;
+    }
+    for(size_t i = 0; i < len; i++)
+    {
+        telem_sd_ring[(head + i) & (TELEM_SD_RING - 1)] = data[i];
+    }
+    __atomic_store_n(&telem_sd_head,head + len,__ATOMIC_RELEASE);
+}
+
+/* Encode a finished payload and write it to every sink */
+static void telem_send(uint8_t * payload, size_t len)
+{
+    frame_put_u16(&payload[1],telem_seq++);
+    size_t out = frame_encode(payload,len,telem_out);
+    if(!out)
+    {
+        LOG_ERROR("TELEM: Frame of %d bytes too large to send",(int)len);
+        return;
+    }
+    if(telem_binary)
+    {
+        fwrite(telem_out,1,out,stdout);
+    }
+    if(telem_sd)
+    {
+        telem_sd_put(telem_out,out);
+    }
+}
+
+/* Send the schema frame */
+static void telem_send_schema()
+{
+    uint8_t buf[FRAME_MAX_PAYLOAD];
+    uint8_t * p = telem_put_hdr(buf,TELEM_FRAME_SCHEMA);
+    *p++ = TELEM_VERSION;
+    p = frame_put_u16(p,(uint16_t)(dt*1000.0));
+    *p++ = TELEM_CH_COUNT;
+    for(int i = 0; i < TELEM_CH_COUNT; i++)
+    {
+        p = telem_put_f32(p,telem_ch_scale[i]);
+        const char * name = telem_ch_name[i];
+        do { *p++ = *name; } while(*name++);
+    }
+    telem_send(buf,p - buf);
+    telem_schema_last = millis();
+}
+
+/* Send the frame being built, if any */
+static void telem_flush()
+{
+    if(telem_blk_len)
+    {
+        telem_send(telem_blk,telem_blk_len);
+    }
+    telem_blk_len = 0;
+    telem_blk_ticks = 0;
+}
+
+/* Start a new recording on the SD card, numbered from an index file */
+static void telem_sd_open()
+{
+    if(!usd_is_installed())
+    {
+        LOG_INFO("TELEM: No SD card, not recording");
+        return;
+    }
+
+    int index = 0;
+    FILE * f = fopen("/usd/tlmidx.txt","r");
+    if(f)
+    {
+        if(fscanf(f,"%d",&index) != 1) index = 0;
+        fclose(f);
+    }
+    index++;
+    f = fopen("/usd/tlmidx.txt","w");
+    if(f)
+    {
+        fprintf(f,"%d\n",index);
+        fclose(f);
+    }
+
+    sprintf(telem_sd_name,"/usd/tlm%05d.bin",index);
+    telem_sd_file = fopen(telem_sd_name,"wb");
+    if(!telem_sd_file)
+    {
+        LOG_ERROR("TELEM: Error opening recording (%s)",telem_sd_name);
+        return;
+    }
+    LOG_ALWAYS("TELEM: Recording to %s",telem_sd_name);
+    telem_sd = true;
+}
+
+/* Writes the ring to the card, below the control task since the card can take tens of ms */
+static void telem_sd_task(void * param)
+{
+    uint32_t reopen = millis();
+    uint32_t dropped = 0;
+    while(telem_sd_file)
+    {
+        uint32_t head = __atomic_load_n(&telem_sd_head,__ATOMIC_ACQUIRE);
+        uint32_t tail = telem_sd_tail;
+        while(tail != head)
+        {
+            /* Up to the end of the ring at a time */
+            uint32_t at = tail & (TELEM_SD_RING - 1);
+            uint32_t len = head - tail;
+            if(len > TELEM_SD_RING - at) len = TELEM_SD_RING - at;
+            fwrite(&telem_sd_ring[at],1,len,telem_sd_file);
+            tail += len;
+        }
+        __atomic_store_n(&telem_sd_tail,tail,__ATOMIC_RELEASE);
+
+        if(telem_sd_dropped != dropped)
+        {
+            LOG_WARN("TELEM: SD recording fell behind, %d frames dropped",(int)(telem_sd_dropped - dropped));
+            dropped = telem_sd_dropped;
+        }
+
+        /* Close and reopen the recording so everything so far is committed to the card */
+        if(millis() - reopen >= TELEM_SD_REOPEN)
+        {
+            reopen = millis();
+            fclose(telem_sd_file);
+            telem_sd_file = fopen(telem_sd_name,"ab");
+            if(!telem_sd_file)
+            {
+                LOG_ERROR("TELEM: Error reopening recording (%s), recording stopped",telem_sd_name);
+                telem_sd = false;
+            }
+        }
+        delay(TELEM_SD_PERIOD);
+    }
+}
+
+/* Enable or disable the binary serial stream */
+void telem_set_binary(bool enable)
+{
+    if(enable == telem_binary)
+    {
+        return;
+    }
+    LOG_ALWAYS("TELEM: Binary stream %s",enable ? "enabled" : "disabled");
+
+    /* Our own framing replaces the PROS stream multiplexer while binary is on,
+     * so the receiver sees raw frames on the port. Text printed by the log is
+     * discarded by the receiver since it never passes the frame CRC.
+     */
+    telem_flush();
+    fflush(stdout);
+    serctl(enable ? SERCTL_DISABLE_COBS : SERCTL_ENABLE_COBS,NULL);
+    telem_binary = enable;
+    if(enable)
+    {
+        /* New listener needs a schema and a keyframe */
+        pack_reset(&telem_pack);
+        telem_send_schema();
+    }
+}
+
+bool telem_get_binary()
+{
+    return telem_binary;
+}
+
+/* Initialize telemetry */
+void telem_init()
+{
+    LOG_DEBUG("TELEM: Init");
+    pack_reset(&telem_pack);
+    if(TELEM_SD_DEFAULT)
+    {
+        telem_sd_open();
+    }
+    if(telem_sd && !task_create(telem_sd_task,NULL,TASK_PRIORITY_DEFAULT-1,TASK_STACK_DEPTH_DEFAULT,"tlmsd"))
+    {
+        LOG_ERROR("TELEM: Unable to start SD task, not recording");
+        fclose(telem_sd_file);
+        telem_sd_file = NULL;
+        telem_sd = false;
+    }
+    telem_set_binary(TELEM_BINARY_DEFAULT);
+    if(telem_sd && !telem_binary)
+    {
+        telem_send_schema();
+    }
+}
+
+/* Add a motor's sample to this tick */
+void telem_sample(uint8_t idx, bool powered, int32_t target)
+{
+    if(!telem_active() || telem_nrecs >= NUM_MOTORS)
+    {
+        return;
+    }
+
+    /* Quantize to the channel scales */
+    motor_t * mine = &motors[idx];
+    telem_rec_t * rec = &telem_recs[telem_nrecs++];
+    rec->idx = idx;
+    rec->flags = powered ? TELEM_FLAG_POWERED : 0;
+    rec->ch[TELEM_CH_TARGET] = target;
+    rec->ch[TELEM_CH_SPEED] = (int32_t)lround(mine->data.speed * 10.0);
+    rec->ch[TELEM_CH_CURR] = (int32_t)lround(mine->data.curr * 1000.0);
+    rec->ch[TELEM_CH_VOLT] = (int32_t)lround(mine->data.volt * 1000.0);
+    rec->ch[TELEM_CH_POWER] = (int32_t)lround(mine->data.power * 100.0);
+    rec->ch[TELEM_CH_TEMP] = (int32_t)lround(mine->data.temp * 10.0);
+}
+
+/* Send an event frame immediately */
+void telem_event(uint8_t idx, telem_event_t ev, float a, float b, float c)
+{
+    if(!telem_active())
+    {
+        return;
+    }
+
+    uint8_t buf[TELEM_HDR_SIZE + 14];
+    uint8_t * p = telem_put_hdr(buf,TELEM_FRAME_EVENT);
+    *p++ = idx;
+    *p++ = ev;
+    p = telem_put_f32(p,a);
+    p = telem_put_f32(p,b);
+    p = telem_put_f32(p,c);
+    telem_send(buf,p - buf);
+}
+
+/* End of a control tick, add this tick's samples to the stream */
+void telem_tick()
+{
+    if(!telem_active())
+    {
+        telem_nrecs = 0;
+        return;
+    }
+
+    bool key = !(telem_ticks % TELEM_KEY_TICKS);
+    if(key)
+    {
+        telem_flush();
+    }
+
+    if(telem_nrecs)
+    {
+#if TELEM_PACK
+        /* Packed blocks hold several ticks, and a keyframe always starts a new block */
+        if(!telem_blk_len)
+        {
+            telem_blk_len = telem_put_hdr(telem_blk,TELEM_FRAME_PACKED) - telem_blk;
+        }
+        telem_blk_len += pack_tick(&telem_pack,&telem_blk[telem_blk_len],millis(),telem_recs,telem_nrecs,key);
+        telem_blk_ticks++;
+
+        /* Send once the block is old enough, the next tick is a keyframe, or the next tick might not fit */
+        if(telem_blk_ticks >= TELEM_PACK_TICKS ||
+           !((telem_ticks + 1) % TELEM_KEY_TICKS) ||
+           telem_blk_len + 6 + NUM_MOTORS * PACK_REC_MAX > FRAME_MAX_PAYLOAD)
+        {
+            telem_flush();
+        }
+#else
+        /* One raw frame per tick */
+        uint8_t * p = telem_put_hdr(telem_blk,TELEM_FRAME_SAMPLE);
+        for(int r = 0; r < telem_nrecs; r++)
+        {
+            *p++ = telem_recs[r].idx;
+            *p++ = telem_recs[r].flags;
+            for(int i = 0; i < TELEM_CH_COUNT; i++)
+            {
+                p = frame_put_u32(p,(uint32_t)telem_recs[r].ch[i]);
+            }
+        }
+        telem_blk_len = p - telem_blk;
+        telem_flush();
+#endif
+    }
+    telem_nrecs = 0;
+    telem_ticks++;
+
+    /* Periodic schema */
+    if(millis() - telem_schema_last >= TELEM_SCHEMA_PERIOD)
+    {
+        telem_send_schema();
+    }
+    if(telem_binary)
+    {
+        fflush(stdout);
+    }
+}
@@ -0,0 +1,204 @@
+/* Motor thermal model */
+#include "main.h"
+
+/* Use pal log, deferred since this runs every tick */
+#define LOG_LEVEL_FILE LOG_LEVEL_INFO
+#define LOG_DEFERRED
+#include "pal/log.h"
+
+#include "thermal.h"
+
+/* Model of one motor, control task only */
+typedef struct
+{
+    /* A sample has been seen */
+    bool seen;
+    /* Reported temperature, coolest reported (C) */
+    double reported;
+    double ambient;
+    /* Estimate (C) */
+    double est;
+    /* Filtered current squared (A^2) */
+    double load;
+    /* Fit, theta = {gain, 1/tau} with its covariance */
+    double theta[2];
+    double p[2][2];
+    /* Interval being collected: reported temperature at its start, sums of
+     * current squared and of the estimate above ambient, and its time (s)
+     */
+    double start;
+    double sum_i2;
+    double sum_rise;
+    double time;
+    /* A derate warning has been reported */
+    bool warned;
+} thermal_t;
+
+static thermal_t thermal[NUM_MOTORS];
+
+
+void thermal_reset(uint8_t idx)
+{
+    memset(&thermal[idx],0,sizeof(thermal[idx]));
+}
+
+/* Start from the defaults, uncertain enough for the first intervals to move them */
+static void thermal_start(thermal_t * th, double temp)
+{
+    th->seen = true;
+    th->reported = temp;
+    th->ambient = temp;
+    th->est = temp;
+    th->theta[0] = THERMAL_GAIN;
+    th->theta[1] = 1.0 / THERMAL_TAU;
+    th->p[0][0] = THERMAL_GAIN * THERMAL_GAIN * 10.0;
+    th->p[1][1] = 10.0 / (THERMAL_TAU * THERMAL_TAU);
+    th->p[0][1] = th->p[1][0] = 0.0;
+    th->start = temp;
+}
+
+/* One interval into the fit: the rate the reported temperature changed at,
+ * against the mean current squared and mean rise over ambient
+ */
+static void thermal_fit(uint8_t idx, thermal_t * th)
+{
+    double x[2] = {th->sum_i2 / th->time, -th->sum_rise / th->time};
+    double y = (th->reported - th->start) / th->time;
+
+    /* Gain k = P x / (lambda + x' P x) */
+    double px[2] = {th->p[0][0]*x[0] + th->p[0][1]*x[1], th->p[1][0]*x[0] + th->p[1][1]*x[1]};
+    double den = THERMAL_FORGET + x[0]*px[0] + x[1]*px[1];
+    double k[2] = {px[0] / den, px[1] / den};
+    double err = y - (th->theta[0]*x[0] + th->theta[1]*x[1]);
+    th->theta[0] += k[0] * err;
+    th->theta[1] += k[1] * err;
+
+    /* P = (P - k x' P) / lambda, x' P is px' since P is symmetric */
+    for(int i = 0; i < 2; i++)
+    {
+        for(int j = 0; j < 2; j++)
+        {
+            th->p[i][j] = (th->p[i][j] - k[i] * px[j]) / THERMAL_FORGET;
+        }
+    }
+
+    /* Keep the model physical, a fit through quantized readings can wander */
+    if(th->theta[0] < THERMAL_GAIN_MIN) th->theta[0] = THERMAL_GAIN_MIN;
+    if(th->theta[0] > THERMAL_GAIN_MAX) th->theta[0] = THERMAL_GAIN_MAX;
+    if(th->theta[1] < 1.0 / THERMAL_TAU_MAX) th->theta[1] = 1.0 / THERMAL_TAU_MAX;
+    if(th->theta[1] > 1.0 / THERMAL_TAU_MIN) th->theta[1] = 1.0 / THERMAL_TAU_MIN;
+
+    LOG_DEBUG("THERMAL %c: %f C est, gain %f K/A^2s, tau %f s, rise %f K/A^2",idx+'A',th->est,
+              th->theta[0],1.0 / th->theta[1],th->theta[0] / th->theta[1]);
+
+    th->start = th->reported;
+    th->sum_i2 = 0.0;
+    th->sum_rise = 0.0;
+    th->time = 0.0;
+}
+
+void thermal_sample(uint8_t idx)
+{
+    thermal_t * th = &thermal[idx];
+    motor_t * mine = &motors[idx];
+    double temp = mine->data.temp;
+    double i2 = mine->data.curr * mine->data.curr;
+    if(!th->seen)
+    {
+        thermal_start(th,temp);
+    }
+    th->reported = temp;
+    if(temp < th->ambient)
+    {
+        th->ambient = temp;
+    }
+
+    /* Step the model, then keep it inside the reported step */
+    th->est += dt * (th->theta[0] * i2 - th->theta[1] * (th->est - th->ambient));
+    if(th->est < temp) th->est = temp;
+    if(th->est > temp + THERMAL_STEP) th->est = temp + THERMAL_STEP;
+    th->load += (i2 - th->load) * dt / THERMAL_LOAD_TAU;
+
+    /* Collect the interval, fit once it is long enough */
+    th->sum_i2 += i2 * dt;
+    th->sum_rise += (th->est - th->ambient) * dt;
+    th->time += dt;
+    if(th->time >= THERMAL_FIT_TIME)
+    {
+        thermal_fit(idx,th);
+    }
+
+    /* Warn once while a derate is close */
+    double derate = thermal_derate_time(idx);
+    bool close = (derate >= 0.0 && derate < THERMAL_WARN_TIME);
+    if(close && !th->warned)
+    {
+        LOG_WARN("THERMAL %c: Derates in %f s at %f C",idx+'A',derate,th->est);
+        REPORT_EV(idx,REPORT_EV_INFO,"MTR %c: Derates in %d s, %d C",idx+'A',(int)derate,(int)th->est);
+    }
+    th->warned = close;
+}
+
+double thermal_temp(uint8_t idx)
+{
+    return thermal[idx].est;
+}
+
+double thermal_derate_time(uint8_t idx)
+{
+    const thermal_t * th = &thermal[idx];
+    if(th->est >= THERMAL_DERATE)
+    {
+        return 0.0;
+    }
+    /* Steady temperature at this load, it derates only if that is above the limit */
+    double tau = 1.0 / th->theta[1];
+    double steady = th->ambient + th->theta[0] * tau * th->load;
+    if(!th->seen || steady <= THERMAL_DERATE)
+    {
+        return THERMAL_NEVER;
+    }
+    return tau * log((steady - th->est) / (steady - THERMAL_DERATE));
+}
+
+double thermal_cool_time(uint8_t idx, double temp)
+{
+    const thermal_t * th = &thermal[idx];
+    if(th->est <= temp)
+    {
+        return 0.0;
+    }
+    if(temp <= th->ambient)
+    {
+        return THERMAL_NEVER;
+    }
+    return log((th->est - th->ambient) / (temp - th->ambient)) / th->theta[1];
+}
+
+double thermal_group_temp(uint8_t lead)
+{
+    const group_t * grp = &groups[lead];
+    double hottest = 0.0;
+    for(int m = 0; m < grp->count; m++)
+    {
+        double t = thermal_temp(grp->members[m]);
+        if(t > hottest) hottest = t;
+    }
+    return hottest;
+}
+
+double thermal_group_cool_time(uint8_t lead, double temp)
+{
+    const group_t * grp = &groups[lead];
+    double slowest = 0.0;
+    for(int m = 0; m < grp->count; m++)
+    {
+        double t = thermal_cool_time(grp->members[m],temp);
+        if(t < 0.0)
+        {
+            return THERMAL_NEVER;
+        }
+        if(t > slowest) slowest = t;
+    }
+    return slowest;
+}
@@ -0,0 +1,232 @@
+/* UI cost profiler */
+#include "main.h"
+
+/* Include pros api */
+#include "pros/apix.h"
+
+/* Use pal log */
+#define LOG_LEVEL_FILE LOG_LEVEL_INFO
+#include "pal/log.h"
+
+#include "uiprof.h"
+
+/* Totals since boot, differences give the stats for any window */
+typedef struct
+{
+    /* Refresh monitor, graphics task */
+    uint32_t frames;
+    uint32_t refr_ms;
+    uint32_t refr_px;
+    /* Control loop, control task */
+    uint32_t ticks;
+    uint32_t work_us;
+} uiprof_totals_t;
+
+static uiprof_totals_t uiprof_now;
+/* Window maximums, taken and cleared by the reader */
+static uint32_t uiprof_refr_max_ms = 0;
+static uint32_t uiprof_work_max_us = 0;
+static uint32_t uiprof_period_max_us = 0;
+static uint32_t uiprof_log_refr_max_ms = 0;
+static uint32_t uiprof_log_work_max_us = 0;
+static uint32_t uiprof_log_period_max_us = 0;
+
+/* Tabs */
+static lv_obj_t * uiprof_pages[UIPROF_MAX_TABS];
+static const char * uiprof_names[UIPROF_MAX_TABS];
+static int uiprof_ntabs = 0;
+
+/* Overlay */
+static lv_obj_t * uiprof_label = NULL;
+static lv_style_t uiprof_style;
+/* Overlay page, long press steps through them then hides the overlay */
+typedef enum
+{
+    UIPROF_PAGE_UI,
+    UIPROF_PAGE_SPANS,
+    UIPROF_PAGE_TASKS,
+    UIPROF_PAGE_COUNT,
+} uiprof_page_t;
+static uiprof_page_t uiprof_page = UIPROF_PAGE_UI;
+
+
+/* Called by LVGL after every refresh with its duration and the pixels redrawn */
+static void uiprof_monitor(uint32_t time_ms, uint32_t px)
+{
+    uiprof_now.frames++;
+    uiprof_now.refr_ms += time_ms;
+    uiprof_now.refr_px += px;
+    if(time_ms > uiprof_refr_max_ms) uiprof_refr_max_ms = time_ms;
+    if(time_ms > uiprof_log_refr_max_ms) uiprof_log_refr_max_ms = time_ms;
+#if PROF_ENABLE
+    prof_add(PROF_REFR,time_ms * 1000);
+#endif
+}
+
+void uiprof_ctrl(uint32_t work_us)
+{
+    static uint64_t last = 0;
+    uint64_t now = micros();
+    if(last)
+    {
+        uint32_t period = now - last;
+        if(period > __atomic_load_n(&uiprof_period_max_us,__ATOMIC_RELAXED)) __atomic_store_n(&uiprof_period_max_us,period,__ATOMIC_RELAXED);
+        if(period > __atomic_load_n(&uiprof_log_period_max_us,__ATOMIC_RELAXED)) __atomic_store_n(&uiprof_log_period_max_us,period,__ATOMIC_RELAXED);
+    }
+    last = now;
+    if(work_us > __atomic_load_n(&uiprof_work_max_us,__ATOMIC_RELAXED)) __atomic_store_n(&uiprof_work_max_us,work_us,__ATOMIC_RELAXED);
+    if(work_us > __atomic_load_n(&uiprof_log_work_max_us,__ATOMIC_RELAXED)) __atomic_store_n(&uiprof_log_work_max_us,work_us,__ATOMIC_RELAXED);
+    uiprof_now.ticks++;
+    uiprof_now.work_us += work_us;
+}
+
+void uiprof_tree(lv_obj_t * obj, uint32_t * count, uint32_t * bytes)
+{
+    /* Objects are allocated from the LVGL heap, so both carry a size header */
+    (*count)++;
+    *bytes += lv_mem_get_size(obj) + lv_mem_get_size(lv_obj_get_ext_attr(obj));
+    lv_obj_t * child = NULL;
+    while((child = lv_obj_get_child(obj,child)))
+    {
+        uiprof_tree(child,count,bytes);
+    }
+}
+
+/* Format the stats between two totals into text */
+static void uiprof_format(char * out, size_t size, const uiprof_totals_t * now, const uiprof_totals_t * then, uint32_t ms,
+                          uint32_t refr_max, uint32_t work_max, uint32_t period_max, bool tabs)
+{
+    uint32_t frames = now->frames - then->frames;
+    uint32_t refr = now->refr_ms - then->refr_ms;
+    uint32_t px = now->refr_px - then->refr_px;
+    uint32_t ticks = now->ticks - then->ticks;
+    uint32_t work = now->work_us - then->work_us;
+    if(!ms) ms = 1;
+
+    int o = snprintf(out,size,"UI %d fps, refr %d ms avg %d max, %d%% CPU, %d px/frame (%d%% screen)\n"
+                              "CTRL %d ticks, work %d us avg %d max, period %d us max",
+                     (int)(frames * 1000 / ms),
+                     frames ? (int)(refr / frames) : 0,(int)refr_max,
+                     (int)(refr * 100 / ms),
+                     frames ? (int)(px / frames) : 0,frames ? (int)(px / frames * 100 / (LV_HOR_RES * LV_VER_RES)) : 0,
+                     (int)ticks,ticks ? (int)(work / ticks) : 0,(int)work_max,(int)period_max);
+    if(!tabs)
+    {
+        return;
+    }
+    o += snprintf(&out[o],size - o,"\nWidgets");
+    for(int i = 0; i < uiprof_ntabs && o < (int)size; i++)
+    {
+        uint32_t count = 0, bytes = 0;
+        uiprof_tree(uiprof_pages[i],&count,&bytes);
+        o += snprintf(&out[o],size - o," %s %d (%d B)",uiprof_names[i],(int)count,(int)bytes);
+    }
+}
+
+/* Put the page on the overlay, text holds the UI stats */
+static void uiprof_show(char * text, size_t size)
+{
+    if(UIPROF_PAGE_SPANS == uiprof_page)
+    {
+        prof_format(text,size);
+    }
+    else if(UIPROF_PAGE_TASKS == uiprof_page)
+    {
+        taskmon_format(text,size);
+    }
+    lv_label_set_text(uiprof_label,text);
+    lv_obj_align(uiprof_label,NULL,LV_ALIGN_IN_BOTTOM_LEFT,0,0);
+}
+
+/* Runs in the graphics task */
+static void uiprof_task(void * param)
+{
+    static uiprof_totals_t last, log_last;
+    static uint32_t last_ms = 0, log_ms = 0;
+    uint32_t ms = millis();
+    uiprof_totals_t now = uiprof_now;
+    char text[512];
+
+    if(uiprof_label && !lv_obj_get_hidden(uiprof_label))
+    {
+        uiprof_format(text,sizeof(text),&now,&last,ms - last_ms,
+                      __atomic_exchange_n(&uiprof_refr_max_ms,0,__ATOMIC_RELAXED),
+                      __atomic_exchange_n(&uiprof_work_max_us,0,__ATOMIC_RELAXED),
+                      __atomic_exchange_n(&uiprof_period_max_us,0,__ATOMIC_RELAXED),true);
+        uiprof_show(text,sizeof(text));
+    }
+    last = now;
+    last_ms = ms;
+
+    if(ms - log_ms >= UIPROF_LOG_PERIOD)
+    {
+        uiprof_format(text,sizeof(text),&now,&log_last,ms - log_ms,
+                      __atomic_exchange_n(&uiprof_log_refr_max_ms,0,__ATOMIC_RELAXED),
+                      __atomic_exchange_n(&uiprof_log_work_max_us,0,__ATOMIC_RELAXED),
+                      __atomic_exchange_n(&uiprof_log_period_max_us,0,__ATOMIC_RELAXED),true);
+        /* One log line */
+        for(char * c = text; *c; c++)
+        {
+            if(*c == '\n') *c = ';';
+        }
+        LOG_INFO("UIPROF: %s",text);
+        log_last = now;
+        log_ms = ms;
+    }
+}
+
+void uiprof_set_tabs(lv_obj_t ** pages, const char ** names, int count)
+{
+    if(count > UIPROF_MAX_TABS) count = UIPROF_MAX_TABS;
+    for(int i = 0; i < count; i++)
+    {
+        uiprof_pages[i] = pages[i];
+        uiprof_names[i] = names[i];
+    }
+    uiprof_ntabs = count;
+}
+
+void uiprof_toggle()
+{
+    if(!uiprof_label)
+    {
+        /* Created on first use, on the top layer so it floats over every page */
+        lv_style_copy(&uiprof_style,&lv_style_plain);
+        uiprof_style.body.main_color = LV_COLOR_BLACK;
+        uiprof_style.body.grad_color = LV_COLOR_BLACK;
+        uiprof_style.body.opa = LV_OPA_70;
+        uiprof_style.body.padding.hor = 4;
+        uiprof_style.body.padding.ver = 4;
+        uiprof_style.text.color = LV_COLOR_WHITE;
+        uiprof_style.text.font = &lv_font_dejavu_10;
+
+        uiprof_label = lv_label_create(lv_layer_top(),NULL);
+        lv_label_set_body_draw(uiprof_label,true);
+        lv_obj_set_style(uiprof_label,&uiprof_style);
+        lv_label_set_text(uiprof_label,"UI profiler, first sample in 1 s");
+        lv_obj_align(uiprof_label,NULL,LV_ALIGN_IN_BOTTOM_LEFT,0,0);
+        return;
+    }
+    /* UI stats, spans, tasks, then hidden */
+    if(lv_obj_get_hidden(uiprof_label))
+    {
+        uiprof_page = UIPROF_PAGE_UI;
+        lv_obj_set_hidden(uiprof_label,false);
+    }
+    else if(++uiprof_page < UIPROF_PAGE_COUNT)
+    {
+        /* The spans and tasks are windowed already, show them now */
+        char text[512];
+        uiprof_show(text,sizeof(text));
+    }
+    else
+    {
+        lv_obj_set_hidden(uiprof_label,true);
+    }
+}
+
+void uiprof_init()
+{
+    lv_refr_set_monitor_cb(uiprof_monitor);
+    lv_task_create(uiprof_task,UIPROF_PERIOD,LV_TASK_PRIO_LOWEST,NULL);
+}
@@ -0,0 +1,83 @@
+/* View-model cache for LVGL widgets */
+#include "main.h"
+
+/* Include pros api */
+#include "pros/apix.h"
+
+/* Use pal log */
+#define LOG_LEVEL_FILE LOG_LEVEL_INFO
+#include "pal/log.h"
+
+#include <string.h>
+#include "view.h"
+
+view_stats_t view_stats;
+
+void view_bind(view_t * view, lv_obj_t * obj)
+{
+    view->obj = obj;
+    view->style = NULL;
+    /* Mark the cache empty, no real text starts with this byte */
+    view->text[0] = (char)0xFF;
+    view->text[1] = 0;
+}
+
+bool view_set_text(view_t * view, const char * text)
+{
+    if(!view->obj)
+    {
+        return false;
+    }
+    if(!strncmp(view->text,text,VIEW_TEXT_MAX))
+    {
+        view_stats.text_same++;
+        return false;
+    }
+    lv_label_set_text(view->obj,text);
+    strncpy(view->text,text,VIEW_TEXT_MAX - 1);
+    view->text[VIEW_TEXT_MAX - 1] = 0;
+    /* Text that didn't fit can't be compared next time */
+    if(strlen(text) >= VIEW_TEXT_MAX - 1)
+    {
+        view->text[0] = (char)0xFF;
+    }
+    view_stats.text_set++;
+    return true;
+}
+
+bool view_set_style(view_t * view, lv_style_t * style)
+{
+    if(!view->obj)
+    {
+        return false;
+    }
+    if(view->style == style)
+    {
+        view_stats.style_same++;
+        return false;
+    }
+    lv_obj_set_style(view->obj,style);
+    view->style = style;
+    view_stats.style_set++;
+    return true;
+}
+
+/* Log what the cache saved since the last report */
+static void view_stats_log(void * param)
+{
+    static view_stats_t last;
+    uint32_t set = view_stats.text_set + view_stats.style_set - last.text_set - last.style_set;
+    uint32_t same = view_stats.text_same + view_stats.style_same - last.text_same - last.style_same;
+    uint32_t coalesced = view_stats.coalesced - last.coalesced;
+    if(set || same || coalesced)
+    {
+        LOG_INFO("VIEW: %d updates, %d unchanged skipped, %d coalesced (invalidations saved %d%%)",
+                 (int)set,(int)same,(int)coalesced,(int)((same + coalesced) * 100 / (set + same + coalesced)));
+    }
+    last = view_stats;
+}
+
+void view_init()
+{
+    lv_task_create(view_stats_log,VIEW_STATS_PERIOD,LV_TASK_PRIO_LOWEST,NULL);
+}